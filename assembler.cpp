@@ -1,33 +1,76 @@
 #include <string.h>
 #include <iostream>
+#include <memory>
+#include <algorithm>
 #include "include/preprocesser.hpp"
 #include "include/two_pass.hpp"
+#include "include/linker.hpp"
+#include "include/pipeline.hpp"
+#include "include/tracer.hpp"
+#include "include/alloc_stats.hpp"
+#include "include/build_cache.hpp"
+#include "include/watcher.hpp"
+#include "include/simulator.hpp"
+#include "include/batch_runner.hpp"
+#include "include/language_server.hpp"
+#include "include/operation_supplier.hpp"
+#include "include/file_io.hpp"
+#include "include/object_archive.hpp"
+#include "include/binary_pre.hpp"
 
 using namespace std;
 
 int main(int argc, char *argv[]) {
     // Descrição do uso correto
     const string help = "\
-Forneça um dos dois tipos de compilação:\n\
+Forneça um dos tipos de compilação:\n\
 -p para preprocessar um arquivo .asm em um arquivo .pre\n\
 -o para montar um arquivo .pre em um arquivo .obj\n\
+-l para ligar módulos .obj (montados com BEGIN e END) em um arquivo _ligado.obj\n\
+-s para simular um arquivo .obj já ligado\n\
+-b para executar em paralelo as tarefas de um arquivo de tarefas, cada uma com uma linha \"programa.obj entradas [saídas esperadas]\"\n\
+-a para listar um arquivo de objetos .oar, extrair membros dele ou criá-lo a partir dos arquivos .obj seguintes\n\
 \n\
-Forneça também o caminho para o arquivo fonte\n\
+Forneça também o caminho para o arquivo fonte (ou os caminhos dos módulos, no modo -l)\n\
+Nos modos -s, -l e -b, um membro de um arquivo de objetos é indicado por arquivo.oar:membro.obj\n\
+Nos modos -p e -o, o caminho - lê o fonte da entrada padrão e escreve o resultado na saída padrão, e as mensagens vão para a saída de erros\n\
 \n\
 Outras opções:\n\
 \t--print: Imprime a estrutura do programa, como construída pelo módulo scanner\n\
 \t--verbose: Imprime descrições detalhadas da execução\n\
+\t--trace <arquivo>: Registra a linha do tempo dos estágios em um arquivo JSON, no formato de trace do Chrome\n\
+\t--analyze: Analisa o fluxo de controle e de dados, avisando sobre saltos para dados, código inalcançável, escritas em constantes e leituras de SPACE antes de qualquer escrita (modo -o)\n\
+\t--optimize: Aplica otimizações peephole ao código entre as passagens e relata as palavras economizadas (modo -o)\n\
+\t--strip: Remove o código inalcançável e os dados não referenciados antes da segunda passagem e relata as palavras removidas (modo -o)\n\
+\t--binary: Escreve o .pre já separado em linhas, em formato binário, que o montador lê sem escanear (modo -p)\n\
+\t--out-of-core: Monta mantendo em memória apenas a tabela de símbolos (modo -o)\n\
+\t--cache <diretório>: Reaproveita resultados de execuções anteriores com as mesmas entradas (modos -p e -o)\n\
+\t--cache-stats: Imprime os acertos e faltas acumulados no cache\n\
+\t--pipeline: Executa leitura, escaneamento e préprocessamento em threads paralelas (modos -p e -o)\n\
+\t--check: Apenas verifica o arquivo, sem gerar a saída. Termina com código 1 se houver erros (modos -p e -o)\n\
+\t--max-errors <N>: Interrompe a verificação assim que N erros forem encontrados (requer --check)\n\
+\t--diagnostic-memory <KiB>: Memória para os erros de cada etapa da montagem. Erros repetidos são resumidos, e os que excederem o limite apenas contados. Por padrão, 4096 (modos -o e -p)\n\
+\t--watch: Observa os arquivos fonte (um ou mais) e os recompila a cada alteração, mantendo o estado entre as compilações (modos -p e -o)\n\
+\t--map: Gera, junto ao .obj, um arquivo .map com os endereços dos rótulos e das linhas do .pre (modo -o)\n\
+\t--profile: Conta as execuções de cada instrução, os desvios de cada salto condicional e os acessos a cada dado, e imprime os pontos quentes (modo -s)\n\
+\t--jobs <N>: Quantidade de threads do modo -b. Por padrão, uma por núcleo\n\
+\t--max-steps <N>: Interrompe cada execução após N instruções (modos -s e -b)\n\
+\t--archive <arquivo.oar>: Monta um ou mais arquivos .pre e guarda os objetos em um arquivo de objetos, em vez de um .obj para cada (modo -o)\n\
+\t--extract <membro>: Extrai o membro, ao lado do arquivo de objetos. Pode ser repetida (modo -a)\n\
+\t--alloc-stats: Contabiliza as alocações de memória por estágio e por categoria de local de chamada, e imprime o relatório ao final\n\
+\t--alloc-budget <N>: Termina com código 1 se a média de alocações por linha do arquivo fonte passar de N (modos -p e -o)\n\
+\t--lsp: Inicia um servidor de linguagem (LSP) sobre a entrada e a saída padrão, no lugar de um tipo de compilação\n\
 ";
     // Ajuda os necessitados
     // string thing = string(argv[1]);
     // cout << argc << " " << argv[1] << "\n" << typeid(thing).name() << " " << typeid("help").name() << endl;
-    if (argc == 2 && (strcmp(argv[1], "help") || strcmp(argv[1], "--help") || strcmp(argv[1], "-h"))) {
+    if (argc == 2 && strcmp(argv[1], "--lsp") != 0 && (strcmp(argv[1], "help") || strcmp(argv[1], "--help") || strcmp(argv[1], "-h"))) {
         cout << "Bem vindo a este montador básico!\n" << help << endl;
         return 0;
     }
 
     // Garante que o uso foi correto
-    if (argc < 3 || argc > 5) {
+    if (argc < 3 && !(argc == 2 && strcmp(argv[1], "--lsp") == 0)) {
         cerr << "ERRO: Número de argumentos inválido.\n" << help << endl;
         return -1;
     }
@@ -40,16 +83,60 @@ Outras opções:\n\
     bool print = false;
     // Define se imprime descrições
     bool verbose = false;
+    // Define se os estágios executam em paralelo
+    bool pipeline = false;
+    // Define se a montagem executa a análise de fluxo
+    bool analyze = false;
+    // Define se a montagem executa o otimizador peephole
+    bool optimize = false;
+    // Define se a montagem remove os símbolos mortos
+    bool strip = false;
+    // Define se o préprocessamento escreve o .pre no formato binário
+    bool binary = false;
+    // Define se a montagem guarda as linhas em disco entre as passagens
+    bool out_of_core = false;
     // Define se ocorrerá montagem ou préprocessamento
     string mode = "";
-    // Guardará o caminho do arquivo fonte
-    string source_file_path = "";
+    // Guardará o caminho do arquivo de rastreamento, se solicitado
+    string trace_path = "";
+    // Guardará o diretório do cache, se solicitado
+    string cache_directory = "";
+    // Define se as estatísticas do cache serão impressas
+    bool cache_stats = false;
+    // Define se as alocações de memória são contabilizadas e relatadas
+    bool alloc_stats = false;
+    // Média máxima de alocações por linha do arquivo fonte, 0 para não verificar
+    double alloc_budget = 0;
+    // Define se o arquivo é apenas verificado
+    bool check = false;
+    // Quantidade de erros após a qual a verificação é interrompida, 0 para nunca interromper
+    size_t max_errors = 0;
+    // Memória para os diagnósticos de cada etapa da montagem, em bytes, 0 para o padrão
+    size_t diagnostic_budget = 0;
+    // Define se os arquivos são observados e recompilados a cada alteração
+    bool watch = false;
+    // Define se a montagem gera o mapa de símbolos
+    bool symbol_map = false;
+    // Define se a simulação coleta o perfil de execução
+    bool profile = false;
+    // Quantidade de threads do modo em lote, 0 para uma por núcleo
+    unsigned jobs = 0;
+    // Quantidade de instruções após a qual cada execução é interrompida, 0 para nunca interromper
+    uint64_t max_steps = 0;
+    // Define se o programa atua como servidor de linguagem
+    bool lsp = false;
+    // Guardará o caminho do arquivo de objetos a ser criado pela montagem, se solicitado
+    string archive_path = "";
+    // Guardará os membros a serem extraídos do arquivo de objetos
+    vector<string> extracted_members;
+    // Guardará os caminhos dos arquivos fonte
+    vector<string> source_file_paths;
 
     try {
         // Para cada argumento
-        for (const char* carg : args) {
+        for (size_t index = 0; index < args.size(); index++) {
             // Transforma em string
-            string arg = string(carg);
+            string arg = string(args[index]);
             // cout << arg << endl;
             
             if      (arg == "--print") {
@@ -60,27 +147,246 @@ Outras opções:\n\
                 verbose = true;
             }
 
-            else if (arg == "-p" || arg == "-o") {
+            else if      (arg == "--pipeline") {
+                pipeline = true;
+            }
+
+            else if      (arg == "--analyze") {
+                analyze = true;
+            }
+
+            else if      (arg == "--optimize") {
+                optimize = true;
+            }
+
+            else if      (arg == "--strip") {
+                strip = true;
+            }
+
+            else if      (arg == "--binary") {
+                binary = true;
+            }
+
+            else if      (arg == "--out-of-core") {
+                out_of_core = true;
+            }
+
+            else if      (arg == "--cache") {
+                // O próximo argumento é o diretório
+                if (++index == args.size()) throw "Diretório do cache não especificado.";
+                cache_directory = string(args[index]);
+            }
+
+            else if      (arg == "--cache-stats") {
+                cache_stats = true;
+            }
+
+            else if      (arg == "--alloc-stats") {
+                alloc_stats = true;
+            }
+
+            else if      (arg == "--alloc-budget") {
+                // O próximo argumento é a quantidade
+                if (++index == args.size()) throw "Limite de alocações por linha não especificado.";
+                try {
+                    const double limit = stod(string(args[index]));
+                    if (!(limit > 0)) throw invalid_argument(args[index]);
+                    alloc_budget = limit;
+                }
+                catch (logic_error &error) {
+                    throw "Limite de alocações por linha inválido.";
+                }
+            }
+
+            else if      (arg == "--check") {
+                check = true;
+            }
+
+            else if      (arg == "--watch") {
+                watch = true;
+            }
+
+            else if      (arg == "--lsp") {
+                lsp = true;
+            }
+
+            else if      (arg == "--map") {
+                symbol_map = true;
+            }
+
+            else if      (arg == "--profile") {
+                profile = true;
+            }
+
+            else if      (arg == "--jobs") {
+                // O próximo argumento é a quantidade
+                if (++index == args.size()) throw "Quantidade de threads não especificada.";
+                try {
+                    const int count = stoi(string(args[index]));
+                    if (count <= 0) throw invalid_argument(args[index]);
+                    jobs = count;
+                }
+                catch (logic_error &error) {
+                    throw "Quantidade de threads inválida.";
+                }
+            }
+
+            else if      (arg == "--max-steps") {
+                // O próximo argumento é a quantidade
+                if (++index == args.size()) throw "Quantidade máxima de instruções não especificada.";
+                try {
+                    const long long limit = stoll(string(args[index]));
+                    if (limit <= 0) throw invalid_argument(args[index]);
+                    max_steps = limit;
+                }
+                catch (logic_error &error) {
+                    throw "Quantidade máxima de instruções inválida.";
+                }
+            }
+
+            else if      (arg == "--max-errors") {
+                // O próximo argumento é a quantidade
+                if (++index == args.size()) throw "Quantidade máxima de erros não especificada.";
+                try {
+                    const int limit = stoi(string(args[index]));
+                    if (limit <= 0) throw invalid_argument(args[index]);
+                    max_errors = limit;
+                }
+                catch (logic_error &error) {
+                    throw "Quantidade máxima de erros inválida.";
+                }
+            }
+
+            else if      (arg == "--diagnostic-memory") {
+                // O próximo argumento é a quantidade, em KiB
+                if (++index == args.size()) throw "Memória para diagnósticos não especificada.";
+                try {
+                    const long long kibibytes = stoll(string(args[index]));
+                    if (kibibytes <= 0 || kibibytes > (1ll << 40)) throw invalid_argument(args[index]);
+                    diagnostic_budget = kibibytes * 1024;
+                }
+                catch (logic_error &error) {
+                    throw "Memória para diagnósticos inválida.";
+                }
+            }
+
+            else if      (arg == "--archive") {
+                // O próximo argumento é o caminho do arquivo de objetos
+                if (++index == args.size()) throw "Caminho do arquivo de objetos não especificado.";
+                archive_path = string(args[index]);
+            }
+
+            else if      (arg == "--extract") {
+                // O próximo argumento é o nome do membro
+                if (++index == args.size()) throw "Membro a extrair não especificado.";
+                extracted_members.push_back(string(args[index]));
+            }
+
+            else if      (arg == "--trace") {
+                // O próximo argumento é o caminho do arquivo
+                if (++index == args.size()) throw "Caminho do arquivo de rastreamento não especificado.";
+                trace_path = string(args[index]);
+            }
+
+            else if (arg == "-p" || arg == "-o" || arg == "-l" || arg == "-s" || arg == "-b" || arg == "-a") {
                 if (mode.empty()) mode = arg;
                 else throw "Argumentos inválidos.";
             }
 
-            else if (arg[0] != '-') {
-                if (source_file_path.empty()) source_file_path = arg;
-                else throw "Argumentos inválidos.";
+            else if (arg[0] != '-' || is_standard_stream(arg)) {
+                source_file_paths.push_back(arg);
             }
 
             else {
                 throw "Argumentos inválidos.";
             }
         }
+        // O servidor de linguagem recebe os documentos pelo protocolo
+        if (lsp) {
+            if (!mode.empty() || !source_file_paths.empty()) throw "A opção --lsp não recebe tipo de compilação nem arquivos.";
+        }
         // Se não tiver um modo ou caminho nos argumentos, erro
-        if (mode.empty()) {
+        else if (mode.empty()) {
             throw "Tipo de compilação não especificado.";
         }
-        if (source_file_path.empty()) {
+        // A otimização precisa do programa inteiro em memória
+        if (optimize && out_of_core) {
+            throw "As opções --optimize e --out-of-core são incompatíveis.";
+        }
+        // A análise de fluxo guarda todas as instruções até o fim da primeira passagem
+        if (analyze && out_of_core) {
+            throw "As opções --analyze e --out-of-core são incompatíveis.";
+        }
+        // Apenas a montagem direta tem a segunda passagem fora da memória. O préprocessamento e o pipeline guardam o programa inteiro
+        if (out_of_core && (mode != "-o" || pipeline)) {
+            throw "A opção --out-of-core requer o modo -o, e não se combina com --pipeline.";
+        }
+        // A remoção de símbolos mortos precisa de todas as referências antes da segunda passagem
+        if (strip && (mode != "-o" || check || out_of_core)) {
+            throw "A opção --strip requer o modo -o, e não se combina com --check ou --out-of-core.";
+        }
+        if (cache_stats && cache_directory.empty()) {
+            throw "A opção --cache-stats requer --cache.";
+        }
+        if (check && (mode == "-l" || pipeline || out_of_core || optimize || !cache_directory.empty())) {
+            throw "A opção --check não gera saída, e não se combina com -l, --pipeline, --out-of-core, --optimize ou --cache.";
+        }
+        if (watch && (mode == "-l" || check || pipeline || out_of_core || !cache_directory.empty())) {
+            throw "A opção --watch não se combina com -l, --check, --pipeline, --out-of-core ou --cache.";
+        }
+        if (symbol_map && (mode != "-o" || check || watch || out_of_core || !cache_directory.empty())) {
+            throw "A opção --map requer o modo -o, e não se combina com --check, --watch, --out-of-core ou --cache.";
+        }
+        if (profile && mode != "-s") {
+            throw "A opção --profile requer o modo -s.";
+        }
+        if (jobs > 0 && mode != "-b") {
+            throw "A opção --jobs requer o modo -b.";
+        }
+        if (max_steps > 0 && mode != "-s" && mode != "-b") {
+            throw "A opção --max-steps requer o modo -s ou -b.";
+        }
+        if ((mode == "-s" || mode == "-b") && (check || watch || pipeline || out_of_core || analyze || optimize || !cache_directory.empty())) {
+            throw "Os modos -s e -b não se combinam com opções de montagem.";
+        }
+        if (binary && (mode != "-p" || check || watch || pipeline)) {
+            throw "A opção --binary requer o modo -p, e não se combina com --check, --watch ou --pipeline.";
+        }
+        if (max_errors > 0 && !check) {
+            throw "A opção --max-errors requer --check.";
+        }
+        if (diagnostic_budget > 0 && ((mode != "-o" && mode != "-p") || watch)) {
+            throw "A opção --diagnostic-memory requer o modo -o ou -p, e não se combina com --watch.";
+        }
+        if (!archive_path.empty() && (mode != "-o" || check || watch || pipeline || out_of_core || symbol_map || !cache_directory.empty() ||
+            !has_extension(archive_path, ARCHIVE_EXTENSION))) {
+            throw "A opção --archive requer o modo -o e um caminho .oar, e não se combina com --check, --watch, --pipeline, --out-of-core, --map ou --cache.";
+        }
+        if (!extracted_members.empty() && (mode != "-a" || source_file_paths.size() > 1)) {
+            throw "A opção --extract requer o modo -a, sem arquivos .obj a arquivar.";
+        }
+        if (mode == "-a" && (check || watch || pipeline || out_of_core || analyze || optimize || symbol_map || !cache_directory.empty())) {
+            throw "O modo -a não se combina com opções de montagem.";
+        }
+        if (alloc_budget > 0 && ((mode != "-p" && mode != "-o") || watch || !archive_path.empty() ||
+            (!source_file_paths.empty() && is_standard_stream(source_file_paths[0])))) {
+            throw "A opção --alloc-budget requer o modo -p ou -o sobre um único arquivo, e não se combina com --watch, --archive ou o caminho -.";
+        }
+        if (source_file_paths.empty() && !lsp) {
             throw "Arquivo fonte não especificado.";
         }
+        if (mode == "-a" && !has_extension(source_file_paths[0], ARCHIVE_EXTENSION)) {
+            throw "O modo -a recebe primeiro o caminho do arquivo de objetos .oar.";
+        }
+        // Apenas a ligação e a observação recebem mais de um arquivo
+        if (mode != "-l" && mode != "-a" && !watch && archive_path.empty() && source_file_paths.size() > 1) {
+            throw "Argumentos inválidos.";
+        }
+        // As opções que dependem do caminho do arquivo, ou que o leem mais de uma vez, não servem para a entrada padrão
+        if (find_if(source_file_paths.begin(), source_file_paths.end(), is_standard_stream) != source_file_paths.end() &&
+            ((mode != "-p" && mode != "-o") || watch || pipeline || out_of_core || symbol_map || binary || !cache_directory.empty() || !archive_path.empty())) {
+            throw "O caminho - (entrada e saída padrão) requer o modo -p ou -o, e não se combina com --watch, --pipeline, --out-of-core, --map, --binary, --cache ou --archive.";
+        }
     }
     catch (char const* error) {
         cerr << __FILE__ << ":" << __LINE__ << "> ERRO: " << error << "\n" << help << endl;
@@ -91,19 +397,236 @@ Outras opções:\n\
         return -1;
     }
 
-    try {
-        if (mode == "-p") {
+    if (lsp) {
+        // Como o modo -o, o servidor lê o arquivo de instruções, e não inicia sem ele
+        try {
+            LanguageServer server(verbose);
+            return server.serve();
+        }
+        catch (exception &error) {
+            cerr << __FILE__ << ":" << __LINE__ << "> ERRO:\n" << error.what() << endl;
+            return -1;
+        }
+    }
+
+    if (!trace_path.empty()) {
+        Tracer::enable();
+        Tracer::name_thread("principal");
+    }
+
+    // Código de saída. A verificação e o modo em lote o utilizam para indicar erros
+    int status = 0;
+
+    // A contabilização começa depois da leitura dos argumentos, para medir apenas a compilação
+    if (alloc_stats || alloc_budget > 0) AllocStats::enable();
+
+    // Quando o resultado vai para a saída padrão, as demais mensagens vão para a saída de erros
+    streambuf *standard_output = nullptr;
+    if (!check && !source_file_paths.empty() && is_standard_stream(source_file_paths[0])) {
+        standard_output = cout.rdbuf(cerr.rdbuf());
+    }
+
+    // Executa a compilação solicitada
+    auto compile = [&]() {
+        if (watch) {
+            Watcher watcher(mode, verbose);
+            watcher.set_analysis(analyze);
+            watcher.set_optimization(optimize);
+            watcher.set_stripping(strip);
+            watcher.watch(source_file_paths);
+        }
+        else if (check && mode == "-p") {
             Preprocesser preprocesser(verbose);
-            preprocesser.preprocess(source_file_path, print);
+            preprocesser.set_max_errors(max_errors);
+            if (diagnostic_budget > 0) preprocesser.set_diagnostic_budget(diagnostic_budget);
+            preprocesser.check(source_file_paths[0], print);
+            cout << source_file_paths[0] << ": OK" << endl;
+        }
+        else if (check) {
+            TwoPassAlgorithm assembler(verbose);
+            assembler.set_analysis(analyze);
+            assembler.set_max_errors(max_errors);
+            if (diagnostic_budget > 0) assembler.set_diagnostic_budget(diagnostic_budget);
+            assembler.check(source_file_paths[0], print);
+            cout << source_file_paths[0] << ": OK" << endl;
+        }
+        else if (pipeline && mode != "-l") {
+            Pipeline stages(verbose);
+            stages.set_analysis(analyze);
+            stages.set_optimization(optimize);
+            stages.set_stripping(strip);
+            stages.set_symbol_map(symbol_map);
+            if (diagnostic_budget > 0) stages.set_diagnostic_budget(diagnostic_budget);
+            if (mode == "-p") stages.preprocess(source_file_paths[0], print);
+            else stages.assemble(source_file_paths[0], print);
+        }
+        else if (mode == "-p") {
+            Preprocesser preprocesser(verbose);
+            preprocesser.set_binary_output(binary);
+            if (diagnostic_budget > 0) preprocesser.set_diagnostic_budget(diagnostic_budget);
+            preprocesser.preprocess(source_file_paths[0], print);
+        }
+        else if (mode == "-o" && !archive_path.empty()) {
+            TwoPassAlgorithm assembler(verbose);
+            assembler.set_analysis(analyze);
+            assembler.set_optimization(optimize);
+            assembler.set_stripping(strip);
+            if (diagnostic_budget > 0) assembler.set_diagnostic_budget(diagnostic_budget);
+            // Os objetos ficam em memória até que todos sejam montados, e o arquivo é escrito de uma vez
+            ArchiveWriter writer;
+            string error_log = "";
+            for (const string &path : source_file_paths) {
+                try {
+                    writer.add(base_name(replace_extension(path, ".obj")), assembler.assemble_object(path, print));
+                }
+                catch (exception &error) {
+                    error_log += path + ":\n" + error.what() + "\n";
+                }
+            }
+            if (!error_log.empty()) {
+                throw MounterException(-1, "null", error_log.substr(0, error_log.length()-1));
+            }
+            writer.write(archive_path);
+            cout << archive_path << ": " << writer.size() << (writer.size() == 1 ? " membro" : " membros") << endl;
         }
         else if (mode == "-o") {
             TwoPassAlgorithm assembler(verbose);
-            assembler.assemble(source_file_path, print);
+            assembler.set_analysis(analyze);
+            assembler.set_optimization(optimize);
+            assembler.set_stripping(strip);
+            assembler.set_symbol_map(symbol_map);
+            if (diagnostic_budget > 0) assembler.set_diagnostic_budget(diagnostic_budget);
+            if (out_of_core) assembler.assemble_out_of_core(source_file_paths[0], print);
+            else assembler.assemble(source_file_paths[0], print);
+        }
+        else if (mode == "-l") {
+            Linker linker(verbose);
+            linker.link(source_file_paths, print);
+        }
+        else if (mode == "-s") {
+            Simulator simulator(OperationSupplier::supply_shared_tables(), verbose);
+            simulator.set_profiling(profile);
+            simulator.set_step_limit(max_steps);
+            const string &path = source_file_paths[0];
+            const vector<int> image = simulator.load(path);
+            auto report = [&]() {
+                if (profile) cout << simulator.profile_report(simulator.load_symbol_map(replace_extension(path, ".map")));
+            };
+            // Uma execução interrompida também tem o seu relatório, que é o caso de um laço sem fim parado por --max-steps
+            try {
+                simulator.run(image, cin, cout);
+            }
+            catch (...) {
+                report();
+                throw;
+            }
+            report();
+        }
+        else if (mode == "-b") {
+            BatchRunner runner(OperationSupplier::supply_shared_tables(), verbose);
+            runner.set_thread_count(jobs);
+            runner.set_step_limit(max_steps);
+            if (!runner.run(source_file_paths[0])) status = 1;
+        }
+        else if (mode == "-a" && source_file_paths.size() > 1) {
+            // Arquiva os objetos fornecidos, pelo nome do arquivo
+            ArchiveWriter writer;
+            for (size_t index = 1; index < source_file_paths.size(); index++) {
+                const string &path = source_file_paths[index];
+                if (!has_extension(path, ".obj")) {
+                    throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça arquivos .obj para o arquivo de objetos");
+                }
+                writer.add(base_name(path), read_input(path));
+            }
+            writer.write(source_file_paths[0]);
+            cout << source_file_paths[0] << ": " << writer.size() << (writer.size() == 1 ? " membro" : " membros") << endl;
+        }
+        else if (mode == "-a") {
+            ObjectArchive archive(source_file_paths[0]);
+            if (extracted_members.empty()) {
+                for (size_t member = 0; member < archive.size(); member++) {
+                    cout << archive.name(member) << "\t" << (archive.encoding(member) == ARCHIVE_WORDS ? "palavras" : "texto")
+                        << "\t" << archive.member_size(member) << " bytes" << endl;
+                }
+            }
+            // Os membros são extraídos ao lado do arquivo de objetos
+            const string directory = source_file_paths[0].substr(0, source_file_paths[0].length() - base_name(source_file_paths[0]).length());
+            for (const string &member : extracted_members) {
+                write_output(directory + member, archive.text(archive.find(member)));
+                if (verbose) cout << "[" << __FILE__ << "]> " << member << " -> " << directory + member << endl;
+            }
+        }
+    };
+
+    unique_ptr<BuildCache> cache;
+    try {
+        TraceScope trace(mode == "-p" ? "-p" : mode == "-o" ? "-o" : mode == "-l" ? "-l" : mode == "-s" ? "-s" : mode == "-b" ? "-b" : "-a");
+        if (cache_directory.empty() || mode == "-l" || mode == "-s" || mode == "-b" || mode == "-a") {
+            compile();
+        }
+        else {
+            cache.reset(new BuildCache(cache_directory, verbose));
+            const string source_path = source_file_paths[0];
+            const string output_path = replace_extension(source_path, mode == "-p" ? ".pre" : ".obj");
+            // As opções que mudam o arquivo gerado ou os diagnósticos fazem parte da chave
+            string options = "";
+            if (analyze) options += " --analyze";
+            if (optimize) options += " --optimize";
+            if (strip) options += " --strip";
+            if (binary) options += " --binary";
+            if (diagnostic_budget > 0) options += " --diagnostic-memory " + to_string(diagnostic_budget);
+            const string key = cache->key(source_path, mode, options);
+
+            // Em caso de acerto, o resultado guardado substitui a compilação
+            if (!cache->restore(key, output_path)) {
+                // O que a compilação escreve na saída de erros, como os avisos da análise, é guardado com o resultado
+                string messages = "";
+                try {
+                    StreamCapture capture(cerr, messages);
+                    compile();
+                }
+                catch (MounterException &error) {
+                    // Erros de montagem são determinísticos, então também são guardados
+                    cache->store_error(key, error.what(), messages);
+                    throw;
+                }
+                cache->store_output(key, output_path, messages);
+            }
+        }
+    }
+    catch (exception &error) {
+        cerr << __FILE__ << ":" << __LINE__ << "> ERRO:\n" << error.what() << endl;
+        // Em uma cadeia de comandos, a falha precisa ser visível para o comando seguinte
+        if (check || mode == "-b" || standard_output != nullptr || alloc_budget > 0) status = 1;
+    }
+
+    // As alocações do relatório e da verificação não são contabilizadas
+    AllocStats::disable();
+    if (alloc_stats) cout << AllocStats::report() << endl;
+    if (alloc_budget > 0 && status == 0) {
+        const string source = read_input(source_file_paths[0]);
+        // O .pre binário conta os seus registros de linha
+        const size_t lines = BinaryPre::is_binary(source.data(), source.length()) ? max<size_t>(1, BinaryPre(source_file_paths[0]).size()) :
+            max<size_t>(1, count(source.begin(), source.end(), '\n') + (!source.empty() && source.back() != '\n'));
+        const double per_line = (double) AllocStats::total_allocations() / lines;
+        cout << "Alocações por linha do fonte: " << per_line << " (limite " << alloc_budget << ")" << endl;
+        if (per_line > alloc_budget) {
+            cerr << __FILE__ << ":" << __LINE__ << "> ERRO:\nO limite de " << alloc_budget << " alocações por linha foi excedido: "
+                << AllocStats::total_allocations() << " alocações em " << lines << " linhas" << endl;
+            status = 1;
         }
     }
+
+    if (cache && cache_stats) cout << cache->statistics() << endl;
+
+    // Exporta o rastreamento mesmo se a execução falhar
+    try {
+        Tracer::dump(trace_path);
+    }
     catch (exception &error) {
         cerr << __FILE__ << ":" << __LINE__ << "> ERRO:\n" << error.what() << endl;
     }
 
-    return 0;
+    if (standard_output != nullptr) cout.rdbuf(standard_output);
+    return status;
 }
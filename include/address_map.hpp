@@ -0,0 +1,38 @@
+#ifndef __ADDRESS_MAP__
+#define __ADDRESS_MAP__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "scanner.hpp"
+
+// Endereços das linhas montadas pela primeira passagem, usados pelas transformações que removem linhas do programa
+// Localiza a linha de um endereço, remove as linhas marcadas e leva cada símbolo ao novo endereço da sua linha, ou da linha mantida seguinte
+class AddressMap {
+    // Tamanho de cada instrução. As demais operações são diretivas de dados, com o tamanho registrado na linha
+    std::map<std::string, int> sizes;
+    // Endereço de cada linha, do último measure
+    std::vector<int> address;
+    // Tamanho do programa medido
+    int total;
+
+    public:
+    // Recebe a tabela de instruções, da qual vêm os tamanhos
+    AddressMap(const std::map<std::string, int[2]>&);
+    // Tamanho de uma linha em palavras
+    int size_of(const asm_line&) const;
+    // Indica se a operação é uma instrução, e não uma diretiva de dados
+    bool is_instruction(const std::string&) const;
+    // Calcula os endereços atuais das linhas
+    void measure(const std::vector<asm_line>&);
+    // Endereço de cada linha e tamanho do programa medidos
+    const std::vector<int>& addresses() const;
+    int size() const;
+    // Última linha que começa no endereço, -1 se nenhuma. Busca nas linhas, já que SPACE N torna o programa maior que a quantidade de linhas
+    int line_at(int) const;
+    // Remove as linhas marcadas e reatribui os endereços dos símbolos não externos do programa medido. Retorna o novo tamanho do programa
+    int remove(std::vector<asm_line>&, const std::vector<bool>&, std::map<std::string, int>&, const std::set<std::string>&) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef __ALLOC_STATS__
+#define __ALLOC_STATS__
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+// Quantidade máxima de estágios e de categorias distintas. Os excedentes são contados na primeira posição
+#define ALLOC_SLOTS 64
+// Quantidade de categorias listadas no relatório
+#define ALLOC_REPORT_SITES 8
+
+// Contadores de um estágio ou de uma categoria. Atômicos, pois as threads do pipeline alocam ao mesmo tempo
+struct alloc_counters {
+    // Nome, sempre um literal, para que o registro não aloque memória
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> frees;
+    // Maior quantidade de memória viva, em todo o programa, observada em uma alocação do estágio
+    std::atomic<int64_t> peak;
+};
+
+// Contabiliza as alocações feitas pelos operadores globais new e delete, por estágio e por categoria de local de chamada
+// O estágio é o TraceScope mais interno da thread, e a categoria o AllocSite mais interno. Desativada, cada alocação custa apenas uma leitura atômica
+class AllocStats {
+    static std::atomic<bool> enabled;
+
+    public:
+    static bool is_enabled() {return enabled.load(std::memory_order_relaxed);}
+    // Ativa e desativa a contabilização. A memória viva continua sendo acompanhada apenas enquanto ativa
+    static void enable();
+    static void disable();
+    // Registra um estágio ou uma categoria pelo nome, retornando a sua posição
+    static int register_stage(const char*);
+    static int register_site(const char*);
+    // Torna o estágio ou a categoria atual da thread, retornando o anterior, que deve ser restaurado ao sair
+    static int enter_stage(int);
+    static int enter_site(int);
+    static void leave_stage(int);
+    static void leave_site(int);
+    // Contabiliza uma alocação ou liberação de um bloco, na thread atual
+    static void count_allocation(void*);
+    static void count_free(void*);
+    // Total de alocações desde a ativação
+    static uint64_t total_allocations();
+    // Relatório por estágio e das categorias com mais bytes alocados
+    static std::string report();
+};
+
+// Define a categoria das alocações feitas durante a sua vida, como um trecho de código suspeito de alocar demais
+class AllocSite {
+    int previous;
+
+    public:
+    AllocSite(int site) : previous(AllocStats::is_enabled() ? AllocStats::enter_site(site) : -1) {}
+    ~AllocSite() {
+        if (previous != -1) AllocStats::leave_site(previous);
+    }
+};
+
+// Categoriza as alocações do restante do bloco. O registro é feito uma única vez por local
+#define ALLOC_SITE(name) \
+    static const int alloc_site_id = AllocStats::register_site(name); \
+    AllocSite alloc_site(alloc_site_id)
+
+#endif
\ No newline at end of file
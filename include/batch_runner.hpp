@@ -0,0 +1,80 @@
+#ifndef __BATCH_RUNNER__
+#define __BATCH_RUNNER__
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "isa_tables.hpp"
+
+class Simulator;
+
+// Uma execução de um programa com um arquivo de entradas, descrita por uma linha do arquivo de tarefas
+struct batch_job {
+    std::string program;
+    std::string input;
+    // Arquivo com as saídas esperadas, vazio se a saída não é comparada
+    std::string expected;
+};
+
+// Situação final de uma tarefa
+enum job_status {JOB_PASSED, JOB_FAILED, JOB_ERROR, JOB_RAN};
+
+// Resultado de uma tarefa
+struct job_result {
+    job_status status;
+    // Diferença encontrada na saída, ou mensagem do erro de execução
+    std::string detail;
+    // Tempo de execução da tarefa, em milissegundos
+    double elapsed;
+};
+
+// Fila de tarefas de uma thread. A dona retira pelo fim, e as outras roubam pelo início
+struct worker_queue {
+    std::mutex lock;
+    std::deque<size_t> jobs;
+};
+
+// Executa em paralelo as tarefas de um arquivo de tarefas, em um pool de threads com roubo de tarefas
+// Cada programa é carregado uma única vez, e cada thread executa sobre a sua própria cópia da imagem de memória
+class BatchRunner {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Tabelas compartilhadas da arquitetura
+    const std::shared_ptr<const isa_tables> tables;
+    // Quantidade de threads
+    unsigned thread_count;
+    // Quantidade de instruções após a qual cada execução é interrompida, 0 para nunca interromper
+    uint64_t step_limit;
+    std::vector<batch_job> jobs;
+    std::vector<job_result> results;
+    // Imagens de memória dos programas, somente leitura, pelo caminho. Programas que falharam ao carregar guardam o erro
+    std::map<std::string, std::shared_ptr<const std::vector<int>>> images;
+    std::map<std::string, std::string> load_errors;
+    // Filas de tarefas, uma por thread
+    std::vector<std::unique_ptr<worker_queue>> queues;
+
+    // Lê o arquivo de tarefas. Os caminhos são relativos ao diretório dele
+    void read_jobs(std::string);
+    // Retira a próxima tarefa da própria fila ou rouba de outra. Retorna falso quando não há mais tarefas
+    bool next_job(unsigned, size_t&);
+    // Laço de uma thread do pool
+    void work(unsigned);
+    // Executa uma tarefa e guarda o resultado
+    void execute(size_t, Simulator&);
+
+    public:
+    // Define a quantidade de threads. 0 usa uma por núcleo
+    void set_thread_count(unsigned count) {thread_count = count;}
+    // Define a quantidade de instruções após a qual cada execução é interrompida
+    void set_step_limit(uint64_t limit) {step_limit = limit;}
+    // Executa as tarefas do arquivo e imprime o resumo. Retorna verdadeiro se nenhuma falhou
+    bool run(std::string);
+    // Construtor
+    BatchRunner(std::shared_ptr<const isa_tables>, bool verbose = false);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef __BINARY_PRE__
+#define __BINARY_PRE__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "scanner.hpp"
+#include "mapped_file.hpp"
+
+// Identificação do formato binário do .pre, no início do arquivo
+#define BINARY_PRE_MAGIC "PREBIN\0\0"
+// Versão do formato, que muda a cada alteração do cabeçalho ou dos registros
+#define BINARY_PRE_VERSION 1
+
+// Cabeçalho: identificação, tamanhos e posições das regiões, e a soma de verificação de tudo o que vem depois dele
+struct binary_pre_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t string_count;
+    uint64_t line_count;
+    uint64_t strings_offset;
+    uint64_t text_offset;
+    uint64_t text_size;
+    uint64_t lines_offset;
+    uint64_t checksum;
+};
+
+// Entrada da tabela de strings: posição e tamanho na região de texto. A string 0 é sempre a vazia
+struct binary_pre_string {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Registro de tamanho fixo de uma linha já separada, com as strings pelo seu índice na tabela
+// O número é a linha do .pre textual equivalente, para que os erros apontem o mesmo lugar
+struct binary_pre_line {
+    int32_t number;
+    int32_t label;
+    int32_t operation;
+    int32_t operand[2];
+    int32_t opcode;
+    int32_t span;
+};
+
+// Codifica as linhas escaneadas de um .pre no formato binário
+std::string encode_binary_pre(const std::vector<asm_line>&);
+
+// .pre binário mapeado em memória. As linhas são lidas direto dos registros, sem passar pelo scanner
+// O arquivo é inteiro validado na abertura, então a leitura das linhas não verifica mais nada
+class BinaryPre {
+    std::string path;
+    // Arquivo mapeado, com o cabeçalho e os registros de linha apontando para ele
+    MappedFile file;
+    const binary_pre_header* header;
+    const binary_pre_line* records;
+    // Strings da tabela, construídas uma única vez, e a classificação de cada uma como operando
+    std::vector<std::string> strings;
+    std::vector<literal> literals;
+
+    // Lança o erro de arquivo inválido
+    void corrupted(const std::string&) const;
+
+    public:
+    // Mapeia e valida o arquivo, lançando invalid_argument se ele não puder ser lido ou estiver corrompido
+    BinaryPre(const std::string&);
+    BinaryPre(const BinaryPre&) = delete;
+    BinaryPre& operator=(const BinaryPre&) = delete;
+    // Quantidade de linhas
+    size_t size() const {return header->line_count;}
+    // Adiciona ao vetor até a quantidade fornecida de linhas, a partir da primeira indicada
+    void read(size_t, size_t, std::vector<asm_line>&) const;
+    // Todas as linhas do programa
+    std::vector<asm_line> lines() const;
+    // Indica se o conteúdo começa com a identificação do formato binário
+    static bool is_binary(const char*, size_t);
+    // Indica se o arquivo está no formato binário. A entrada padrão é sempre textual
+    static bool is_binary(const std::string&);
+};
+
+#endif
\ No newline at end of file
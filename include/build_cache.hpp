@@ -0,0 +1,62 @@
+#ifndef __BUILD_CACHE__
+#define __BUILD_CACHE__
+
+#include <string>
+#include <ostream>
+#include <streambuf>
+
+// Enquanto existir, guarda uma cópia de tudo o que for escrito na stream, sem deixar de escrevê-lo
+class StreamCapture : public std::streambuf {
+    std::ostream &stream;
+    std::streambuf *original;
+    std::string &copy;
+
+    protected:
+    int overflow(int) override;
+    std::streamsize xsputn(const char*, std::streamsize) override;
+    int sync() override;
+
+    public:
+    StreamCapture(std::ostream&, std::string&);
+    ~StreamCapture();
+    StreamCapture(const StreamCapture&) = delete;
+    StreamCapture& operator=(const StreamCapture&) = delete;
+};
+
+// Cache em disco dos resultados de préprocessamento e montagem, compartilhado entre execuções
+// A chave é um hash do conteúdo do arquivo fonte e dos arquivos que ele inclui, do arquivo de instruções na montagem, da versão do montador, do modo e das opções
+// Guarda o arquivo gerado, ou a mensagem de erro se a compilação falhou, e as mensagens da compilação na saída de erros, como os avisos da análise
+class BuildCache {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Diretório do cache
+    const std::string directory;
+
+    // Caminho de uma entrada do cache
+    std::string entry_path(std::string, std::string);
+    // Copia um arquivo de forma atômica: escreve em um temporário ao lado do destino e o renomeia
+    void atomic_copy(std::string, std::string);
+    // Escreve um conteúdo em um arquivo de forma atômica
+    void atomic_write(std::string, const std::string&);
+    // Reproduz na saída de erros as mensagens guardadas para a chave, se houver
+    void replay_messages(std::string);
+    // Incrementa os contadores de acertos ou faltas no arquivo de estatísticas, com trava entre processos
+    void count(bool);
+
+    public:
+    // Calcula a chave para um arquivo fonte, o modo de compilação e as opções que mudam o resultado
+    std::string key(std::string, std::string, std::string);
+    // Tenta restaurar o resultado guardado para a chave no caminho de saída. Retorna verdadeiro em caso de acerto
+    // As mensagens guardadas são reproduzidas, e se o resultado guardado for um erro, ele é lançado novamente como MounterException
+    bool restore(std::string, std::string);
+    // Guarda o arquivo de saída gerado para a chave, e as mensagens da compilação
+    void store_output(std::string, std::string, const std::string&);
+    // Guarda a mensagem de erro gerada para a chave, e as mensagens da compilação
+    void store_error(std::string, std::string, const std::string&);
+    // Retorna uma descrição dos acertos e faltas acumulados
+    std::string statistics();
+    // Construtor. Cria o diretório se ele não existir
+    BuildCache(std::string, bool verbose = false);
+};
+
+#endif
\ No newline at end of file
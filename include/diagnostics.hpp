@@ -0,0 +1,78 @@
+#ifndef __DIAGNOSTICS__
+#define __DIAGNOSTICS__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "mounter_exception.hpp"
+
+// Quantidade de ocorrências de um mesmo erro que são relatadas com a linha exata
+#define DIAGNOSTIC_OCCURRENCES 5
+// Memória padrão para os diagnósticos de uma montagem, em bytes
+#define DIAGNOSTIC_BUDGET (4 << 20)
+
+// Um erro ou aviso reportado pelo montador
+struct diagnostic {
+    // Linha no texto fonte, -1 se o diagnóstico não se refere a uma linha
+    int line;
+    // Tipo: léxico, sintático, semântico, ou null para falhas gerais
+    std::string type;
+    std::string message;
+    // Arquivo incluído em que o diagnóstico ocorreu, vazio se foi no próprio texto fonte
+    std::string file = "";
+};
+
+// Acrescenta os diagnósticos ao log, no formato de error_log.hpp, com o rótulo fornecido: erro ou aviso
+void append_log(std::string&, const std::vector<diagnostic>&, const std::string &label = "erro");
+
+// Ocorrências de um mesmo erro: mesmo tipo, mesma mensagem e mesmo arquivo
+struct diagnostic_group {
+    std::string type;
+    std::string message;
+    // Arquivo incluído em que as ocorrências estão, vazio se foi no próprio texto fonte
+    std::string file;
+    // Linhas das primeiras ocorrências, -1 para erros sem linha
+    std::vector<int> lines;
+    // Ordem de chegada de cada ocorrência guardada, entre todos os erros do coletor
+    std::vector<size_t> arrivals;
+    // Total de ocorrências, inclusive as que não tiveram a linha guardada
+    size_t count;
+};
+
+// Coleta erros agrupados por tipo, mensagem e arquivo, guardando a linha das primeiras ocorrências e contando as demais
+// A memória é limitada: depois de esgotada, novos erros são apenas contados
+class Diagnostics {
+    // Quantidade de ocorrências guardadas por grupo
+    size_t occurrence_limit;
+    // Memória disponível e utilizada, em bytes, contando o log que será gerado
+    size_t budget;
+    size_t used;
+    // Grupos em ordem da primeira ocorrência, e o índice de cada um pela chave tipo e mensagem
+    std::vector<diagnostic_group> groups;
+    std::unordered_map<std::string, size_t> group_index;
+    // Total de erros recebidos, e quantos foram descartados por falta de memória
+    size_t total;
+    size_t dropped;
+
+    public:
+    Diagnostics(size_t occurrences = DIAGNOSTIC_OCCURRENCES, size_t budget = DIAGNOSTIC_BUDGET);
+    // Registra um erro
+    void add(int, const std::string&, const std::string&);
+    void add(const MounterException &error) {add(error.get_line(), error.get_type(), error.what());}
+    // Registra um erro que pode ter ocorrido em um arquivo incluído
+    void add(const diagnostic&);
+    // Quantidade de erros recebidos, inclusive os agrupados e os descartados
+    size_t size() const {return total;}
+    bool empty() const {return total == 0;}
+    // Remove e retorna o grupo do erro fornecido. O grupo retornado tem contagem 0 se não houver ocorrências
+    diagnostic_group extract(const std::string&, const std::string&);
+    // Descarta os erros, mantendo os limites
+    void clear();
+    // Acrescenta os erros à lista, em ordem de linha. Erros sem linha vão ao final, em ordem de chegada
+    // As ocorrências omitidas de um grupo são resumidas em uma linha de continuação da mensagem da sua última ocorrência relatada
+    void append_to(std::vector<diagnostic>&) const;
+    // Como o anterior, mas acrescenta os erros ao log, no formato de error_log.hpp
+    void append_to(std::string&) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef __ERROR_LOG__
+#define __ERROR_LOG__
+
+#include <string>
+
+// Os logs de erro são strings com uma entrada por erro, no formato "Na linha N, erro tipo: mensagem" ou "Erro tipo: mensagem"
+// Erros de arquivos incluídos apontam o arquivo: "Na linha N de caminho, erro tipo: mensagem"
+// Uma mensagem pode continuar nas linhas seguintes
+
+// Indica se a linha do log, a partir da posição fornecida, inicia uma nova entrada
+inline bool starts_log_entry(const std::string &log, size_t position) {
+    return log.compare(position, 9, "Na linha ") == 0 || log.compare(position, 5, "Erro ") == 0;
+}
+
+// Conta as entradas de um log de erros
+inline size_t count_log_entries(const std::string &log) {
+    size_t count = 0;
+    for (size_t position = 0; position < log.length(); position = log.find('\n', position) + 1) {
+        if (starts_log_entry(log, position)) count++;
+        if (log.find('\n', position) == std::string::npos) break;
+    }
+    return count;
+}
+
+// Mantém apenas as primeiras entradas do log
+inline void truncate_log(std::string &log, size_t limit) {
+    size_t count = 0;
+    for (size_t position = 0; position < log.length(); position = log.find('\n', position) + 1) {
+        if (starts_log_entry(log, position) && ++count > limit) {
+            log.erase(position);
+            return;
+        }
+        if (log.find('\n', position) == std::string::npos) return;
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef __FILE_IO__
+#define __FILE_IO__
+
+#include <string>
+
+// Caminho que representa a entrada padrão, como fonte, e a saída padrão, como destino
+#define STANDARD_STREAM "-"
+// Tamanho de cada leitura da entrada padrão e de cada escrita na saída padrão, em bytes
+#define STANDARD_STREAM_BLOCK (1 << 20)
+
+// Indica se o caminho representa a entrada ou a saída padrão
+inline bool is_standard_stream(const std::string &path) {return path == STANDARD_STREAM;}
+// Posição do ponto que inicia a extensão: o último '.' depois da última '/'. npos se não houver extensão
+size_t extension_start(const std::string&);
+// Indica se o caminho termina com a extensão fornecida, como ".asm"
+bool has_extension(const std::string&, const std::string&);
+// Nome do arquivo, sem os diretórios do caminho
+std::string base_name(const std::string&);
+// Troca a extensão do caminho pelo sufixo fornecido, como ".pre" ou "_ligado.obj". A entrada padrão resulta na saída padrão
+std::string replace_extension(const std::string&, const std::string&);
+// Lê um arquivo inteiro, ou a entrada padrão até o fim, em blocos grandes
+std::string read_input(const std::string&);
+// Escreve o texto em um arquivo, ou na saída padrão, em blocos grandes
+void write_output(const std::string&, const std::string&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef __FLOW_ANALYZER__
+#define __FLOW_ANALYZER__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "scanner.hpp"
+
+// Instrução registrada durante a primeira passagem
+struct flow_instruction {
+    // Linha no arquivo fonte
+    int line;
+    int address;
+    std::string operation;
+    std::string operand[2];
+};
+
+// Palavra ou bloco da seção de dados registrado durante a primeira passagem
+struct flow_data_word {
+    // Linha no arquivo fonte
+    int line;
+    int address;
+    // Indica se foi declarada por CONST
+    bool constant;
+    // Quantidade de palavras, maior que um em SPACE N
+    int span;
+};
+
+// Tamanho máximo, em bits, dos conjuntos da análise de fluxo de dados: um bit por bloco básico e por SPACE lido e escrito
+// Acima dele, as leituras de SPACEs escritos em algum lugar não são verificadas
+#define FLOW_DATAFLOW_BITS (1 << 28)
+
+// Constrói o grafo de fluxo de controle do programa a partir das instruções da primeira passagem e aponta avisos semânticos:
+// saltos para a seção de dados, código inalcançável, escritas em constantes e leituras de SPACE nunca escritos ou lidos antes de serem escritos em algum caminho
+// A análise parte da primeira instrução e dos símbolos públicos. O grafo é construído em tempo linear, e o fluxo de dados opera sobre blocos básicos, com conjuntos de bits
+class FlowAnalyzer {
+    // Instruções, em ordem de endereço
+    std::vector<flow_instruction> instructions;
+    // Palavras de dados, em ordem de endereço
+    std::vector<flow_data_word> data;
+
+    public:
+    // Registra uma instrução. Deve ser chamado em ordem de endereço
+    void add_instruction(const asm_line&, int);
+    // Registra uma palavra ou bloco de dados, depois de executada a diretiva. Deve ser chamado em ordem de endereço
+    void add_data(const asm_line&, int);
+    // Descarta os registros, mantendo a memória alocada
+    void clear() {instructions.clear(); data.clear();}
+    // Executa a análise, dada a tabela de símbolos completa, o tamanho do programa e os símbolos públicos e externos do módulo. Retorna os avisos encontrados
+    std::vector<MounterException> analyze(const std::map<std::string, int>&, int, const std::map<std::string, int>&, const std::set<std::string>&);
+};
+
+#endif
\ No newline at end of file
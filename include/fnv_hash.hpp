@@ -0,0 +1,15 @@
+#ifndef __FNV_HASH__
+#define __FNV_HASH__
+
+#include <cstdint>
+#include <cstddef>
+
+// Valor inicial do hash FNV-1a de 64 bits
+#define FNV_OFFSET 14695981039346656037ULL
+
+// Acumula os bytes no hash FNV-1a de 64 bits, que começa em FNV_OFFSET. Usado nas chaves do cache de montagem e nas somas de verificação dos formatos binários
+void hash_bytes(uint64_t&, const char*, size_t);
+// Hash FNV-1a de 64 bits de um bloco de bytes
+uint64_t fnv_hash(const char*, size_t);
+
+#endif
\ No newline at end of file
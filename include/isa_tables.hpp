@@ -0,0 +1,25 @@
+#ifndef __ISA_TABLES__
+#define __ISA_TABLES__
+
+#include <map>
+#include <string>
+#include <vector>
+#include "scanner.hpp"
+
+class Preprocesser;
+class TwoPassAlgorithm;
+
+// Tabelas da arquitetura: instruções e diretivas com suas rotinas
+// São imutáveis depois de fornecidas, então uma mesma instância é compartilhada por todos os préprocessadores e montadores, inclusive entre threads
+struct isa_tables {
+    // Dicionário das definições de instruções, de instrução para opcode e tamanho
+    std::map<std::string, int[2]> instruction_table;
+    // Dicionário de diretivas para suas rotinas
+    std::map<std::string, void(*)(std::vector<asm_line>::iterator&, int&)> directive_table;
+    // Dicionário de diretivas de préprocessamento para suas rotinas
+    std::map<std::string, void(*)(std::vector<asm_line>::iterator&, Preprocesser*)> pre_directive_table;
+    // Dicionário de diretivas de ligação para suas rotinas
+    std::map<std::string, void(*)(std::vector<asm_line>::iterator&, TwoPassAlgorithm*)> link_directive_table;
+};
+
+#endif
\ No newline at end of file
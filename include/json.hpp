@@ -0,0 +1,32 @@
+#ifndef __JSON__
+#define __JSON__
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Valor JSON mínimo, suficiente para as mensagens do servidor de linguagem
+struct json_value {
+    enum kind_type {NULL_VALUE, BOOLEAN_VALUE, NUMBER_VALUE, STRING_VALUE, ARRAY_VALUE, OBJECT_VALUE};
+    kind_type kind = NULL_VALUE;
+    bool boolean = false;
+    double number = 0;
+    std::string text;
+    std::vector<json_value> items;
+    std::map<std::string, json_value> members;
+
+    // Acessa um membro de um objeto. Membros ausentes, ou valores que não são objetos, resultam em null
+    const json_value& operator[](const std::string&) const;
+    bool is_null() const {return kind == NULL_VALUE;}
+    int as_int() const {return (int) number;}
+    // Reescreve o valor como texto JSON
+    std::string dump() const;
+};
+
+// Lê um texto JSON, levantando invalid_argument se ele for malformado
+json_value parse_json(const std::string&);
+
+// Escreve uma string como literal JSON, com as aspas e os escapes
+std::string json_quote(const std::string&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#ifndef __LANGUAGE_SERVER__
+#define __LANGUAGE_SERVER__
+
+#include <map>
+#include <set>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "scanner.hpp"
+#include "preprocesser.hpp"
+#include "two_pass.hpp"
+#include "library.hpp"
+#include "json.hpp"
+
+// Quantidade de linhas distintas guardadas no cache de separação antes de ele ser descartado
+#define LSP_CACHE_LIMIT 262144
+// Quantidade de linhas de um bloco do documento. Uma edição divide em blocos desse tamanho os trechos com mais que o dobro
+#define LSP_CHUNK_LINES 256
+// Tempo sem mensagens, em milissegundos, após o qual a análise completa é refeita
+#define LSP_IDLE_MS 200
+
+// Linha de um documento aberto. O resultado da separação é guardado até que a linha seja editada
+struct document_line {
+    std::string text;
+    // Indica se a linha já foi separada desde a última edição
+    bool scanned = false;
+    // Indica se a linha tem uma operação, guardada em tokens
+    bool has_operation = false;
+    asm_line tokens;
+    // Rótulo de uma linha que tem apenas rótulo, aplicado à próxima operação
+    std::string stray_label;
+    // Erros encontrados na separação
+    std::vector<diagnostic> errors;
+    // Indica que a linha declara um rótulo quando já há outro pendente para a mesma operação
+    bool label_conflict = false;
+    // Erros e avisos da linha na última análise completa, descartados quando a separação da linha muda
+    std::vector<diagnostic> analysis_errors;
+    std::vector<diagnostic> analysis_warnings;
+};
+
+// Trecho contíguo de um documento, com o índice de símbolos das suas linhas
+struct document_chunk {
+    std::vector<document_line> lines;
+    // Indica se todas as linhas do bloco já foram separadas
+    bool scanned = false;
+    // Indica se o índice e a contagem de linhas com diagnósticos estão em dia
+    bool indexed = false;
+    // Posição no bloco da primeira definição e das referências de cada rótulo
+    std::unordered_map<std::string, int> definitions;
+    std::unordered_map<std::string, std::vector<int>> references;
+    // Quantidade de linhas do bloco com diagnósticos
+    size_t diagnosed = 0;
+};
+
+// Documento aberto no editor
+struct open_document {
+    // Caminho local, a partir do qual os INCLUDEs são resolvidos
+    std::string path;
+    // Linhas em blocos. Uma edição só move as linhas dos blocos que alcança
+    std::vector<document_chunk> chunks;
+    size_t line_count = 0;
+    // Indica que o documento mudou desde a última publicação de diagnósticos
+    bool dirty = true;
+    // Indica que linhas foram inseridas ou removidas desde a última atualização
+    bool reshaped = true;
+    // Indica que a análise completa não viu as últimas mudanças
+    bool stale = true;
+    // Erros e avisos da análise completa que não se referem a uma linha do documento
+    std::vector<diagnostic> errors;
+    std::vector<diagnostic> warnings;
+    // Arquivos incluídos com diagnósticos publicados, que são limpos quando deixam de ter erros
+    std::set<std::string> included_uris;
+};
+
+// Servidor de linguagem (LSP) sobre stdin e stdout
+// Mantém os documentos abertos em blocos de linhas. Uma edição invalida apenas as linhas que alterou, e apenas elas passam pelo scanner de novo
+// A cada edição, o índice de símbolos, os erros de separação e o pareamento de rótulos pendentes são refeitos só nos blocos e linhas alcançados
+// Os diagnósticos do préprocessador e do montador dependem do programa inteiro: sinônimos, tabela de símbolos e análise de fluxo
+// Eles são refeitos pela análise completa, com os mesmos préprocessador e montador do modo em lote, quando o editor fica LSP_IDLE_MS sem enviar mensagens
+// Até lá, as linhas não editadas mantêm os diagnósticos da análise anterior
+class LanguageServer {
+    // Define se descrções serão impressas, na saída de erros
+    const bool verbose;
+    // Tabelas compartilhadas da arquitetura
+    const std::shared_ptr<const isa_tables> tables;
+    // Contextos reaproveitados entre as análises
+    Preprocesser preprocesser;
+    TwoPassAlgorithm assembler;
+    // Resultados da separação de linhas já vistas
+    line_scan_cache line_cache;
+    // Documentos abertos, pela URI
+    std::map<std::string, open_document> documents;
+    // Bytes recebidos e ainda não consumidos
+    std::string input;
+    // Indica que o cliente pediu o encerramento
+    bool shutdown_requested;
+
+    // Lê a próxima mensagem, esperando por ela. Retorna falso no fim da entrada
+    bool read_message(std::string&);
+    // Indica se há uma mensagem recebida ou chegando, esperando por ela até o tempo fornecido, em milissegundos
+    // Com uma mensagem pendente, a análise é adiada para juntar edições seguidas
+    bool input_pending(int milliseconds = 0);
+    // Envia uma mensagem, com o cabeçalho
+    void send(const std::string&);
+    void respond(const json_value&, const std::string&);
+    void respond_error(const json_value&, int, const std::string&);
+    // Trata uma mensagem. Retorna falso quando o cliente pede a saída
+    bool handle(const json_value&);
+    // Substitui um trecho do documento. Sem intervalo, substitui o documento inteiro
+    void edit(open_document&, const json_value&, const std::string&);
+    // Separa as linhas editadas, refaz o pareamento de rótulos e o índice dos blocos alcançados, e publica os diagnósticos
+    void update(const std::string&, open_document&);
+    // Refaz o préprocessamento e a montagem do documento inteiro, e publica os diagnósticos
+    void analyze(const std::string&, open_document&);
+    // Publica os diagnósticos de um arquivo, já no formato JSON, ou os de um documento aberto
+    void publish(const std::string&, const std::string&);
+    void publish(const std::string&, const open_document&);
+    // Retorna o documento da URI, com o índice em dia, ou nullptr se ele não estiver aberto
+    open_document* current_document(const std::string&);
+    // Locais de um rótulo nas linhas fornecidas, como um vetor JSON
+    std::string locations(const std::string&, const open_document&, const std::string&, const std::vector<int>&);
+
+    public:
+    // Atende o cliente até que ele peça a saída. Retorna o código de saída
+    int serve();
+    // Construtor
+    LanguageServer(bool verbose = false);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef __LIBRARY__
+#define __LIBRARY__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include "isa_tables.hpp"
+#include "diagnostics.hpp"
+
+// Resultado do préprocessamento de um texto .asm
+struct preprocess_result {
+    bool success;
+    // Texto .pre, vazio se houve erros
+    std::string text;
+    std::vector<diagnostic> errors;
+};
+
+// Resultado da montagem de um texto .pre
+struct assembly_result {
+    bool success;
+    // Conteúdo do arquivo objeto, com o cabeçalho no caso de módulos
+    std::string object;
+    // Palavras do código montado
+    std::vector<int> words;
+    std::vector<diagnostic> errors;
+    // Avisos da análise de fluxo, que não impedem a montagem
+    std::vector<diagnostic> warnings;
+    // Relatório do otimizador peephole, vazio se ele não foi ativado
+    std::string optimization_report;
+};
+
+// Interface do montador para uso como biblioteca: recebe textos e retorna os resultados em memória
+// Não acessa o sistema de arquivos nem imprime nada. Os métodos são constantes, e podem ser chamados por várias threads ao mesmo tempo sobre a mesma instância
+class InMemoryAssembler {
+    // Tabelas da arquitetura, compartilhadas pelas montagens
+    std::shared_ptr<const isa_tables> tables;
+
+    public:
+    // Préprocessa um texto .asm. A diretiva INCLUDE, que leria arquivos, é rejeitada com um erro semântico
+    preprocess_result preprocess(const std::string&) const;
+    // Monta um texto .pre. Recebe opções de análise de fluxo e de otimização
+    assembly_result assemble(const std::string&, bool analysis = false, bool optimization = false) const;
+    // Préprocessa e monta um texto .asm
+    assembly_result build(const std::string&, bool analysis = false, bool optimization = false) const;
+    // Construtor, com as instruções fornecidas no formato do arquivo data/instructions.txt
+    // A biblioteca não lê o arquivo, então quem a usa fornece o seu conteúdo, que continua sendo a única definição das instruções
+    InMemoryAssembler(const std::string&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef __LINKER__
+#define __LINKER__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "mounter_exception.hpp"
+
+// Representa um módulo objeto relocável, como gerado pelo montador a partir de um programa com BEGIN e END
+struct object_module {
+    // Caminho do arquivo de origem
+    std::string path;
+    // Nome do módulo
+    std::string name;
+    // Tamanho do módulo em palavras
+    int size;
+    // Mapa de bits de relocação, um caractere '0' ou '1' por palavra
+    std::string relocation;
+    // Tabela de definições: símbolo público e seu endereço relativo
+    std::vector<std::pair<std::string, int>> definition_table;
+    // Tabela de uso: símbolo externo e o endereço relativo onde é utilizado
+    std::vector<std::pair<std::string, int>> use_table;
+    // Código do módulo
+    std::vector<int> code;
+};
+
+// Responsável por combinar módulos objeto relocáveis em um único arquivo executável
+class Linker {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Tabela global de definições, de símbolo para endereço absoluto
+    std::unordered_map<std::string, int> global_definition_table;
+
+    // Lê um arquivo objeto e retorna o módulo descrito nele
+    object_module read_module(std::string);
+
+    public:
+    // Recebe os arquivos objeto dos módulos, na ordem em que devem ser carregados, e cria um único arquivo .OBJ executável
+    void link(std::vector<std::string>, bool print = false);
+    // Construtor
+    Linker(bool verbose = false) : verbose(verbose) {}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef __LITERAL__
+#define __LITERAL__
+
+#include <string>
+
+// Classificação de um operando quanto a ser um literal numérico
+enum literal_kind {
+    // Não começa como um número, então é um rótulo
+    NOT_LITERAL,
+    // Número decimal, hexadecimal (0x) ou binário (0b) válido
+    VALID_LITERAL,
+    // Começa como um número, mas tem caracteres inválidos para a sua base
+    MALFORMED_LITERAL,
+    // Número válido que não cabe em um int
+    OVERFLOWING_LITERAL
+};
+
+// Operando classificado, com o valor já convertido quando for um literal válido
+struct literal {
+    literal_kind kind;
+    int value;
+};
+
+// Classifica e converte um operando, sem lançar exceções. Aceita um sinal - e os prefixos 0x e 0b, em qualquer caixa
+literal parse_literal(const std::string&);
+
+// Descreve o problema de um literal malformado ou fora do intervalo, para as mensagens de erro
+std::string describe_literal_error(const std::string&, const literal&);
+
+#endif
\ No newline at end of file
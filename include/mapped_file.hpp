@@ -0,0 +1,23 @@
+#ifndef __MAPPED_FILE__
+#define __MAPPED_FILE__
+
+#include <string>
+
+// Arquivo inteiro mapeado em memória somente para leitura, desmapeado na destruição
+// Um arquivo vazio não é mapeado: o conteúdo fica nulo, com tamanho zero
+class MappedFile {
+    const char* mapping;
+    size_t mapping_size;
+
+    public:
+    // Mapeia o arquivo, lançando invalid_argument se ele não puder ser aberto ou mapeado. Recebe se a leitura será sequencial
+    MappedFile(const std::string&, bool = false);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    // Início e tamanho do conteúdo
+    const char* data() const {return mapping;}
+    size_t size() const {return mapping_size;}
+};
+
+#endif
\ No newline at end of file
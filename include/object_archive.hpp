@@ -0,0 +1,107 @@
+#ifndef __OBJECT_ARCHIVE__
+#define __OBJECT_ARCHIVE__
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "mapped_file.hpp"
+
+// Extensão dos arquivos de objetos
+#define ARCHIVE_EXTENSION ".oar"
+// Separa o caminho do arquivo de objetos do nome do membro, como em "programas.oar:soma.obj"
+#define ARCHIVE_MEMBER_SEPARATOR ':'
+// Identificação do formato, no início do arquivo
+#define ARCHIVE_MAGIC "OBJARQ\0\0"
+// Versão do formato. Lida na ordem de bytes da máquina, também denuncia arquivos gerados em máquinas de outra ordem
+#define ARCHIVE_VERSION 2
+// Menor sequência de zeros guardada como bloco, e não como palavras literais
+#define ARCHIVE_ZERO_RUN 4
+
+// Codificação do conteúdo de um membro
+enum archive_encoding : uint32_t {
+    // Texto .obj, como escrito pelo montador. Usado pelos módulos, cujo cabeçalho precisa do ligador
+    ARCHIVE_TEXT = 0,
+    // Palavras de 32 bits em blocos, copiadas direto para a imagem de memória. As sequências de zeros, como as de SPACE N, ocupam só o bloco
+    ARCHIVE_WORDS = 1
+};
+
+// Cabeçalho do arquivo: identificação, quantidade de membros e posições do índice e dos nomes
+struct archive_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t index_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+};
+
+// Entrada do índice, ordenado pelo nome. O nome fica na região de nomes, e o conteúdo, alinhado a 8 bytes, depois dela
+struct archive_entry {
+    uint64_t name_offset;
+    uint32_t name_size;
+    uint32_t encoding;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Bloco de um membro em palavras: a quantidade de palavras literais que seguem o bloco, e a de zeros depois delas
+struct archive_block {
+    uint32_t literal_count;
+    uint32_t zero_count;
+};
+
+// Indica se o caminho aponta um membro de um arquivo de objetos, e o separa no caminho do arquivo e no nome do membro
+bool split_archive_path(const std::string&, std::string&, std::string&);
+
+// Monta um arquivo de objetos em memória e o escreve de uma vez
+class ArchiveWriter {
+    struct pending_member {
+        std::string name;
+        archive_encoding encoding;
+        std::string content;
+    };
+    std::vector<pending_member> members;
+
+    public:
+    // Adiciona um membro a partir do texto .obj. Programas já ligados são guardados como palavras, e módulos como texto
+    void add(const std::string&, const std::string&);
+    // Quantidade de membros adicionados
+    size_t size() const {return members.size();}
+    // Ordena o índice e escreve o arquivo. Nomes repetidos são um erro
+    void write(const std::string&);
+};
+
+// Arquivo de objetos mapeado em memória, com busca de membros pelo nome em O(log n)
+class ObjectArchive {
+    std::string path;
+    // Arquivo mapeado, com o cabeçalho e o índice apontando para ele
+    MappedFile file;
+    const archive_header* header;
+    const archive_entry* index;
+
+    // Levanta erro de arquivo corrompido
+    void corrupted(const std::string&) const;
+    // Expande os blocos de um membro em palavras, verificando os limites de cada um
+    std::vector<int> expand(size_t) const;
+
+    public:
+    // Mapeia o arquivo e valida o cabeçalho e o índice
+    ObjectArchive(const std::string&);
+    ObjectArchive(const ObjectArchive&) = delete;
+    ObjectArchive& operator=(const ObjectArchive&) = delete;
+
+    // Quantidade de membros
+    size_t size() const {return header->count;}
+    // Nome, codificação e tamanho em bytes do membro na posição fornecida do índice
+    std::string name(size_t) const;
+    archive_encoding encoding(size_t member) const {return (archive_encoding) index[member].encoding;}
+    uint64_t member_size(size_t member) const {return index[member].size;}
+    // Posição do membro no índice, por busca binária. Lança erro se não existir
+    size_t find(const std::string&) const;
+    // Conteúdo de um membro como texto .obj
+    std::string text(size_t) const;
+    // Palavras de um membro. Membros em texto são convertidos, e módulos são rejeitados
+    std::vector<int> words(size_t) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef __OBJECT_READER__
+#define __OBJECT_READER__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "isa_tables.hpp"
+
+// Leitor de arquivos .obj já ligados: mapeia o arquivo em memória e converte a sequência de palavras em uma imagem plana de inteiros de 32 bits
+// A conversão processa blocos de 64 bytes com SSE2 quando disponível, e byte a byte no restante
+class ObjectReader {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Tamanho de cada opcode, 0 para opcodes inexistentes
+    std::vector<int> sizes;
+    // Comportamento de cada opcode no fluxo: se salta e se continua na instrução seguinte
+    std::vector<bool> jumps;
+    std::vector<bool> falls_through;
+
+    public:
+    // Recebe as tabelas da arquitetura, contra as quais os opcodes são validados
+    ObjectReader(std::shared_ptr<const isa_tables>, bool verbose = false);
+    // Converte as palavras decimais do intervalo, separadas por espaços em branco, e as acrescenta à imagem
+    static void parse_words(const char*, const char*, std::vector<int>&);
+    // Certifica de que toda instrução alcançável a partir do endereço 0 tenha um opcode válido e caiba no programa
+    void validate(const std::vector<int>&);
+    // Lê e valida um arquivo .obj, retornando a sua imagem de memória
+    std::vector<int> read(std::string);
+};
+
+#endif
\ No newline at end of file
@@ -3,29 +3,63 @@
 
 #include <map>
 #include <vector>
+#include <memory>
 #include "scanner.hpp"
 #include "preprocesser.hpp"
+#include "isa_tables.hpp"
+
+class TwoPassAlgorithm;
 
 class OperationSupplier {
     // DIRETIVAS PRÉPROCESSAMENTO
     // Executa a diretiva EQU
     static void eval_EQU(std::vector<asm_line>::iterator&, Preprocesser*);
+    // Avalia a condição de uma diretiva IF ou IFBLOCK, cujo nome é usado nas mensagens de erro
+    static int eval_condition(const asm_line&, Preprocesser*, const std::string&);
     // Executa a diretiva IF
     static void eval_IF(std::vector<asm_line>::iterator&, Preprocesser*);
+    // Executa a diretiva IFBLOCK
+    static void eval_IFBLOCK(std::vector<asm_line>::iterator&, Preprocesser*);
+    // Executa a diretiva ELSE
+    static void eval_ELSE(std::vector<asm_line>::iterator&, Preprocesser*);
+    // Executa a diretiva ENDIF
+    static void eval_ENDIF(std::vector<asm_line>::iterator&, Preprocesser*);
+    // Executa a diretiva INCLUDE
+    static void eval_INCLUDE(std::vector<asm_line>::iterator&, Preprocesser*);
 
     // DIRETIVAS
     // Executa a diretiva SPACE
     static void eval_SPACE(std::vector<asm_line>::iterator&, int&);
     // Executa a diretiva CONST
     static void eval_CONST(std::vector<asm_line>::iterator&, int&);
+
+    // DIRETIVAS DE LIGAÇÃO
+    // Executa a diretiva BEGIN
+    static void eval_BEGIN(std::vector<asm_line>::iterator&, TwoPassAlgorithm*);
+    // Executa a diretiva END
+    static void eval_END(std::vector<asm_line>::iterator&, TwoPassAlgorithm*);
+    // Executa a diretiva PUBLIC
+    static void eval_PUBLIC(std::vector<asm_line>::iterator&, TwoPassAlgorithm*);
+    // Executa a diretiva EXTERN
+    static void eval_EXTERN(std::vector<asm_line>::iterator&, TwoPassAlgorithm*);
     
     public:
     // Fornece as instruções e seus opcodes, como registrado no arquivo instructions
     auto supply_instructions() -> std::map<std::string, int[2]>;
+    // Fornece as instruções lidas de uma stream no formato do arquivo instructions
+    auto supply_instructions(std::istream&) -> std::map<std::string, int[2]>;
     // Fornece as diretivas e suas rotinas, como especificado no arquivo cpp
     auto supply_directives() -> std::map<std::string, void(*)(std::vector<asm_line>::iterator&, int&)>;
     // Fornece as diretivas de préprocessamento e suas rotinas, como especificado no arquivo cpp
     auto supply_pre_directives() -> std::map<std::string, void(*)(std::vector<asm_line>::iterator&, Preprocesser*)>;
+    // Fornece as diretivas de ligação e suas rotinas, como especificado no arquivo cpp
+    auto supply_link_directives() -> std::map<std::string, void(*)(std::vector<asm_line>::iterator&, TwoPassAlgorithm*)>;
+    // Fornece um novo conjunto de tabelas com as instruções recebidas e todas as diretivas
+    auto supply_tables(const std::map<std::string, int[2]>&) -> std::shared_ptr<const isa_tables>;
+    // Fornece as tabelas do arquivo instructions, carregadas uma única vez por processo
+    static auto supply_shared_tables() -> std::shared_ptr<const isa_tables>;
+    // Fornece as tabelas sem instruções, criadas uma única vez por processo. O préprocessador usa apenas as diretivas, e não depende do arquivo instructions
+    static auto supply_preprocessing_tables() -> std::shared_ptr<const isa_tables>;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef __PEEPHOLE__
+#define __PEEPHOLE__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "scanner.hpp"
+#include "address_map.hpp"
+
+// Visão do otimizador sobre uma instrução e a instrução seguinte, usada pelas regras
+struct peephole_window {
+    std::vector<asm_line> &lines;
+    // Índices da instrução atual e da seguinte, -1 se não houver seguinte
+    int current;
+    int next;
+    // Endereços das linhas antes da otimização
+    const AddressMap &addresses;
+    // Indica se há um rótulo apontando para o endereço de cada linha
+    const std::vector<bool> &is_target;
+    const std::map<std::string, int> &symbol_table;
+    const std::set<std::string> &extern_symbols;
+    // Linhas marcadas para remoção
+    std::vector<bool> &removed;
+
+    // Endereço de um operando rótulo, -1 se não for um rótulo local
+    int resolve(const std::string&) const;
+    // Primeira linha mantida a partir do endereço, -1 se nenhuma
+    int line_from(int) const;
+};
+
+// Regra do otimizador. A função aplica a regra à janela se ela casar, e retorna se houve alteração
+struct peephole_rule {
+    const char* description;
+    bool (*apply)(peephole_window&);
+};
+
+// Otimizador peephole: aplica uma tabela de regras locais ao fluxo de instruções montado pela primeira passagem
+// Remove ou redireciona instruções, recalcula os endereços e atualiza a tabela de símbolos, preservando os destinos dos rótulos
+class PeepholeOptimizer {
+    // Endereços das linhas, e tamanhos das instruções
+    AddressMap addresses;
+    // Quantas vezes cada regra foi aplicada
+    std::map<std::string, int> applications;
+
+    // Uma rodada de aplicação das regras sobre o programa. Retorna se houve alteração
+    bool optimize_round(std::vector<asm_line>&, std::map<std::string, int>&, const std::set<std::string>&);
+
+    public:
+    // Recebe a tabela de instruções, da qual vêm os tamanhos
+    PeepholeOptimizer(const std::map<std::string, int[2]>&);
+    // Otimiza o programa até que nenhuma regra se aplique. Retorna a quantidade de palavras economizadas
+    int optimize(std::vector<asm_line>&, std::map<std::string, int>&, const std::set<std::string>&);
+    // Descreve quantas vezes cada regra foi aplicada
+    std::string report();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef __PIPELINE__
+#define __PIPELINE__
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <exception>
+#include "scanner.hpp"
+#include "spsc_queue.hpp"
+
+// Lote de linhas brutas lidas do arquivo fonte
+struct raw_batch {
+    // Número da primeira linha do lote no arquivo fonte
+    int first_line;
+    std::vector<std::string> lines;
+};
+
+// Lote de linhas já escaneadas, com os erros encontrados nelas
+struct line_batch {
+    std::vector<asm_line> lines;
+    std::vector<diagnostic> errors;
+};
+
+// Lote de texto preprocessado, com os erros encontrados nele
+struct text_batch {
+    std::string text;
+    std::vector<diagnostic> errors;
+};
+
+// Executa os estágios de leitura, escaneamento e préprocessamento em threads separadas, ligadas por filas limitadas
+class Pipeline {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Quantidade de linhas por lote
+    const size_t batch_size;
+    // Quantidade máxima de lotes em cada fila
+    const size_t queue_capacity;
+    // Define se a montagem executa a análise de fluxo
+    bool analysis;
+    // Define se a montagem executa o otimizador peephole
+    bool optimization;
+    // Define se a montagem remove os símbolos mortos
+    bool stripping;
+    // Define se a montagem gera o mapa de símbolos
+    bool symbol_map;
+    // Memória, em bytes, para os erros agrupados. Os lotes levam os seus erros até a thread principal, que os agrupa
+    size_t diagnostic_budget;
+
+    // Estágio de leitura: lê o arquivo em lotes de linhas brutas
+    // Uma exceção é guardada no último parâmetro, e a fila de saída é fechada mesmo assim
+    void read_stage(std::fstream&, SPSCQueue<raw_batch>&, std::exception_ptr&);
+    // Estágio de escaneamento: separa as linhas em elementos, mantendo os rótulos pendentes entre lotes
+    // Uma exceção é guardada no último parâmetro, e a fila de entrada é drenada para não bloquear a leitura
+    void scan_stage(bool, SPSCQueue<raw_batch>&, SPSCQueue<line_batch>&, std::exception_ptr&);
+    // Imprime a ocupação de uma fila entre dois estágios
+    void report(std::string, const queue_stats&);
+
+    public:
+    // Recebe um arquivo e cria um novo arquivo .PRE, com o código preprocessado
+    void preprocess(std::string, bool print = false);
+    // Recebe um arquivo e cria um novo arquivo .OBJ, com o código montado
+    void assemble(std::string, bool print = false);
+    // Construtor
+    Pipeline(bool verbose = false, size_t batch_size = 1024, size_t queue_capacity = 16) :
+        verbose(verbose),
+        batch_size(batch_size),
+        queue_capacity(queue_capacity),
+        analysis(false),
+        optimization(false),
+        stripping(false),
+        symbol_map(false),
+        diagnostic_budget(DIAGNOSTIC_BUDGET)
+        {}
+    // Ativa ou desativa a análise de fluxo na montagem
+    void set_analysis(bool enabled) {analysis = enabled;}
+    // Ativa ou desativa o otimizador peephole na montagem
+    void set_optimization(bool enabled) {optimization = enabled;}
+    // Ativa ou desativa a remoção de símbolos mortos na montagem
+    void set_stripping(bool enabled) {stripping = enabled;}
+    // Ativa ou desativa a geração do mapa de símbolos na montagem
+    void set_symbol_map(bool enabled) {symbol_map = enabled;}
+    // Define a memória, em bytes, para os erros do préprocessamento e da montagem. O padrão é DIAGNOSTIC_BUDGET
+    void set_diagnostic_budget(size_t budget) {diagnostic_budget = budget;}
+};
+
+#endif
\ No newline at end of file
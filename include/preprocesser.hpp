@@ -6,28 +6,144 @@
 #include <fstream>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
 #include "scanner.hpp"
+#include "isa_tables.hpp"
+
+// Bloco condicional IFBLOCK/ELSE/ENDIF, identificado pelas linhas de suas diretivas no arquivo fonte
+struct conditional_block {
+    // Linha do ELSE, -1 se não houver
+    int else_line;
+    int endif_line;
+};
+
+// Resultado do préprocessamento de um arquivo incluído, guardado para ser reaproveitado por todas as inclusões seguintes do processo
+// O arquivo é préprocessado isoladamente, com uma tabela de sinônimos própria, então o resultado não depende de quem o inclui
+struct included_file {
+    // Arquivos dos quais o resultado depende, o próprio e os que ele inclui, com suas datas de modificação
+    std::vector<std::pair<std::string, long long>> dependencies;
+    // Linhas préprocessadas
+    std::string text;
+    // Tabela de sinônimos resultante
+    std::map<std::string, int> synonym_table;
+    // Erros encontrados, já atribuídos aos arquivos em que ocorreram
+    std::vector<diagnostic> errors;
+};
 
 class Preprocesser {
     // Define se descrções serão impressas
     const bool verbose;
+    // Tabelas compartilhadas da arquitetura
+    const std::shared_ptr<const isa_tables> tables;
+    // Dicionário de diretivas de préprocessamento para suas rotinas
+    const std::map<std::string, void(*)(std::vector<asm_line>::iterator&, Preprocesser*)> &pre_directive_table;
     // Armazena um dicionário das definições de sinônimo do programa
     std::map<std::string, int> synonym_table;
-    // Dicionário de diretivas de préprocessamento para suas rotinas
-    std::map<std::string, void(*)(std::vector<asm_line>::iterator&, Preprocesser*)> pre_directive_table;
+    // Indica que a primeira linha do próximo lote deve ser pulada (IF falso na última linha do lote anterior)
+    bool skip_pending;
+    // Blocos condicionais do arquivo, pela linha do IFBLOCK. O IF afeta sempre apenas a linha seguinte, e não abre bloco
+    std::map<int, conditional_block> conditional_blocks;
+    // Linha do ENDIF correspondente a cada ELSE
+    std::map<int, int> else_lines;
+    // Linhas de ENDIF com IFBLOCK correspondente
+    std::map<int, int> endif_lines;
+    // Linhas de IFBLOCK ainda abertas durante a indexação
+    std::vector<int> open_blocks;
+    // Linha do arquivo fonte a partir da qual o processamento continua. Linhas anteriores pertencem a um trecho não tomado
+    int resume_line;
+    // Indica que o texto está sendo apenas verificado, sem construir a saída
+    bool checking;
+    // Quantidade de erros após a qual a verificação é interrompida, 0 para nunca interromper
+    size_t max_errors;
+    // Memória, em bytes, para os erros agrupados de preprocess e check
+    size_t diagnostic_budget;
+    // Cache de separação de linhas repassado ao scanner, nullptr se não houver
+    line_scan_cache *line_cache;
+    // Caminhos canônicos dos arquivos em préprocessamento, do principal ao mais interno. Vazio para textos em memória
+    std::vector<std::string> include_stack;
+    // Arquivos já incluídos pelo arquivo em andamento, que não são incluídos de novo
+    std::set<std::string> included;
+    // Arquivos incluídos no último préprocessamento, direta ou indiretamente, com suas datas de modificação
+    std::vector<std::pair<std::string, long long>> dependencies;
+    // Indica que uma inclusão cíclica foi encontrada, e o resultado não pode ser guardado no cache de inclusões
+    bool cycle_found;
+    // Vetor que recebe as linhas mantidas no programa, nullptr se apenas o texto é construído
+    std::vector<asm_line> *kept_lines;
+    // Linhas e erros do último arquivo incluído, ainda não adicionados à saída
+    std::string included_text;
+    std::vector<diagnostic> included_errors;
+    // Define se o arquivo .pre é escrito no formato binário, já separado em linhas
+    bool binary_output;
     
+    // Lê um arquivo .asm inteiro, levantando erro se ele não existir ou tiver outra extensão
+    std::string read_source(std::string);
+    // Préprocessa um texto, sem liberar o estado ao final
+    // Com um coletor, os erros de cada lote passam da lista para ele, que os agrupa dentro do seu limite de memória
+    std::string preprocess_body(const std::string&, std::vector<diagnostic>&, bool, Diagnostics *grouped = nullptr);
+    // Préprocessa um arquivo incluído, ou reaproveita o resultado guardado se nenhuma de suas dependências mudou
+    std::shared_ptr<const included_file> load_include(const std::string&);
     // Processa uma linha, adicionando ela ao arquivo final ou executando uma diretiva de préprocessamento
     std::string process_line(std::vector<asm_line>::iterator&);
 
     public:
+    // Processa um lote de linhas em sequência, adicionando o resultado à string de saída e os erros à lista. Lotes consecutivos do mesmo arquivo compartilham os sinônimos definidos.
+    void process_lines(std::vector<asm_line>&, std::string&, std::vector<diagnostic>&);
+    // Como o anterior, mas adiciona os erros ao log
+    void process_lines(std::vector<asm_line>&, std::string&, std::string&);
+    // Libera os sinônimos definidos, para que um novo arquivo seja processado
+    void reset();
+    // Indexa os blocos condicionais, recebendo o texto bruto de cada linha em ordem. Apenas a primeira palavra após um possível rótulo é examinada
+    void index_conditional(const char*, const char*, int);
+    // Conclui a indexação dos blocos condicionais
+    void finish_conditional_index();
+    // Retorna o bloco iniciado pelo IFBLOCK da linha, nullptr se ele não tiver ENDIF correspondente
+    const conditional_block* find_block(int) const;
+    // Retorna a linha do ENDIF correspondente ao ELSE da linha, -1 se não houver
+    int find_else_end(int) const;
+    // Indica se o ENDIF da linha fecha algum bloco
+    bool is_block_end(int line) const {return endif_lines.count(line) > 0;}
+    // Inclui o arquivo fornecido, relativo ao diretório do arquivo em andamento: suas linhas vão para a saída e seus sinônimos para a tabela
+    void include(std::string);
+    // Retorna o caminho do arquivo incluído pela linha bruta fornecida, vazio se ela não for um INCLUDE
+    static std::string include_operand(const char*, const char*);
+    // Resolve o caminho de um INCLUDE relativo ao diretório do arquivo que o contém
+    static std::string resolve_include(const std::string&, const std::string&);
+    // Faz o processamento continuar a partir da linha fornecida, pulando as linhas anteriores
+    void resume_at(int line) {resume_line = line;}
+    int get_resume_line() const {return resume_line;}
     const bool is_verbose() const {return verbose;}
     std::map<std::string, int>& get_synonym_table() {return synonym_table;}
     // Tenta acessar o valor atribuído ao parametro pela tabela de sinônimos. Retorna o ponteiro para a entrada na tabela se houver, nullptr se não houver
     // void* resolve_synonym(std::string synonym);
     // Recebe um arquivo e cria um novo arquivo .PRE, com o código preprocessado
     void preprocess(std::string, bool print = false);
-    // Construtor
+    // Verifica um arquivo .asm sem gerar o arquivo .pre. Lança os erros encontrados, como preprocess
+    void check(std::string, bool print = false);
+    // Define a quantidade de erros após a qual a verificação é interrompida
+    void set_max_errors(size_t limit) {max_errors = limit;}
+    // Define a memória, em bytes, para os erros de preprocess, check e do préprocessamento com log. O padrão é DIAGNOSTIC_BUDGET
+    void set_diagnostic_budget(size_t budget) {diagnostic_budget = budget;}
+    // Define se preprocess escreve o .pre no formato binário, que o montador lê sem escanear. O padrão é o texto
+    void set_binary_output(bool enabled) {binary_output = enabled;}
+    // Define o caminho do arquivo cujo texto será préprocessado, a partir do qual os INCLUDEs são resolvidos
+    void set_source_path(const std::string&);
+    // Arquivos incluídos no último préprocessamento, com suas datas de modificação
+    const std::vector<std::pair<std::string, long long>>& get_dependencies() const {return dependencies;}
+    // Faz o processamento guardar as linhas mantidas, já com os sinônimos substituídos, em vez de construir o texto. nullptr volta a construir o texto
+    void set_kept_lines(std::vector<asm_line> *lines) {kept_lines = lines;}
+    // Define um cache de separação de linhas para o scanner
+    void set_line_cache(line_scan_cache *cache) {line_cache = cache;}
+    // Préprocessa um texto .asm em memória e retorna o texto .pre, adicionando os erros à lista
+    // Só acessa arquivos pelos INCLUDEs, e apenas se um caminho fonte foi definido. Sem ele, INCLUDE é um erro semântico
+    // Com um coletor, os erros vão para ele, agrupados, e não para a lista
+    std::string preprocess_text(const std::string&, std::vector<diagnostic>&, bool print = false, Diagnostics *grouped = nullptr);
+    // Como o anterior, mas adiciona os erros ao log, agrupados
+    std::string preprocess_text(const std::string&, std::string&, bool print = false);
+    // Construtor, apenas com as diretivas, sem ler o arquivo de instruções
     Preprocesser(bool verbose = false);
+    // Construtor, com tabelas já fornecidas. O préprocessador guarda apenas o estado do arquivo em andamento, e pode ser reutilizado para vários arquivos
+    Preprocesser(std::shared_ptr<const isa_tables>, bool verbose = false);
 };
 
 #endif
\ No newline at end of file
@@ -3,7 +3,11 @@
 
 #include <string>
 #include <vector>
+#include <istream>
+#include <unordered_map>
 #include "mounter_exception.hpp"
+#include "literal.hpp"
+#include "diagnostics.hpp"
 
 // Representa uma linha do código separada por elementos
 struct asm_line {
@@ -13,10 +17,14 @@ struct asm_line {
     std::string label;
     std::string operation;
     std::string operand[2];
+    // Classificação dos operandos como literais numéricos, feita no escaneamento
+    literal operand_literal[2] = {{NOT_LITERAL, 0}, {NOT_LITERAL, 0}};
     // // Indica qual será a linha no arquivo final .obj
     // int final_number;
     // Indica qual o código opcode da instrução
     int opcode;
+    // Quantidade de palavras ocupadas por uma diretiva. SPACE N é um único bloco de N zeros, expandido apenas na escrita
+    int span = 1;
 };
 
 // Uma especificação das exceções de montador que servem uma linha provisória
@@ -38,17 +46,56 @@ class ScannerException : public MounterException {
     void update_provisory_line(asm_line update) {provisory_line = update;}
 };
 
+// Resultado da separação de uma linha, guardado para ser reaproveitado quando o mesmo texto aparecer de novo
+struct scanned_line {
+    // Número da linha em que o texto foi separado
+    int number;
+    asm_line line;
+    // Exceções lançadas pela separação, vazio se não houve erros
+    std::vector<ScannerException> errors;
+    // Indica se a separação lançou uma única exceção, e não um batch
+    bool single_error;
+};
+
+// Cache de separação de linhas, do texto bruto da linha para o resultado
+typedef std::unordered_map<std::string, scanned_line> line_scan_cache;
+
 // Responsável por ler do arquivo fonte e gerar um vetor com as linhas separadas por elemento
 class Scanner {
     // Determina se os erros devem ou não ser reportados
     bool report_all_errors;
+    // Quantidade de erros após a qual o escaneamento é interrompido, 0 para nunca interromper
+    size_t max_errors;
+    // Cache de separação de linhas, nullptr se não houver
+    line_scan_cache *line_cache;
+    // Coletor dos erros, nullptr para escrevê-los diretamente no log
+    Diagnostics *diagnostics;
+    // Lista que recebe os erros, sem agrupá-los, nullptr para escrevê-los no log. O coletor tem precedência
+    std::vector<diagnostic> *error_list;
+    // Registra um erro no coletor ou na lista, ou no log se não houver nenhum
+    void report(int, const std::string&, const std::string&, std::string&);
     // Separa uma única linha em seus elementos
     asm_line break_line(std::string, int);
+    // Como break_line, mas consulta o cache antes e guarda o resultado nele
+    asm_line cached_break_line(const std::string&, int);
     
     public:
-    Scanner(bool report = true) : report_all_errors(report) {}
+    Scanner(bool report = true) : report_all_errors(report), max_errors(0), line_cache(nullptr), diagnostics(nullptr), error_list(nullptr) {}
+    // Define um cache de separação de linhas, que pode ser compartilhado por escaneamentos sucessivos na mesma thread
+    void set_line_cache(line_scan_cache *cache) {line_cache = cache;}
+    void set_max_errors(size_t limit) {max_errors = limit;}
+    // Define um coletor que agrupa os erros repetidos. Os erros ficam nele, e não no log, até que sejam acrescentados ao log
+    void set_diagnostics(Diagnostics *collector) {diagnostics = collector;}
+    // Define uma lista que recebe os erros na ordem em que ocorrem, como diagnósticos, em vez do log
+    void set_error_list(std::vector<diagnostic> *list) {error_list = list;}
     // Recebe um arquivo e retorna a estrutura do programa. Recebe uma opção de imprimir a estrutura resultante ou não. Recebe uma referência string na qual imprime todos os erros encontrados.
     std::vector<asm_line> scan(std::string, std::string&, bool print = false);
+    // Como scan, mas lê as linhas de uma stream já aberta, como um texto em memória
+    std::vector<asm_line> scan(std::istream&, std::string&, bool print = false);
+    // Recebe uma linha bruta e seu número, e a adiciona ao vetor de linhas do programa. Recebe também o rótulo pendente de linhas anteriores e a string de erros.
+    void scan_line(std::string, int, std::string&, std::vector<asm_line>&, std::string&);
+    // Imprime a estrutura das linhas fornecidas
+    void print_lines(const std::vector<asm_line>&);
     // Recebe uma linha e um vetor de rótulos, e encaixa os rótulos na linha.
     void assign_label(asm_line&, std::string&);
 };
@@ -0,0 +1,89 @@
+#ifndef __SIMULATOR__
+#define __SIMULATOR__
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include "isa_tables.hpp"
+
+class ObjectArchive;
+
+// Quantidade de linhas de cada seção do relatório de pontos quentes
+#define PROFILE_REPORT_SIZE 10
+
+// Semântica de cada instrução, identificada pelo nome na tabela de instruções
+enum instruction_semantics {
+    INVALID_INSTRUCTION, ADD, SUB, MULT, DIV, JMP, JMPN, JMPP, JMPZ, COPY, LOAD, STORE, INPUT, OUTPUT, STOP
+};
+
+// Contadores do perfil de execução, indexados por endereço
+struct execution_profile {
+    // Execuções de cada instrução, no endereço do seu opcode
+    std::vector<uint64_t> executions;
+    // Desvios tomados e não tomados de cada salto condicional
+    std::vector<uint64_t> taken;
+    std::vector<uint64_t> not_taken;
+    // Leituras e escritas de cada palavra de memória
+    std::vector<uint64_t> loads;
+    std::vector<uint64_t> stores;
+    // Total de instruções executadas
+    uint64_t steps;
+};
+
+// Mapa de símbolos gerado pelo montador com --map
+struct address_map {
+    // Endereço de cada rótulo
+    std::map<int, std::string> labels;
+    // Linha do arquivo fonte de cada endereço inicial de linha
+    std::map<int, int> lines;
+};
+
+// Executa programas no formato .obj (sem cabeçalho de módulo), com um acumulador e uma memória de palavras
+class Simulator {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Tabelas da arquitetura, das quais vêm os opcodes e tamanhos
+    const std::shared_ptr<const isa_tables> tables;
+    // Semântica e tamanho de cada opcode
+    std::vector<instruction_semantics> semantics;
+    std::vector<int> sizes;
+    // Define se o perfil de execução é coletado
+    bool profiling;
+    execution_profile profile;
+    // Quantidade de instruções após a qual a execução é interrompida, 0 para nunca interromper
+    uint64_t step_limit;
+    // Memória do programa: código e dados. Cada execução trabalha sobre uma cópia da imagem carregada
+    std::vector<int> memory;
+    // Arquivos de objetos já abertos, pelo caminho, reaproveitados pelas cargas seguintes
+    std::map<std::string, std::shared_ptr<ObjectArchive>> archives;
+
+    // Executa o programa carregado. Com PROFILE, também atualiza os contadores do perfil
+    template <bool PROFILE>
+    void execute(std::istream&, std::ostream&);
+    // Descreve um endereço pelo rótulo mais próximo antes dele e pela linha de origem
+    std::string describe(int, const address_map&);
+
+    public:
+    // Ativa ou desativa a coleta do perfil de execução
+    void set_profiling(bool enabled) {profiling = enabled;}
+    // Define a quantidade de instruções após a qual a execução é interrompida
+    void set_step_limit(uint64_t limit) {step_limit = limit;}
+    // Lê um arquivo .obj já ligado, com os opcodes validados, e retorna a sua imagem de memória. Aceita também um membro de um arquivo de objetos, como "programas.oar:soma.obj"
+    std::vector<int> load(std::string);
+    // Executa uma imagem de memória, lendo as entradas de INPUT e escrevendo as saídas de OUTPUT nas streams. A imagem não é alterada
+    void run(const std::vector<int>&, std::istream&, std::ostream&);
+    // Carrega um arquivo .obj e o executa
+    void simulate(std::string path, std::istream &input, std::ostream &output) {run(load(path), input, output);}
+    // Lê um mapa de símbolos. Um arquivo inexistente resulta em um mapa vazio
+    address_map load_symbol_map(std::string);
+    // Retorna o relatório de pontos quentes da última execução, usando o mapa para nomear os endereços
+    std::string profile_report(const address_map&);
+    // Construtor
+    Simulator(std::shared_ptr<const isa_tables>, bool verbose = false);
+};
+
+#endif
\ No newline at end of file
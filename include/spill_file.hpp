@@ -0,0 +1,41 @@
+#ifndef __SPILL_FILE__
+#define __SPILL_FILE__
+
+#include <string>
+#include "scanner.hpp"
+
+// Tamanho do buffer de escrita do arquivo temporário, em bytes
+#define SPILL_BUFFER_SIZE (1 << 16)
+
+// Arquivo temporário que guarda linhas do programa em formato binário compacto, para que não precisem ficar em memória
+// Cada registro contém o número da linha, o opcode, o tamanho do bloco de SPACE, a operação e os dois operandos, estes com comprimentos de 32 bits. Os rótulos não são guardados, pois já foram para a tabela de símbolos
+class SpillFile {
+    // Descritor do arquivo temporário, já removido do sistema de arquivos
+    int descriptor;
+    // Registros ainda não escritos no arquivo
+    std::string buffer;
+    // Região mapeada para a leitura
+    const char* mapping;
+    size_t size;
+    // Posição do próximo registro a ser lido
+    size_t position;
+
+    // Escreve o buffer no arquivo
+    void flush();
+    // Levanta erro de registro incompleto
+    void corrupted() const;
+    // Lê uma string do registro atual, verificando que ela está dentro do arquivo
+    void read_string(std::string&);
+
+    public:
+    SpillFile();
+    ~SpillFile();
+    // Adiciona uma linha ao final do arquivo
+    void append(const asm_line&);
+    // Finaliza a escrita e mapeia o arquivo para leitura
+    void finish();
+    // Lê a próxima linha, reaproveitando a memória da linha fornecida. Retorna falso ao final do arquivo
+    bool next(asm_line&);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef __SPSC_QUEUE__
+#define __SPSC_QUEUE__
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+// Estatísticas de ocupação de uma fila, coletadas ao longo do seu uso
+struct queue_stats {
+    // Capacidade da fila, em itens
+    size_t capacity;
+    // Quantidade de itens que passaram pela fila
+    size_t items;
+    // Soma das ocupações observadas a cada inserção, para o cálculo da média
+    size_t occupancy_sum;
+    // Quantas vezes o produtor esperou pela fila cheia
+    size_t producer_waits;
+    // Quantas vezes o consumidor esperou pela fila vazia
+    size_t consumer_waits;
+};
+
+// Fila circular limitada, sem travas, para exatamente um produtor e um consumidor
+// O produtor espera quando a fila está cheia, o que limita a memória usada entre os estágios
+template <typename T>
+class SPSCQueue {
+    // Um espaço a mais distingue a fila cheia da vazia
+    std::vector<T> buffer;
+    // Próxima posição a ser lida, escrita apenas pelo consumidor
+    alignas(64) std::atomic<size_t> head;
+    // Próxima posição a ser escrita, escrita apenas pelo produtor
+    alignas(64) std::atomic<size_t> tail;
+    // Indica que o produtor não inserirá mais itens
+    std::atomic<bool> closed;
+
+    // Estatísticas do produtor
+    alignas(64) size_t items;
+    size_t occupancy_sum;
+    size_t producer_waits;
+    // Estatísticas do consumidor
+    alignas(64) size_t consumer_waits;
+
+    size_t next(size_t position) const {return (position + 1) % buffer.size();}
+
+    public:
+    SPSCQueue(size_t capacity) :
+        buffer(capacity + 1),
+        head(0),
+        tail(0),
+        closed(false),
+        items(0),
+        occupancy_sum(0),
+        producer_waits(0),
+        consumer_waits(0)
+        {}
+
+    // Insere um item, esperando enquanto a fila estiver cheia
+    void push(T item) {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        const size_t next_position = next(position);
+        if (next_position == head.load(std::memory_order_acquire)) {
+            producer_waits++;
+            while (next_position == head.load(std::memory_order_acquire)) std::this_thread::yield();
+        }
+        const size_t current_head = head.load(std::memory_order_acquire);
+        occupancy_sum += (position + buffer.size() - current_head) % buffer.size() + 1;
+        items++;
+
+        buffer[position] = std::move(item);
+        tail.store(next_position, std::memory_order_release);
+    }
+
+    // Remove um item, esperando enquanto a fila estiver vazia. Retorna falso quando a fila estiver vazia e fechada
+    bool pop(T &item) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) {
+            consumer_waits++;
+            while (position == tail.load(std::memory_order_acquire)) {
+                // O fechamento é verificado antes de reler o fim, para não perder o último item
+                if (closed.load(std::memory_order_acquire) && position == tail.load(std::memory_order_acquire)) return false;
+                std::this_thread::yield();
+            }
+        }
+
+        item = std::move(buffer[position]);
+        head.store(next(position), std::memory_order_release);
+        return true;
+    }
+
+    // Sinaliza que não haverá mais inserções
+    void close() {closed.store(true, std::memory_order_release);}
+
+    // Deve ser chamado apenas depois que produtor e consumidor terminarem
+    queue_stats get_stats() const {
+        return queue_stats {buffer.size() - 1, items, occupancy_sum, producer_waits, consumer_waits};
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef __STRIPPER__
+#define __STRIPPER__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "scanner.hpp"
+#include "address_map.hpp"
+
+// Remove os símbolos mortos do programa montado pela primeira passagem: código inalcançável e dados que nenhuma instrução alcançável referencia
+// A alcançabilidade parte do endereço 0 e dos símbolos públicos, segue o fluxo de controle e marca os rótulos usados como operandos
+// Um dado é mantido inteiro, do seu rótulo até o próximo rótulo, pois as palavras seguintes só são acessadas a partir dele
+class DeadSymbolStripper {
+    // Endereços das linhas, e tamanhos das instruções
+    AddressMap addresses;
+    // Palavras e bytes do objeto removidos, e rótulos descartados
+    int removed_code;
+    int removed_data;
+    size_t removed_bytes;
+    std::vector<std::string> removed_labels;
+
+    public:
+    // Recebe a tabela de instruções, da qual vêm os tamanhos
+    DeadSymbolStripper(const std::map<std::string, int[2]>&);
+    // Remove as linhas mortas, reatribui os endereços e retira da tabela de símbolos os rótulos removidos. Recebe os símbolos públicos e externos do módulo
+    // Retorna a quantidade de palavras removidas
+    int strip(std::vector<asm_line>&, std::map<std::string, int>&, const std::map<std::string, int>&, const std::set<std::string>&);
+    // Descreve o que foi removido. Os bytes são os que as linhas removidas ocupariam no arquivo objeto
+    std::string report();
+};
+
+#endif
\ No newline at end of file
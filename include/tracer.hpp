@@ -0,0 +1,98 @@
+#ifndef __TRACER__
+#define __TRACER__
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "alloc_stats.hpp"
+
+// Quantidade de linhas em cada lote registrado dentro dos estágios
+#define TRACE_BATCH_SIZE 1024
+// Capacidade padrão do buffer circular de cada thread, em eventos
+#define TRACE_BUFFER_CAPACITY (1 << 18)
+
+// Evento de rastreamento, no formato de eventos de trace do Chrome
+struct trace_event {
+    // Nome do trecho; sempre um literal, para que o registro não aloque memória
+    const char* name;
+    // 'B' para início, 'E' para fim
+    char phase;
+    // Instante do evento, em nanossegundos desde a ativação
+    long long timestamp;
+    // Linha do arquivo fonte em que o trecho começa, -1 se não se aplica
+    int line;
+};
+
+// Buffer circular de eventos de uma única thread. Apenas a thread dona escreve nele
+struct trace_buffer {
+    // Identificador da thread no rastreamento
+    int thread_id;
+    // Nome da thread, se atribuído
+    const char* thread_name;
+    std::vector<trace_event> events;
+    // Total de eventos já escritos; a posição no buffer é o resto pela capacidade
+    std::atomic<size_t> written;
+};
+
+// Registra eventos de início e fim de trechos da execução e os exporta no formato de trace do Chrome
+// Desativado, cada ponto de rastreamento custa apenas uma leitura atômica
+class Tracer {
+    static std::atomic<bool> enabled;
+
+    // Obtém o buffer da thread atual, criando-o no primeiro uso
+    static trace_buffer& local_buffer();
+
+    public:
+    static bool is_enabled() {return enabled.load(std::memory_order_relaxed);}
+    // Ativa o rastreamento
+    static void enable();
+    // Registra um evento na thread atual
+    static void record(const char*, char, int line = -1);
+    // Atribui um nome à thread atual, exibido na linha do tempo
+    static void name_thread(const char*);
+    // Escreve todos os eventos registrados no arquivo, no formato JSON de trace do Chrome
+    static void dump(std::string);
+};
+
+// Registra o início de um trecho na construção e o seu fim na destruição
+// O trecho também é o estágio ao qual as estatísticas de alocação atribuem as alocações feitas nele
+class TraceScope {
+    const char* name;
+    // Estágio anterior das estatísticas de alocação, -1 se elas estão desativadas
+    int previous_stage;
+
+    public:
+    TraceScope(const char* name, int line = -1) :
+        name(name),
+        previous_stage(AllocStats::is_enabled() ? AllocStats::enter_stage(AllocStats::register_stage(name)) : -1) {
+        if (Tracer::is_enabled()) Tracer::record(name, 'B', line);
+    }
+    ~TraceScope() {
+        if (Tracer::is_enabled()) Tracer::record(name, 'E');
+        if (previous_stage != -1) AllocStats::leave_stage(previous_stage);
+    }
+};
+
+// Divide um laço sobre linhas em trechos de TRACE_BATCH_SIZE linhas
+class TraceBatches {
+    const char* name;
+    size_t count;
+    bool open;
+
+    public:
+    TraceBatches(const char* name) : name(name), count(0), open(false) {}
+    // Deve ser chamado a cada linha do laço, com o número da linha no arquivo fonte
+    void step(int line) {
+        if (!Tracer::is_enabled()) return;
+        if (count++ % TRACE_BATCH_SIZE == 0) {
+            if (open) Tracer::record(name, 'E');
+            Tracer::record(name, 'B', line);
+            open = true;
+        }
+    }
+    ~TraceBatches() {
+        if (open) Tracer::record(name, 'E');
+    }
+};
+
+#endif
\ No newline at end of file
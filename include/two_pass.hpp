@@ -2,31 +2,152 @@
 #define __TWOPASS__
 
 #include <map>
+#include <set>
+#include <memory>
 #include "../include/scanner.hpp"
+#include "../include/spill_file.hpp"
+#include "../include/flow_analyzer.hpp"
+#include "../include/isa_tables.hpp"
+#include "../include/diagnostics.hpp"
+
+// Quantidade de linhas mantidas em memória por vez na montagem fora de memória
+#define OUT_OF_CORE_CHUNK 4096
+
+// Informações de ligação de um programa montado como módulo (entre BEGIN e END)
+struct module_info {
+    // Nome do módulo, vazio se o programa não for um módulo
+    std::string name;
+    // Indica se a diretiva END foi encontrada
+    bool ended;
+    // Rótulos declarados como PUBLIC, com a linha da declaração
+    std::map<std::string, int> public_symbols;
+    // Rótulos declarados como EXTERN
+    std::set<std::string> extern_symbols;
+    // Tabela de uso: símbolo externo e o endereço relativo onde é utilizado
+    std::vector<std::pair<std::string, int>> use_table;
+    // Mapa de bits de relocação, um caractere '0' ou '1' por palavra do código
+    std::string relocation;
+};
+
+// Estado da primeira passagem, que persiste entre lotes de linhas
+struct first_pass_state {
+    // Exceções encontradas, agrupadas e lançadas em batch ao final da passagem
+    Diagnostics exceptions;
+    // Seção atual
+    std::string current_section;
+    // Indica se houve alguma seção texto
+    bool section_text_present;
+    // Endereço da próxima linha do programa
+    int current_line_number;
+};
 
 class TwoPassAlgorithm {
     // Define se descrções serão impressas
     const bool verbose;
+    // Tabelas compartilhadas da arquitetura
+    const std::shared_ptr<const isa_tables> tables;
     // Armazena um dicionário das definições de instruções, de instrução para opcode e tamanho
-    std::map<std::string, int[2]> instruction_table;
+    const std::map<std::string, int[2]> &instruction_table;
+    // Dicionário de diretivas para suas rotinas
+    const std::map<std::string, void(*)(std::vector<asm_line>::iterator&, int&)> &directive_table;
+    // Dicionário de diretivas de ligação para suas rotinas
+    const std::map<std::string, void(*)(std::vector<asm_line>::iterator&, TwoPassAlgorithm*)> &link_directive_table;
     // Armazena um dicionário das definições de símbolos
     std::map<std::string, int> symbol_table;
-    // Dicionário de diretivas de préprocessamento para suas rotinas
-    std::map<std::string, void(*)(std::vector<asm_line>::iterator&, int&)> directive_table;
+    // Informações de ligação do módulo sendo montado
+    module_info module;
+    // Estado da primeira passagem em andamento
+    first_pass_state pass;
+    // Define se a análise de fluxo acompanha a primeira passagem
+    bool analysis;
+    // Coleta as instruções e dados da primeira passagem para a análise de fluxo
+    FlowAnalyzer analyzer;
+    // Avisos da última montagem, que não impedem a geração do objeto, como lista e no formato do log
+    std::vector<diagnostic> warnings;
+    std::string warning_log;
+    // Define se o otimizador peephole executa entre as passagens
+    bool optimization;
+    // Define se a remoção de símbolos mortos executa entre as passagens, depois do otimizador
+    bool stripping;
+    // Relatórios do otimizador e da remoção de símbolos mortos na última montagem
+    std::string optimization_report;
+    // Quantidade de erros após a qual a verificação é interrompida, 0 para nunca interromper
+    size_t max_errors;
+    // Memória para os diagnósticos de cada etapa da montagem, em bytes
+    size_t diagnostic_budget;
+    // Define se a montagem gera o mapa de símbolos, com os rótulos e a linha de origem de cada endereço
+    bool symbol_map_enabled;
+    // Endereço inicial e linha do arquivo fonte de cada linha montada, registrados na segunda passagem
+    std::vector<std::pair<int, int>> line_addresses;
 
+    // Lê as linhas do programa: direto dos registros de um .pre binário, ou pelo scanner de um .pre textual
+    std::vector<asm_line> read_program(Scanner&, const std::string&, std::string&, bool);
     // Primeira passagem: recebe as linhas do programa e popula a tabela de símbolos
     void first_pass(std::vector<asm_line>&);
+    // A primeira passagem em partes: prepara o estado, processa um lote de linhas e conclui, lançando o batch de exceções
+    void begin_first_pass();
+    void first_pass_lines(std::vector<asm_line>&);
+    void end_first_pass();
+    // Executa a primeira passagem em um lote e o despeja no arquivo temporário. Uma SECTION no fim do lote é retida para o próximo, a não ser que seja o último
+    void spill_lines(std::vector<asm_line>&, SpillFile&, bool);
     // Segunda passagem: recebe as linhas do programa e gera o uma string que será o conteúdo do arquivo final, pegando os opcodes e passando as labels pela tabela de símbolos
     std::string second_pass(std::vector<asm_line>&);
+    // Gera o código de uma única linha na segunda passagem, avançando o endereço
+    void second_pass_line(const asm_line&, std::string&, Diagnostics&, int&);
+    // Procura o operando da linha, pelo índice, na tabela de símbolos. Retorna a entrada, ou nullptr após registrar o erro
+    const int* find_operand(const asm_line&, int, Diagnostics&);
+    // Executa a primeira passagem e valida os operandos como a segunda, mas sem gerar o código, adicionando os erros ao log
+    void validate_lines(std::vector<asm_line>&, std::string&);
+    // Registra um operando nas informações de relocação do módulo
+    void relocate_operand(const std::string&, int);
+
 
+    // Gera o cabeçalho do módulo relocável: nome, tamanho, bits de relocação e tabelas de definição e uso
+    std::string module_header();
 
     public:
+    const bool is_verbose() const {return verbose;}
+    std::map<std::string, int>& get_symbol_table() {return symbol_table;}
+    const std::vector<diagnostic>& get_warnings() const {return warnings;}
+    const std::string& get_warning_log() const {return warning_log;}
+    const std::string& get_optimization_report() const {return optimization_report;}
+    // Ativa ou desativa o otimizador peephole
+    void set_optimization(bool enabled) {optimization = enabled;}
+    // Ativa ou desativa a remoção de código inalcançável e de dados não referenciados
+    void set_stripping(bool enabled) {stripping = enabled;}
+    // Ativa ou desativa a análise de fluxo de controle e de dados
+    void set_analysis(bool enabled) {analysis = enabled;}
+    module_info& get_module() {return module;}
     // Recebe um arquivo e cria um novo arquivo .OBJ, com o código montado
     void assemble(std::string, bool print = false);
-    // Construtor
+    // Como assemble, mas retorna o conteúdo do arquivo objeto em vez de escrevê-lo
+    std::string assemble_object(std::string, bool print = false);
+    // Como assemble, mas mantém em memória apenas a tabela de símbolos: as linhas vão para um arquivo temporário após a primeira passagem e o objeto é escrito aos poucos
+    void assemble_out_of_core(std::string, bool print = false);
+    // Verifica um arquivo .pre sem gerar nem tocar o arquivo objeto. Lança os erros encontrados, como assemble
+    void check(std::string, bool print = false);
+    // Define a quantidade de erros após a qual a verificação é interrompida
+    void set_max_errors(size_t limit) {max_errors = limit;}
+    // Define a memória para os diagnósticos de cada etapa da montagem
+    void set_diagnostic_budget(size_t budget) {diagnostic_budget = budget;}
+    // Ativa ou desativa a geração do mapa de símbolos
+    void set_symbol_map(bool enabled) {symbol_map_enabled = enabled;}
+    // Retorna o mapa de símbolos da última montagem: linhas "S: rótulo endereço" e "L: endereço linha"
+    std::string symbol_map();
+    // Escreve o mapa de símbolos ao lado do arquivo objeto, com a extensão .map, se a geração estiver ativa
+    void write_symbol_map(const std::string&);
+    // Executa as duas passagens sobre as linhas já escaneadas, adicionando os erros à lista. Retorna o conteúdo do arquivo objeto.
+    std::string assemble_lines(std::vector<asm_line>&, std::vector<diagnostic>&);
+    // Como o anterior, mas adiciona os erros ao log
+    std::string assemble_lines(std::vector<asm_line>&, std::string&);
+    // Descarta o estado da montagem anterior, mantendo a capacidade já alocada
+    void reset();
+    // Construtor, com as tabelas do arquivo instructions
     TwoPassAlgorithm(bool verbose = false);
+    // Construtor, com tabelas já fornecidas. O montador guarda apenas o estado da montagem em andamento, e pode ser reutilizado para vários arquivos
+    TwoPassAlgorithm(std::shared_ptr<const isa_tables>, bool verbose = false);
     // Adiciona os rótulos da linha na TS, e adiciona qulquer exceção encontrada no vetor
-    void registerLabel(asm_line&, int, std::vector<MounterException>&);
+    void registerLabel(asm_line&, int, Diagnostics&);
     // Imprime uma linha
     void print_line(asm_line);
 };
@@ -0,0 +1,7 @@
+#ifndef __ASSEMBLER_VERSION__
+#define __ASSEMBLER_VERSION__
+
+// Versão do montador. Deve mudar sempre que a saída para uma mesma entrada puder mudar
+#define ASSEMBLER_VERSION "1.2.0"
+
+#endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef __WATCHER__
+#define __WATCHER__
+
+#include <map>
+#include <set>
+#include <memory>
+#include <string>
+#include <vector>
+#include "preprocesser.hpp"
+#include "two_pass.hpp"
+#include "isa_tables.hpp"
+
+// Quantidade de linhas distintas guardadas no cache de separação antes de ele ser descartado
+#define WATCH_CACHE_LIMIT 262144
+// Tempo, em milissegundos, sem novos eventos para que uma sequência de alterações seja considerada completa
+#define WATCH_SETTLE_TIME 20
+
+// Modo de observação: monitora os arquivos fonte com inotify e recompila cada um assim que ele é salvo
+// Arquivos incluídos pelos arquivos fonte também são observados, e uma alteração neles recompila quem os inclui
+// Entre as recompilações, mantém as tabelas, os contextos do préprocessador e do montador e o cache de separação de linhas, então apenas as linhas alteradas passam pelo scanner
+class Watcher {
+    // Define se descrções serão impressas
+    const bool verbose;
+    // Modo de compilação, -p ou -o
+    const std::string mode;
+    // Define se a montagem executa a análise de fluxo
+    bool analysis;
+    // Define se a montagem executa o otimizador peephole
+    bool optimization;
+    // Define se a montagem remove os símbolos mortos
+    bool stripping;
+    // Tabelas da arquitetura, recarregadas quando o arquivo de instruções muda
+    std::shared_ptr<const isa_tables> tables;
+    // Contextos reaproveitados entre as recompilações
+    std::unique_ptr<Preprocesser> preprocesser;
+    std::unique_ptr<TwoPassAlgorithm> assembler;
+    // Resultados da separação de linhas já vistas
+    line_scan_cache line_cache;
+    // Conteúdo da última versão compilada de cada arquivo, para ignorar salvamentos sem alterações
+    std::map<std::string, std::string> contents;
+    // Arquivos que incluem cada arquivo incluído, pelo caminho canônico do incluído
+    std::map<std::string, std::set<std::string>> dependents;
+
+    // Carrega o arquivo de instruções e recria o montador. Mantém as tabelas anteriores se o arquivo for inválido
+    void load_tables();
+    // Recompila um arquivo se o seu conteúdo mudou, imprimindo o resultado e o tempo gasto
+    void build(const std::string&);
+
+    public:
+    // Ativa ou desativa a análise de fluxo de controle e de dados
+    void set_analysis(bool enabled) {analysis = enabled;}
+    // Ativa ou desativa o otimizador peephole
+    void set_optimization(bool enabled) {optimization = enabled;}
+    // Ativa ou desativa a remoção de código inalcançável e de dados não referenciados
+    void set_stripping(bool enabled) {stripping = enabled;}
+    // Compila os arquivos e passa a observá-los. Não retorna
+    void watch(const std::vector<std::string>&);
+    // Construtor
+    Watcher(std::string mode, bool verbose = false);
+};
+
+#endif
\ No newline at end of file
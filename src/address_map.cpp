@@ -0,0 +1,77 @@
+#include <algorithm>
+#include "../include/address_map.hpp"
+
+using namespace std;
+
+AddressMap::AddressMap(const map<string, int[2]> &instruction_table) : total(0) {
+    for (auto instruction_entry = instruction_table.begin(); instruction_entry != instruction_table.end(); instruction_entry++) {
+        sizes[instruction_entry->first] = instruction_entry->second[1];
+    }
+}
+
+int AddressMap::size_of(const asm_line &line) const {
+    auto size_entry = sizes.find(line.operation);
+    return size_entry == sizes.end() ? line.span : size_entry->second;
+}
+
+bool AddressMap::is_instruction(const string &operation) const {
+    return sizes.count(operation) > 0;
+}
+
+void AddressMap::measure(const vector<asm_line> &lines) {
+    address.resize(lines.size());
+    total = 0;
+    for (size_t index = 0; index < lines.size(); index++) {
+        address[index] = total;
+        total += size_of(lines[index]);
+    }
+}
+
+const vector<int>& AddressMap::addresses() const {
+    return address;
+}
+
+int AddressMap::size() const {
+    return total;
+}
+
+int AddressMap::line_at(int target) const {
+    auto position = upper_bound(address.begin(), address.end(), target);
+    if (position == address.begin() || *(position - 1) != target) return -1;
+    return (position - address.begin()) - 1;
+}
+
+int AddressMap::remove(vector<asm_line> &lines, const vector<bool> &removed, map<string, int> &symbol_table, const set<string> &extern_symbols) const {
+    const int count = lines.size();
+
+    // Recalcula os endereços: cada endereço antigo vai para o novo endereço da sua linha, ou da linha mantida seguinte
+    vector<int> new_start(count);
+    int current_address = 0;
+    for (int index = 0; index < count; index++) {
+        new_start[index] = current_address;
+        if (!removed[index]) current_address += size_of(lines[index]);
+    }
+    auto new_address = [&](int old_address) {
+        if (old_address >= total) return current_address;
+        // A linha que contém o endereço é a última que começa nele ou antes dele
+        const int index = upper_bound(address.begin(), address.end(), old_address) - address.begin() - 1;
+        return new_start[index] + (removed[index] ? 0 : old_address - address[index]);
+    };
+    for (auto symbol_entry = symbol_table.begin(); symbol_entry != symbol_table.end(); symbol_entry++) {
+        if (extern_symbols.count(symbol_entry->first) == 0 && symbol_entry->second >= 0 && symbol_entry->second <= total) {
+            symbol_entry->second = new_address(symbol_entry->second);
+        }
+    }
+
+    // Remove as linhas marcadas
+    int kept = 0;
+    for (int index = 0; index < count; index++) {
+        if (!removed[index]) {
+            if (kept != index) lines[kept] = move(lines[index]);
+            kept++;
+        }
+    }
+    lines.resize(kept);
+
+    return current_address;
+}
@@ -0,0 +1,213 @@
+#include <new>
+#include <mutex>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include "../include/alloc_stats.hpp"
+
+using namespace std;
+
+atomic<bool> AllocStats::enabled(false);
+
+namespace {
+    // Estágios e categorias registrados. A primeira posição recebe as alocações fora de qualquer um deles
+    alloc_counters stages[ALLOC_SLOTS];
+    alloc_counters sites[ALLOC_SLOTS];
+    int stage_count = 1;
+    int site_count = 1;
+    // Protege apenas o registro, e não a contagem
+    mutex registry_mutex;
+    // Memória viva desde a ativação, em bytes
+    atomic<int64_t> live(0);
+    // Estágio e categoria atuais da thread
+    thread_local int current_stage = 0;
+    thread_local int current_site = 0;
+
+    // Busca o nome na tabela, registrando-o se for novo. Sem espaço, retorna a primeira posição
+    int register_slot(alloc_counters* table, int &count, const char* name) {
+        lock_guard<mutex> lock(registry_mutex);
+        for (int slot = 1; slot < count; slot++) {
+            const char* registered = table[slot].name.load(memory_order_relaxed);
+            if (registered == name || strcmp(registered, name) == 0) return slot;
+        }
+        if (count == ALLOC_SLOTS) return 0;
+        table[count].name.store(name, memory_order_relaxed);
+        return count++;
+    }
+
+    void reset_slot(alloc_counters &counters) {
+        counters.allocations.store(0, memory_order_relaxed);
+        counters.bytes.store(0, memory_order_relaxed);
+        counters.frees.store(0, memory_order_relaxed);
+        counters.peak.store(0, memory_order_relaxed);
+    }
+
+    // Posições da tabela com alocações, em ordem decrescente de bytes
+    vector<int> by_bytes(const alloc_counters* table, int count) {
+        vector<int> slots;
+        for (int slot = 0; slot < count; slot++) {
+            if (table[slot].allocations.load(memory_order_relaxed) > 0) slots.push_back(slot);
+        }
+        stable_sort(slots.begin(), slots.end(), [&](int left, int right) {
+            return table[left].bytes.load(memory_order_relaxed) > table[right].bytes.load(memory_order_relaxed);
+        });
+        return slots;
+    }
+}
+
+void AllocStats::enable() {
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        stages[0].name.store("(fora de estágios)", memory_order_relaxed);
+        sites[0].name.store("(sem categoria)", memory_order_relaxed);
+        for (int slot = 0; slot < ALLOC_SLOTS; slot++) {
+            reset_slot(stages[slot]);
+            reset_slot(sites[slot]);
+        }
+    }
+    live.store(0, memory_order_relaxed);
+    enabled.store(true, memory_order_release);
+}
+
+void AllocStats::disable() {
+    enabled.store(false, memory_order_release);
+}
+
+int AllocStats::register_stage(const char* name) {
+    return register_slot(stages, stage_count, name);
+}
+
+int AllocStats::register_site(const char* name) {
+    return register_slot(sites, site_count, name);
+}
+
+int AllocStats::enter_stage(int stage) {
+    const int previous = current_stage;
+    current_stage = stage;
+    return previous;
+}
+
+int AllocStats::enter_site(int site) {
+    const int previous = current_site;
+    current_site = site;
+    return previous;
+}
+
+void AllocStats::leave_stage(int previous) {
+    current_stage = previous;
+}
+
+void AllocStats::leave_site(int previous) {
+    current_site = previous;
+}
+
+void AllocStats::count_allocation(void* block) {
+    // O tamanho real do bloco, e não o pedido, é o que pesa na memória
+    const int64_t size = malloc_usable_size(block);
+    alloc_counters &stage = stages[current_stage];
+    alloc_counters &site = sites[current_site];
+    stage.allocations.fetch_add(1, memory_order_relaxed);
+    stage.bytes.fetch_add(size, memory_order_relaxed);
+    site.allocations.fetch_add(1, memory_order_relaxed);
+    site.bytes.fetch_add(size, memory_order_relaxed);
+
+    const int64_t now = live.fetch_add(size, memory_order_relaxed) + size;
+    int64_t peak = stage.peak.load(memory_order_relaxed);
+    while (now > peak && !stage.peak.compare_exchange_weak(peak, now, memory_order_relaxed));
+}
+
+void AllocStats::count_free(void* block) {
+    live.fetch_sub(malloc_usable_size(block), memory_order_relaxed);
+    stages[current_stage].frees.fetch_add(1, memory_order_relaxed);
+}
+
+uint64_t AllocStats::total_allocations() {
+    uint64_t total = 0;
+    for (int slot = 0; slot < ALLOC_SLOTS; slot++) total += stages[slot].allocations.load(memory_order_relaxed);
+    return total;
+}
+
+string AllocStats::report() {
+    ostringstream report;
+    uint64_t total_bytes = 0;
+    for (int slot = 0; slot < ALLOC_SLOTS; slot++) total_bytes += stages[slot].bytes.load(memory_order_relaxed);
+
+    report << "Alocações por estágio: {" << endl;
+    for (const int slot : by_bytes(stages, stage_count)) {
+        const alloc_counters &stage = stages[slot];
+        report << "\t" << stage.name.load(memory_order_relaxed) << ": " << stage.allocations.load(memory_order_relaxed) << " alocações, "
+            << stage.bytes.load(memory_order_relaxed) << " bytes, " << stage.frees.load(memory_order_relaxed) << " liberações, pico de "
+            << stage.peak.load(memory_order_relaxed) << " bytes vivos" << endl;
+    }
+    report << "}" << endl;
+
+    report << "Categorias com mais bytes alocados: {" << endl;
+    const vector<int> ranked = by_bytes(sites, site_count);
+    for (size_t position = 0; position < ranked.size() && position < ALLOC_REPORT_SITES; position++) {
+        const alloc_counters &site = sites[ranked[position]];
+        const uint64_t bytes = site.bytes.load(memory_order_relaxed);
+        report << "\t" << site.name.load(memory_order_relaxed) << ": " << site.allocations.load(memory_order_relaxed) << " alocações, "
+            << bytes << " bytes (" << (total_bytes > 0 ? 100 * bytes / total_bytes : 0) << "%)" << endl;
+    }
+    report << "}" << endl;
+    report << "Total: " << total_allocations() << " alocações, " << total_bytes << " bytes";
+    return report.str();
+}
+
+// Substituições dos operadores globais. As variantes com alinhamento continuam as da biblioteca padrão
+void* operator new(size_t size) {
+    void* block;
+    while ((block = malloc(size == 0 ? 1 : size)) == nullptr) {
+        new_handler handler = get_new_handler();
+        if (handler == nullptr) throw bad_alloc();
+        handler();
+    }
+    if (AllocStats::is_enabled()) AllocStats::count_allocation(block);
+    return block;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* block) noexcept {
+    if (block == nullptr) return;
+    if (AllocStats::is_enabled()) AllocStats::count_free(block);
+    free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    operator delete(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete(void* block, const nothrow_t&) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void* block, const nothrow_t&) noexcept {
+    operator delete(block);
+}
@@ -0,0 +1,199 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include "../include/batch_runner.hpp"
+#include "../include/simulator.hpp"
+#include "../include/mounter_exception.hpp"
+
+using namespace std;
+
+namespace {
+    // Lê um arquivo inteiro
+    bool read_file(const string &path, string &content) {
+        fstream file(path, fstream::in | fstream::binary);
+        if (!file.is_open()) return false;
+        stringstream buffer;
+        buffer << file.rdbuf();
+        content = buffer.str();
+        return true;
+    }
+
+    // Separa um texto em palavras, ignorando a diferença entre espaços e quebras de linha
+    vector<string> split_words(const string &text) {
+        vector<string> words;
+        istringstream stream(text);
+        string word;
+        while (stream >> word) words.push_back(word);
+        return words;
+    }
+}
+
+BatchRunner::BatchRunner(shared_ptr<const isa_tables> tables, bool verbose/* = false */) : verbose(verbose), tables(tables), thread_count(0), step_limit(0) {}
+
+void BatchRunner::read_jobs(string path) {
+    fstream manifest(path, fstream::in);
+    if (!manifest.is_open()) {
+        throw invalid_argument("Falha ao abrir arquivo \"" + path + "\"");
+    }
+    const size_t slash = path.rfind('/');
+    const string directory = (slash == string::npos ? "" : path.substr(0, slash + 1));
+    auto resolve = [&](const string &file) {
+        return (file.empty() || file.front() == '/') ? file : directory + file;
+    };
+
+    // Cada linha: programa.obj entradas [saídas esperadas]. Comentários começam com #
+    string line;
+    for (int line_number = 1; getline(manifest, line); line_number++) {
+        const vector<string> words = split_words(line.substr(0, line.find('#')));
+        if (words.empty()) continue;
+        if (words.size() < 2 || words.size() > 3) {
+            throw invalid_argument("Linha " + to_string(line_number) + " do arquivo de tarefas: esperava \"programa.obj entradas [saídas esperadas]\"");
+        }
+        jobs.push_back(batch_job {resolve(words[0]), resolve(words[1]), words.size() == 3 ? resolve(words[2]) : ""});
+    }
+}
+
+bool BatchRunner::next_job(unsigned worker, size_t &job) {
+    // A própria fila é consumida pelo fim, mantendo juntas as tarefas do mesmo programa
+    {
+        worker_queue &own = *queues[worker];
+        lock_guard<mutex> lock(own.lock);
+        if (!own.jobs.empty()) {
+            job = own.jobs.back();
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    // Rouba pelo início das filas das outras threads, a partir da seguinte
+    for (unsigned offset = 1; offset < queues.size(); offset++) {
+        worker_queue &victim = *queues[(worker + offset) % queues.size()];
+        lock_guard<mutex> lock(victim.lock);
+        if (!victim.jobs.empty()) {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    // Nenhuma tarefa é criada durante a execução, então filas vazias significam o fim
+    return false;
+}
+
+void BatchRunner::work(unsigned worker) {
+    // Cada thread tem o seu simulador, e portanto a sua própria memória
+    Simulator simulator(tables);
+    simulator.set_step_limit(step_limit);
+    size_t job;
+    while (next_job(worker, job)) execute(job, simulator);
+}
+
+void BatchRunner::execute(size_t index, Simulator &simulator) {
+    const batch_job &job = jobs[index];
+    job_result &result = results[index];
+    const auto start = chrono::steady_clock::now();
+
+    auto load_error = load_errors.find(job.program);
+    string input_text, expected_text;
+    if (load_error != load_errors.end()) {
+        result = job_result {JOB_ERROR, load_error->second, 0};
+        return;
+    }
+    if (!read_file(job.input, input_text)) {
+        result = job_result {JOB_ERROR, "Falha ao abrir arquivo \"" + job.input + "\"", 0};
+        return;
+    }
+    if (!job.expected.empty() && !read_file(job.expected, expected_text)) {
+        result = job_result {JOB_ERROR, "Falha ao abrir arquivo \"" + job.expected + "\"", 0};
+        return;
+    }
+
+    istringstream input(input_text);
+    ostringstream output;
+    result = job_result {JOB_PASSED, "", 0};
+    try {
+        simulator.run(*images.at(job.program), input, output);
+    }
+    catch (exception &error) {
+        result.status = JOB_ERROR;
+        result.detail = error.what();
+    }
+    result.elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (result.status == JOB_ERROR) return;
+
+    if (job.expected.empty()) {
+        result.status = JOB_RAN;
+        return;
+    }
+    // As saídas são comparadas palavra a palavra
+    const vector<string> produced = split_words(output.str());
+    const vector<string> expected = split_words(expected_text);
+    for (size_t position = 0; position < produced.size() || position < expected.size(); position++) {
+        const string got = (position < produced.size() ? produced[position] : "(nada)");
+        const string wanted = (position < expected.size() ? expected[position] : "(nada)");
+        if (got != wanted) {
+            result.status = JOB_FAILED;
+            result.detail = "saída " + to_string(position + 1) + ": esperava " + wanted + ", obteve " + got;
+            return;
+        }
+    }
+}
+
+bool BatchRunner::run(string path) {
+    read_jobs(path);
+    const auto start = chrono::steady_clock::now();
+
+    // Cada programa é carregado uma única vez, e a imagem é compartilhada, somente leitura, por todas as threads
+    Simulator loader(tables, verbose);
+    for (const batch_job &job : jobs) {
+        if (images.count(job.program) > 0 || load_errors.count(job.program) > 0) continue;
+        try {
+            images[job.program] = make_shared<const vector<int>>(loader.load(job.program));
+        }
+        catch (exception &error) {
+            load_errors[job.program] = error.what();
+        }
+    }
+
+    unsigned workers = (thread_count > 0 ? thread_count : max(1u, thread::hardware_concurrency()));
+    if (workers > jobs.size()) workers = max<size_t>(1, jobs.size());
+    // As tarefas são distribuídas em blocos contíguos, e threads que terminarem antes roubam das outras
+    results.assign(jobs.size(), job_result {JOB_ERROR, "", 0});
+    queues.clear();
+    for (unsigned worker = 0; worker < workers; worker++) {
+        queues.emplace_back(new worker_queue());
+        const size_t first = jobs.size() * worker / workers;
+        const size_t last = jobs.size() * (worker + 1) / workers;
+        // A dona consome pelo fim, então as tarefas são empilhadas em ordem inversa
+        for (size_t job = last; job > first; job--) queues.back()->jobs.push_back(job - 1);
+    }
+    if (verbose) cout << "[" << __FILE__ << "]> " << jobs.size() << " tarefas, " << images.size() << " programas, " << workers << " threads" << endl;
+
+    vector<thread> pool;
+    for (unsigned worker = 0; worker < workers; worker++) pool.emplace_back(&BatchRunner::work, this, worker);
+    for (thread &worker : pool) worker.join();
+    const double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    // Resumo
+    const char *labels[] = {"OK", "FALHOU", "ERRO", "EXECUTADO"};
+    size_t counts[4] = {0, 0, 0, 0};
+    double busy = 0;
+    cout << fixed << setprecision(3);
+    for (size_t index = 0; index < jobs.size(); index++) {
+        const job_result &result = results[index];
+        counts[result.status]++;
+        busy += result.elapsed;
+        cout << "[" << labels[result.status] << "] " << jobs[index].program << " < " << jobs[index].input
+            << " (" << result.elapsed << " ms)" << (result.detail.empty() ? "" : ": " + result.detail) << endl;
+    }
+    cout << jobs.size() << " tarefas: " << counts[JOB_PASSED] << " ok, " << counts[JOB_FAILED] << " falharam, "
+        << counts[JOB_ERROR] << " com erro, " << counts[JOB_RAN] << " sem saída esperada" << endl;
+    cout << "Tempo total " << elapsed << " ms em " << workers << (workers == 1 ? " thread" : " threads")
+        << ", soma das tarefas " << busy << " ms (paralelismo " << setprecision(2) << (elapsed > 0 ? busy / elapsed : 0) << ")" << endl;
+    cout << defaultfloat;
+
+    return counts[JOB_FAILED] == 0 && counts[JOB_ERROR] == 0;
+}
@@ -0,0 +1,153 @@
+#include <map>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/binary_pre.hpp"
+#include "../include/file_io.hpp"
+#include "../include/fnv_hash.hpp"
+
+using namespace std;
+
+// Alinhamento dos registros de linha
+#define BINARY_PRE_ALIGNMENT 8
+
+string encode_binary_pre(const vector<asm_line> &lines) {
+    // Cada texto distinto entra uma única vez na tabela
+    map<string, int32_t> ids;
+    vector<const string*> strings;
+    auto intern = [&](const string &text) {
+        auto id_entry = ids.emplace(text, strings.size());
+        if (id_entry.second) strings.push_back(&id_entry.first->first);
+        return id_entry.first->second;
+    };
+    intern("");
+
+    vector<binary_pre_line> records;
+    records.reserve(lines.size());
+    for (const asm_line &line : lines) {
+        records.push_back(binary_pre_line {
+            line.number, intern(line.label), intern(line.operation), {intern(line.operand[0]), intern(line.operand[1])}, line.opcode, line.span
+        });
+    }
+
+    vector<binary_pre_string> table;
+    table.reserve(strings.size());
+    string text;
+    for (const string *entry : strings) {
+        table.push_back(binary_pre_string {(uint32_t) text.length(), (uint32_t) entry->length()});
+        text += *entry;
+    }
+
+    binary_pre_header header;
+    memcpy(header.magic, BINARY_PRE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_PRE_VERSION;
+    header.string_count = table.size();
+    header.line_count = records.size();
+    header.strings_offset = sizeof(binary_pre_header);
+    header.text_offset = header.strings_offset + table.size() * sizeof(binary_pre_string);
+    header.text_size = text.length();
+    header.lines_offset = header.text_offset + text.length();
+    header.lines_offset += (BINARY_PRE_ALIGNMENT - header.lines_offset % BINARY_PRE_ALIGNMENT) % BINARY_PRE_ALIGNMENT;
+
+    string data;
+    data.reserve(header.lines_offset + records.size() * sizeof(binary_pre_line));
+    data.append(sizeof(binary_pre_header), '\0');
+    data.append((const char*) table.data(), table.size() * sizeof(binary_pre_string));
+    data += text;
+    data.append(header.lines_offset - data.length(), '\0');
+    data.append((const char*) records.data(), records.size() * sizeof(binary_pre_line));
+    header.checksum = fnv_hash(data.data() + sizeof(binary_pre_header), data.length() - sizeof(binary_pre_header));
+    memcpy(&data[0], &header, sizeof(header));
+    return data;
+}
+
+BinaryPre::BinaryPre(const string &path) : path(path), file(path, true), header(nullptr), records(nullptr) {
+    if (file.size() < sizeof(binary_pre_header)) corrupted("arquivo menor que o cabeçalho");
+    const char* mapping = file.data();
+    const size_t mapping_size = file.size();
+    header = (const binary_pre_header*) mapping;
+
+    if (memcmp(header->magic, BINARY_PRE_MAGIC, sizeof(header->magic)) != 0) corrupted("não é um .pre binário");
+    if (header->version != BINARY_PRE_VERSION) corrupted("versão " + to_string(header->version) + " do formato não suportada");
+    if (fnv_hash(mapping + sizeof(binary_pre_header), mapping_size - sizeof(binary_pre_header)) != header->checksum) {
+        corrupted("soma de verificação não confere");
+    }
+    if (header->strings_offset != sizeof(binary_pre_header) || header->string_count == 0 ||
+        header->string_count > (mapping_size - header->strings_offset) / sizeof(binary_pre_string)) {
+        corrupted("tabela de strings fora do arquivo");
+    }
+    if (header->text_offset > mapping_size || header->text_size > mapping_size - header->text_offset) {
+        corrupted("texto das strings fora do arquivo");
+    }
+    if (header->lines_offset > mapping_size || header->lines_offset % BINARY_PRE_ALIGNMENT != 0 ||
+        header->line_count != (mapping_size - header->lines_offset) / sizeof(binary_pre_line)) {
+        corrupted("linhas fora do arquivo");
+    }
+    records = (const binary_pre_line*) (mapping + header->lines_offset);
+
+    const binary_pre_string* table = (const binary_pre_string*) (mapping + header->strings_offset);
+    strings.reserve(header->string_count);
+    literals.reserve(header->string_count);
+    for (size_t id = 0; id < header->string_count; id++) {
+        if (table[id].offset > header->text_size || table[id].size > header->text_size - table[id].offset) {
+            corrupted("string " + to_string(id) + " fora da região de texto");
+        }
+        strings.emplace_back(mapping + header->text_offset + table[id].offset, table[id].size);
+        literals.push_back(parse_literal(strings.back()));
+    }
+    if (!strings[0].empty()) corrupted("a string 0 não é a vazia");
+
+    // Os índices são verificados aqui, e não a cada leitura
+    const uint32_t count = header->string_count;
+    for (size_t index = 0; index < header->line_count; index++) {
+        const binary_pre_line &record = records[index];
+        if ((uint32_t) record.label >= count || (uint32_t) record.operation >= count ||
+            (uint32_t) record.operand[0] >= count || (uint32_t) record.operand[1] >= count) {
+            corrupted("string inexistente na linha " + to_string(record.number));
+        }
+    }
+}
+
+void BinaryPre::corrupted(const string &reason) const {
+    throw invalid_argument("Arquivo .pre binário \"" + path + "\" inválido: " + reason);
+}
+
+void BinaryPre::read(size_t first, size_t count, vector<asm_line> &lines) const {
+    const size_t end = first + min(count, first < size() ? size() - first : 0);
+    for (size_t index = first; index < end; index++) {
+        const binary_pre_line &record = records[index];
+        lines.emplace_back();
+        asm_line &line = lines.back();
+        line.number = record.number;
+        line.label = strings[record.label];
+        line.operation = strings[record.operation];
+        for (int operand = 0; operand < 2; operand++) {
+            line.operand[operand] = strings[record.operand[operand]];
+            line.operand_literal[operand] = literals[record.operand[operand]];
+        }
+        line.opcode = record.opcode;
+        line.span = record.span;
+    }
+}
+
+vector<asm_line> BinaryPre::lines() const {
+    vector<asm_line> program_lines;
+    program_lines.reserve(size());
+    read(0, size(), program_lines);
+    return program_lines;
+}
+
+bool BinaryPre::is_binary(const char* data, size_t size) {
+    return size >= sizeof(binary_pre_header::magic) && memcmp(data, BINARY_PRE_MAGIC, sizeof(binary_pre_header::magic)) == 0;
+}
+
+bool BinaryPre::is_binary(const string &path) {
+    if (is_standard_stream(path)) return false;
+    const int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor == -1) return false;
+    char magic[sizeof(binary_pre_header::magic)];
+    const ssize_t result = ::read(descriptor, magic, sizeof(magic));
+    close(descriptor);
+    return result == (ssize_t) sizeof(magic) && is_binary(magic, sizeof(magic));
+}
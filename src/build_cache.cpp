@@ -0,0 +1,209 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <cerrno>
+#include <cstdlib>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "../include/build_cache.hpp"
+#include "../include/fnv_hash.hpp"
+#include "../include/mounter_exception.hpp"
+#include "../include/version.hpp"
+#include "../include/preprocesser.hpp"
+
+using namespace std;
+
+#define INSTRUCTIONS_PATH "data/instructions.txt"
+#define STATISTICS_FILE "estatisticas"
+
+namespace {
+    void hash_file(uint64_t &hash, string path) {
+        fstream file(path, fstream::in | fstream::binary);
+        if (!file.is_open()) {
+            throw invalid_argument("Não foi possível abrir o arquivo \"" + path + "\"");
+        }
+        char block[1 << 16];
+        while (file.read(block, sizeof(block)) || file.gcount() > 0) {
+            hash_bytes(hash, block, file.gcount());
+        }
+        // Separa o conteúdo dos arquivos, para que a concatenação não gere colisões triviais
+        hash_bytes(hash, "\0", 1);
+    }
+
+    // Adiciona ao hash os arquivos incluídos pelo arquivo fonte, recursivamente
+    // Um arquivo ausente também entra, pelo caminho, para que a chave mude quando ele for criado
+    void hash_includes(uint64_t &hash, string path, set<string> &visited) {
+        fstream file(path, fstream::in | fstream::binary);
+        string line;
+        while (getline(file, line)) {
+            const string name = Preprocesser::include_operand(line.data(), line.data() + line.length());
+            if (name.empty()) continue;
+            const string include_path = Preprocesser::resolve_include(path, name);
+            hash_bytes(hash, include_path.c_str(), include_path.length() + 1);
+
+            char *canonical = realpath(include_path.c_str(), nullptr);
+            if (canonical == nullptr) continue;
+            const bool first_visit = visited.insert(canonical).second;
+            free(canonical);
+            if (!first_visit) continue;
+            hash_file(hash, include_path);
+            hash_includes(hash, include_path, visited);
+        }
+    }
+}
+
+StreamCapture::StreamCapture(ostream &stream, string &copy) : stream(stream), original(stream.rdbuf()), copy(copy) {
+    stream.rdbuf(this);
+}
+
+StreamCapture::~StreamCapture() {
+    stream.rdbuf(original);
+}
+
+int StreamCapture::overflow(int character) {
+    if (character == EOF) return 0;
+    copy += (char) character;
+    return original->sputc(character);
+}
+
+streamsize StreamCapture::xsputn(const char* data, streamsize size) {
+    copy.append(data, size);
+    return original->sputn(data, size);
+}
+
+int StreamCapture::sync() {
+    return original->pubsync();
+}
+
+BuildCache::BuildCache(string directory, bool verbose/* = false */) : verbose(verbose), directory(directory) {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw invalid_argument("Não foi possível criar o diretório de cache \"" + directory + "\"");
+    }
+}
+
+string BuildCache::key(string source_path, string mode, string options) {
+    uint64_t hash = FNV_OFFSET;
+    hash_bytes(hash, ASSEMBLER_VERSION, sizeof(ASSEMBLER_VERSION));
+    hash_bytes(hash, mode.c_str(), mode.length() + 1);
+    hash_bytes(hash, options.c_str(), options.length() + 1);
+    // O préprocessador usa as tabelas embutidas, cobertas pela versão, e não lê o arquivo de instruções
+    if (mode != "-p") hash_file(hash, INSTRUCTIONS_PATH);
+    hash_file(hash, source_path);
+    // O resultado do préprocessamento também depende dos arquivos incluídos
+    if (mode == "-p") {
+        set<string> visited;
+        hash_includes(hash, source_path, visited);
+    }
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long) hash);
+    return string(hex);
+}
+
+string BuildCache::entry_path(string key, string extension) {
+    return directory + "/" + key + extension;
+}
+
+void BuildCache::atomic_write(string path, const string &content) {
+    const string temporary_path = path + ".tmp." + to_string(getpid());
+    fstream temporary(temporary_path, fstream::out | fstream::binary);
+    if (!temporary.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + temporary_path + "\"");
+    }
+    temporary << content;
+    temporary.close();
+    // A renomeação é atômica: outros processos veem o arquivo antigo ou o completo, nunca um pela metade
+    if (rename(temporary_path.c_str(), path.c_str()) != 0) {
+        remove(temporary_path.c_str());
+        throw invalid_argument("Não foi possível criar o arquivo \"" + path + "\"");
+    }
+}
+
+void BuildCache::atomic_copy(string source_path, string destination_path) {
+    fstream source(source_path, fstream::in | fstream::binary);
+    if (!source.is_open()) {
+        throw invalid_argument("Não foi possível abrir o arquivo \"" + source_path + "\"");
+    }
+    stringstream content;
+    content << source.rdbuf();
+    atomic_write(destination_path, content.str());
+}
+
+void BuildCache::count(bool hit) {
+    const string path = entry_path(STATISTICS_FILE, "");
+    const int descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (descriptor == -1) return;
+    // Trava exclusiva entre processos durante a leitura e a escrita dos contadores
+    flock(descriptor, LOCK_EX);
+
+    char buffer[64] = {0};
+    unsigned long long hits = 0, misses = 0;
+    if (pread(descriptor, buffer, sizeof(buffer) - 1, 0) > 0) {
+        sscanf(buffer, "%llu %llu", &hits, &misses);
+    }
+    (hit ? hits : misses)++;
+
+    const int length = snprintf(buffer, sizeof(buffer), "%llu %llu\n", hits, misses);
+    if (ftruncate(descriptor, 0) == 0) pwrite(descriptor, buffer, length, 0);
+
+    flock(descriptor, LOCK_UN);
+    close(descriptor);
+}
+
+void BuildCache::replay_messages(string key) {
+    fstream messages(entry_path(key, ".msg"), fstream::in | fstream::binary);
+    if (messages.is_open()) cerr << messages.rdbuf() << flush;
+}
+
+bool BuildCache::restore(string key, string output_path) {
+    // Compilações que falharam guardam apenas os erros
+    fstream error_entry(entry_path(key, ".err"), fstream::in);
+    if (error_entry.is_open()) {
+        count(true);
+        if (verbose) cout << "[" << __FILE__ << "]> Acerto no cache (" << key << "): reproduzindo os erros guardados" << endl;
+        replay_messages(key);
+        stringstream message;
+        message << error_entry.rdbuf();
+        throw MounterException(-1, "null", message.str());
+    }
+
+    const string output_entry = entry_path(key, ".out");
+    struct stat entry_status;
+    if (stat(output_entry.c_str(), &entry_status) == 0) {
+        count(true);
+        if (verbose) cout << "[" << __FILE__ << "]> Acerto no cache (" << key << "): copiando para \"" << output_path << "\"" << endl;
+        replay_messages(key);
+        atomic_copy(output_entry, output_path);
+        return true;
+    }
+
+    count(false);
+    if (verbose) cout << "[" << __FILE__ << "]> Falta no cache (" << key << ")" << endl;
+    return false;
+}
+
+void BuildCache::store_output(string key, string output_path, const string &messages) {
+    // As mensagens vêm antes, para que um acerto concorrente nunca encontre o resultado sem elas
+    if (!messages.empty()) atomic_write(entry_path(key, ".msg"), messages);
+    atomic_copy(output_path, entry_path(key, ".out"));
+}
+
+void BuildCache::store_error(string key, string message, const string &messages) {
+    if (!messages.empty()) atomic_write(entry_path(key, ".msg"), messages);
+    atomic_write(entry_path(key, ".err"), message);
+}
+
+string BuildCache::statistics() {
+    unsigned long long hits = 0, misses = 0;
+    fstream statistics_file(entry_path(STATISTICS_FILE, ""), fstream::in);
+    if (statistics_file.is_open()) statistics_file >> hits >> misses;
+
+    const unsigned long long total = hits + misses;
+    return "Cache em \"" + directory + "\": " + to_string(hits) + " acertos, " + to_string(misses) + " faltas"
+        + (total == 0 ? "" : " (taxa de acerto " + to_string(100 * hits / total) + "%)");
+}
@@ -0,0 +1,140 @@
+#include <climits>
+#include <algorithm>
+#include "../include/diagnostics.hpp"
+#include "../include/alloc_stats.hpp"
+
+using namespace std;
+
+namespace {
+    // Custo aproximado de um grupo, além das suas strings
+    const size_t GROUP_OVERHEAD = sizeof(diagnostic_group) + 64;
+
+    // Tamanho da entrada do log de uma ocorrência: "Na linha N, erro tipo: mensagem\n"
+    size_t entry_size(const string &type, const string &message) {
+        return 32 + type.length() + message.length();
+    }
+
+    // Custo de cada ocorrência guardada: a linha, a ordem de chegada e a entrada do log
+    size_t occurrence_cost(const string &type, const string &message) {
+        return sizeof(int) + sizeof(size_t) + entry_size(type, message);
+    }
+
+    // Custo de um grupo novo: a chave do índice, as strings e a entrada da primeira ocorrência
+    size_t group_cost(const string &type, const string &message, const string &file) {
+        return GROUP_OVERHEAD + 2 * (type.length() + message.length() + file.length() + 2) + entry_size(type, message) + file.length();
+    }
+
+    // Chave de um grupo no índice
+    string group_key(const string &type, const string &message, const string &file) {
+        return type + '\n' + file + '\n' + message;
+    }
+}
+
+Diagnostics::Diagnostics(size_t occurrences/* = DIAGNOSTIC_OCCURRENCES */, size_t budget/* = DIAGNOSTIC_BUDGET */) :
+    occurrence_limit(occurrences), budget(budget), used(0), total(0), dropped(0) {}
+
+void Diagnostics::add(int line, const string &type, const string &message) {
+    add(diagnostic {line, type, message});
+}
+
+void Diagnostics::add(const diagnostic &entry) {
+    ALLOC_SITE("diagnósticos");
+    total++;
+    const string key = group_key(entry.type, entry.message, entry.file);
+    auto index_entry = group_index.find(key);
+    if (index_entry == group_index.end()) {
+        const size_t cost = group_cost(entry.type, entry.message, entry.file);
+        if (used + cost > budget) {
+            dropped++;
+            return;
+        }
+        used += cost;
+        group_index.emplace(key, groups.size());
+        groups.push_back(diagnostic_group {entry.type, entry.message, entry.file, {entry.line}, {total}, 1});
+        return;
+    }
+
+    diagnostic_group &group = groups[index_entry->second];
+    group.count++;
+    if (group.lines.size() >= occurrence_limit) return;
+    const size_t cost = occurrence_cost(group.type, group.message);
+    if (used + cost > budget) return;
+    used += cost;
+    group.lines.push_back(entry.line);
+    group.arrivals.push_back(total);
+}
+
+diagnostic_group Diagnostics::extract(const string &type, const string &message) {
+    auto index_entry = group_index.find(group_key(type, message, ""));
+    if (index_entry == group_index.end()) return diagnostic_group {type, message, "", {}, {}, 0};
+
+    const size_t index = index_entry->second;
+    diagnostic_group group = move(groups[index]);
+    groups.erase(groups.begin() + index);
+    group_index.erase(index_entry);
+    // Os grupos seguintes mudam de posição
+    for (auto &entry : group_index) {
+        if (entry.second > index) entry.second--;
+    }
+    total -= group.count;
+    used -= group_cost(group.type, group.message, group.file) + (group.lines.size() - 1) * occurrence_cost(group.type, group.message);
+    return group;
+}
+
+void Diagnostics::clear() {
+    groups.clear();
+    group_index.clear();
+    used = total = dropped = 0;
+}
+
+void append_log(string &log, const vector<diagnostic> &diagnostics, const string &label/* = "erro" */) {
+    for (const diagnostic &entry : diagnostics) {
+        if (entry.line == -1) log += "Erro ";
+        else log += "Na linha " + to_string(entry.line) + (entry.file.empty() ? "" : " de " + entry.file) + ", " + label + " ";
+        log += entry.type + ": " + entry.message + "\n";
+    }
+}
+
+void Diagnostics::append_to(vector<diagnostic> &diagnostics) const {
+    ALLOC_SITE("diagnósticos");
+    // Ocorrências guardadas de todos os grupos: linha, ordem de chegada, grupo e posição no grupo
+    struct occurrence {
+        int line;
+        size_t arrival;
+        size_t group;
+    };
+    vector<occurrence> occurrences;
+    for (size_t group = 0; group < groups.size(); group++) {
+        for (size_t index = 0; index < groups[group].lines.size(); index++) {
+            occurrences.push_back(occurrence {groups[group].lines[index], groups[group].arrivals[index], group});
+        }
+    }
+    sort(occurrences.begin(), occurrences.end(), [](const occurrence &left, const occurrence &right) {
+        const int left_line = left.line == -1 ? INT_MAX : left.line;
+        const int right_line = right.line == -1 ? INT_MAX : right.line;
+        return left_line != right_line ? left_line < right_line : left.arrival < right.arrival;
+    });
+    // Última ocorrência relatada de cada grupo, após a qual vem o resumo das omitidas
+    vector<size_t> last(groups.size());
+    for (size_t position = 0; position < occurrences.size(); position++) last[occurrences[position].group] = position;
+
+    for (size_t position = 0; position < occurrences.size(); position++) {
+        const diagnostic_group &group = groups[occurrences[position].group];
+        diagnostics.push_back(diagnostic {occurrences[position].line, group.type, group.message, group.file});
+        if (last[occurrences[position].group] == position && group.count > group.lines.size()) {
+            const size_t omitted = group.count - group.lines.size();
+            diagnostics.back().message += "\n\t(mais " + to_string(omitted) + (omitted == 1 ? " ocorrência deste erro omitida)" : " ocorrências deste erro omitidas)");
+        }
+    }
+    if (dropped > 0) {
+        diagnostics.push_back(diagnostic {-1, "diagnóstico",
+            to_string(dropped) + " erros omitidos ao atingir o limite de " + to_string(budget / 1024) + " KiB para diagnósticos"
+        });
+    }
+}
+
+void Diagnostics::append_to(string &log) const {
+    vector<diagnostic> diagnostics;
+    append_to(diagnostics);
+    append_log(log, diagnostics);
+}
@@ -0,0 +1,83 @@
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+#include "../include/file_io.hpp"
+#include "../include/mounter_exception.hpp"
+
+using namespace std;
+
+size_t extension_start(const string &path) {
+    const size_t dot = path.rfind('.');
+    const size_t slash = path.rfind('/');
+    // Um ponto em um diretório, como em "./build/x", não inicia extensão
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return string::npos;
+    return dot;
+}
+
+bool has_extension(const string &path, const string &extension) {
+    const size_t dot = extension_start(path);
+    return dot != string::npos && path.compare(dot, string::npos, extension) == 0;
+}
+
+string base_name(const string &path) {
+    const size_t slash = path.rfind('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+string replace_extension(const string &path, const string &suffix) {
+    if (is_standard_stream(path)) return path;
+    return path.substr(0, extension_start(path)) + suffix;
+}
+
+string read_input(const string &path) {
+    if (!is_standard_stream(path)) {
+        fstream source(path, fstream::in | fstream::binary);
+        if (!source.is_open()) {
+            throw MounterException(-1, "null", "Falha ao abrir arquivo \"" + path + "\"");
+        }
+        stringstream content;
+        content << source.rdbuf();
+        return content.str();
+    }
+
+    string content;
+    size_t length = 0;
+    while (true) {
+        // Lê direto no fim do texto, sem buffer intermediário
+        content.resize(length + STANDARD_STREAM_BLOCK);
+        const ssize_t result = read(0, &content[length], STANDARD_STREAM_BLOCK);
+        if (result == -1 && errno == EINTR) continue;
+        if (result == -1) {
+            throw invalid_argument("Falha ao ler a entrada padrão: " + string(strerror(errno)));
+        }
+        if (result == 0) break;
+        length += result;
+    }
+    content.resize(length);
+    return content;
+}
+
+void write_output(const string &path, const string &text) {
+    if (!is_standard_stream(path)) {
+        fstream output(path, fstream::out);
+        if (!output.is_open()) {
+            throw invalid_argument("Não foi possível criar o arquivo \"" + path + "\"");
+        }
+        output << text;
+        return;
+    }
+
+    size_t written = 0;
+    while (written < text.length()) {
+        const size_t block = min<size_t>(text.length() - written, STANDARD_STREAM_BLOCK);
+        const ssize_t result = write(1, text.data() + written, block);
+        if (result == -1 && errno == EINTR) continue;
+        if (result == -1) {
+            throw invalid_argument("Falha ao escrever na saída padrão: " + string(strerror(errno)));
+        }
+        written += result;
+    }
+}
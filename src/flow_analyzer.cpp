@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstdint>
+#include "../include/flow_analyzer.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+
+namespace {
+    // Efeito de uma instrução sobre a memória e o fluxo de controle
+    struct instruction_effect {
+        // Indica, para cada operando, se ele é lido
+        bool reads[2];
+        // Indica, para cada operando, se ele é escrito
+        bool writes[2];
+        // Indica se o primeiro operando é destino de salto
+        bool jumps;
+        // Indica se a execução pode seguir para a próxima instrução
+        bool falls_through;
+    };
+
+    // Efeitos das instruções, pelo nome registrado no arquivo de instruções
+    const map<string, instruction_effect> effects = {
+        {"ADD",    {{true, false},  {false, false}, false, true}},
+        {"SUB",    {{true, false},  {false, false}, false, true}},
+        {"MULT",   {{true, false},  {false, false}, false, true}},
+        {"DIV",    {{true, false},  {false, false}, false, true}},
+        {"JMP",    {{false, false}, {false, false}, true,  false}},
+        {"JMPN",   {{false, false}, {false, false}, true,  true}},
+        {"JMPP",   {{false, false}, {false, false}, true,  true}},
+        {"JMPZ",   {{false, false}, {false, false}, true,  true}},
+        {"COPY",   {{true, false},  {false, true},  false, true}},
+        {"LOAD",   {{true, false},  {false, false}, false, true}},
+        {"STORE",  {{false, false}, {true, false},  false, true}},
+        {"INPUT",  {{false, false}, {true, false},  false, true}},
+        {"OUTPUT", {{true, false},  {false, false}, false, true}},
+        {"STOP",   {{false, false}, {false, false}, false, false}},
+    };
+
+    // Tipo do conteúdo de um endereço do programa
+    enum address_kind : char {NOTHING, INSTRUCTION, SPACE_WORD, CONST_WORD};
+
+    // Conteúdo de um endereço: o tipo e a instrução ou declaração de dados a que ele pertence, -1 se nenhuma
+    struct address_content {
+        address_kind kind;
+        int owner;
+    };
+}
+
+void FlowAnalyzer::add_instruction(const asm_line &line, int address) {
+    instructions.push_back(flow_instruction {line.number, address, line.operation, {line.operand[0], line.operand[1]}});
+}
+
+void FlowAnalyzer::add_data(const asm_line &line, int address) {
+    data.push_back(flow_data_word {line.number, address, line.operation == "CONST", line.span});
+}
+
+vector<MounterException> FlowAnalyzer::analyze(const map<string, int> &symbol_table, int program_size, const map<string, int> &public_symbols, const set<string> &extern_symbols) {
+    vector<MounterException> warnings;
+
+    // O que há em um endereço. A busca é binária nas instruções e declarações, ambas em ordem de endereço, e não em um mapa
+    // de todos os endereços, que SPACE N tornaria do tamanho do bloco
+    auto content_at = [&](int address) {
+        // Todas as palavras de um bloco pertencem à mesma declaração
+        auto data_entry = upper_bound(data.begin(), data.end(), address,
+            [](int address, const flow_data_word &word) { return address < word.address; }
+        );
+        if (data_entry != data.begin() && address - (data_entry - 1)->address < (data_entry - 1)->span) {
+            return address_content {(data_entry - 1)->constant ? CONST_WORD : SPACE_WORD, (int) (data_entry - data.begin()) - 1};
+        }
+        // Só a primeira palavra de uma instrução é o seu início
+        auto instruction_entry = lower_bound(instructions.begin(), instructions.end(), address,
+            [](const flow_instruction &instruction, int address) { return instruction.address < address; }
+        );
+        if (instruction_entry != instructions.end() && instruction_entry->address == address) {
+            return address_content {INSTRUCTION, (int) (instruction_entry - instructions.begin())};
+        }
+        return address_content {NOTHING, -1};
+    };
+
+    // Resolve um operando para um endereço, -1 se não for um rótulo deste programa. Os símbolos externos estão em outros módulos
+    auto resolve = [&](const string &operand) {
+        if (!ANY(operand) || extern_symbols.count(operand) > 0) return -1;
+        auto symbol_entry = symbol_table.find(operand);
+        if (symbol_entry == symbol_table.end() || symbol_entry->second >= program_size) return -1;
+        return symbol_entry->second;
+    };
+
+    // Construção do grafo: cada instrução tem até dois sucessores, a seguinte e o destino do salto
+    const int none = -1;
+    vector<int> successors(2 * instructions.size(), none);
+    vector<const instruction_effect*> effect_of(instructions.size(), nullptr);
+    for (size_t index = 0; index < instructions.size(); index++) {
+        const flow_instruction &instruction = instructions[index];
+        auto effect_entry = effects.find(instruction.operation);
+        if (effect_entry == effects.end()) continue;
+        const instruction_effect &effect = effect_entry->second;
+        effect_of[index] = &effect;
+
+        if (effect.falls_through && index + 1 < instructions.size()) successors[2 * index] = index + 1;
+        if (!effect.jumps) continue;
+
+        const int target = resolve(instruction.operand[0]);
+        if (target == -1) continue;
+        const address_content content = content_at(target);
+        if (content.kind == SPACE_WORD || content.kind == CONST_WORD) {
+            warnings.push_back(MounterException(instruction.line, "semântico",
+                "Salto para o rótulo \"" + instruction.operand[0] + "\", que está na seção de dados"
+            ));
+        }
+        else if (content.kind != INSTRUCTION) {
+            warnings.push_back(MounterException(instruction.line, "semântico",
+                "Salto para o rótulo \"" + instruction.operand[0] + "\", que não está no início de uma instrução"
+            ));
+        }
+        else successors[2 * index + 1] = content.owner;
+    }
+
+    // Raízes: a primeira instrução e as instruções públicas, que outros módulos podem chamar
+    vector<int> roots;
+    if ANY(instructions) roots.push_back(0);
+    // Palavras SPACE públicas podem ser escritas por outros módulos a qualquer momento
+    vector<bool> external(data.size(), false);
+    for (const auto &public_symbol : public_symbols) {
+        const int address = resolve(public_symbol.first);
+        if (address == -1) continue;
+        const address_content content = content_at(address);
+        if (content.kind == INSTRUCTION) roots.push_back(content.owner);
+        else if (content.kind == SPACE_WORD) external[content.owner] = true;
+    }
+
+    // Alcançabilidade a partir das raízes, por lista de trabalho
+    vector<bool> reachable(instructions.size(), false);
+    vector<int> worklist;
+    for (const int root : roots) {
+        if (reachable[root]) continue;
+        reachable[root] = true;
+        worklist.push_back(root);
+    }
+    while (ANY(worklist)) {
+        const int index = worklist.back();
+        worklist.pop_back();
+        for (int successor : {successors[2 * index], successors[2 * index + 1]}) {
+            if (successor != none && !reachable[successor]) {
+                reachable[successor] = true;
+                worklist.push_back(successor);
+            }
+        }
+    }
+
+    // Código inalcançável, reportado por bloco contíguo
+    for (size_t index = 0; index < instructions.size(); index++) {
+        if (reachable[index]) continue;
+        const size_t first = index;
+        while (index + 1 < instructions.size() && !reachable[index + 1]) index++;
+        const int first_line = instructions[first].line;
+        const int last_line = instructions[index].line;
+        warnings.push_back(MounterException(first_line, "semântico",
+            first_line == last_line ? "Código inalcançável"s
+            : "Código inalcançável até a linha " + to_string(last_line)
+        ));
+    }
+
+    // Acessos à memória das instruções alcançáveis
+    vector<bool> written(data.size(), false);
+    vector<bool> read(data.size(), false);
+    // Declaração SPACE acessada por um operando, -1 se o operando não for um SPACE deste programa
+    auto space_of = [&](const string &operand) {
+        const int address = resolve(operand);
+        if (address == -1) return -1;
+        const address_content content = content_at(address);
+        return content.kind == SPACE_WORD ? content.owner : -1;
+    };
+    for (size_t index = 0; index < instructions.size(); index++) {
+        if (!reachable[index] || effect_of[index] == nullptr) continue;
+        const flow_instruction &instruction = instructions[index];
+        const instruction_effect &effect = *effect_of[index];
+
+        for (int operand = 0; operand < 2; operand++) {
+            const int address = resolve(instruction.operand[operand]);
+            if (address == -1) continue;
+            const address_content content = content_at(address);
+
+            if (effect.writes[operand]) {
+                if (content.kind == CONST_WORD) {
+                    warnings.push_back(MounterException(instruction.line, "semântico",
+                        "Escrita no rótulo \"" + instruction.operand[operand] + "\", declarado como CONST"
+                    ));
+                }
+                else if (content.kind == SPACE_WORD) written[content.owner] = true;
+            }
+            if (effect.reads[operand] && content.kind == SPACE_WORD) read[content.owner] = true;
+        }
+    }
+
+    // SPACEs lidos e nunca escritos são avisados em toda leitura. Os lidos e escritos passam pela análise de fluxo de dados
+    vector<int> tracked(data.size(), -1);
+    size_t tracked_count = 0;
+    for (size_t index = 0; index < data.size(); index++) {
+        if (read[index] && written[index] && !external[index]) tracked[index] = tracked_count++;
+    }
+
+    // Blocos básicos: começam nas raízes, nos destinos de saltos e depois de saltos e paradas
+    vector<bool> leader(instructions.size(), false);
+    for (const int root : roots) leader[root] = true;
+    for (size_t index = 0; index < instructions.size(); index++) {
+        if (successors[2 * index + 1] != none) leader[successors[2 * index + 1]] = true;
+        if (index + 1 < instructions.size() && (effect_of[index] == nullptr || effect_of[index]->jumps || !effect_of[index]->falls_through)) {
+            leader[index + 1] = true;
+        }
+    }
+    vector<int> block_start;
+    vector<int> block_of(instructions.size());
+    for (size_t index = 0; index < instructions.size(); index++) {
+        if (leader[index] || index == 0) block_start.push_back(index);
+        block_of[index] = block_start.size() - 1;
+    }
+    block_start.push_back(instructions.size());
+    const size_t blocks = block_start.size() - 1;
+
+    // Fluxo de dados para a frente: SPACEs certamente escritos na entrada de cada bloco, por todos os caminhos desde uma raiz
+    // O conjunto de cada bloco começa cheio e só diminui, então a lista de trabalho termina
+    const size_t words = (tracked_count + 63) / 64;
+    const bool dataflow = tracked_count > 0 && blocks * words * 64 <= FLOW_DATAFLOW_BITS;
+    vector<uint64_t> entry_state(dataflow ? blocks * words : 0, ~0ULL);
+    vector<bool> visited(dataflow ? blocks : 0, false);
+    vector<uint64_t> state(words);
+    // Aplica as escritas de um bloco ao estado, avisando, se pedido, das leituras de SPACEs ainda não escritos
+    auto transfer = [&](size_t block, bool report) {
+        for (int index = block_start[block]; index < block_start[block + 1]; index++) {
+            if (effect_of[index] == nullptr) continue;
+            const flow_instruction &instruction = instructions[index];
+            for (int operand = 0; operand < 2; operand++) {
+                if (!report || !effect_of[index]->reads[operand]) continue;
+                const int space = space_of(instruction.operand[operand]);
+                if (space == -1 || tracked[space] == -1) continue;
+                if (!(state[tracked[space] / 64] >> (tracked[space] % 64) & 1)) {
+                    warnings.push_back(MounterException(instruction.line, "semântico",
+                        "Leitura do rótulo \"" + instruction.operand[operand] + "\", declarado como SPACE, antes de ser escrito em algum caminho"
+                    ));
+                }
+            }
+            for (int operand = 0; operand < 2; operand++) {
+                if (!effect_of[index]->writes[operand]) continue;
+                const int space = space_of(instruction.operand[operand]);
+                if (space != -1 && tracked[space] != -1) state[tracked[space] / 64] |= 1ULL << (tracked[space] % 64);
+            }
+        }
+    };
+    if (dataflow) {
+        vector<int> pending;
+        for (const int root : roots) {
+            const int block = block_of[root];
+            if (visited[block]) continue;
+            visited[block] = true;
+            fill(entry_state.begin() + block * words, entry_state.begin() + (block + 1) * words, 0);
+            pending.push_back(block);
+        }
+        while (ANY(pending)) {
+            const size_t block = pending.back();
+            pending.pop_back();
+            copy(entry_state.begin() + block * words, entry_state.begin() + (block + 1) * words, state.begin());
+            transfer(block, false);
+            const int last = block_start[block + 1] - 1;
+            for (const int successor : {successors[2 * last], successors[2 * last + 1]}) {
+                if (successor == none) continue;
+                const size_t next = block_of[successor];
+                bool changed = !visited[next];
+                visited[next] = true;
+                for (size_t word = 0; word < words; word++) {
+                    const uint64_t meet = entry_state[next * words + word] & state[word];
+                    if (meet != entry_state[next * words + word]) changed = true;
+                    entry_state[next * words + word] = meet;
+                }
+                if (changed) pending.push_back(next);
+            }
+        }
+        // Com os estados estáveis, cada bloco alcançado é percorrido uma última vez para os avisos
+        for (size_t block = 0; block < blocks; block++) {
+            if (!visited[block]) continue;
+            copy(entry_state.begin() + block * words, entry_state.begin() + (block + 1) * words, state.begin());
+            transfer(block, true);
+        }
+    }
+
+    for (size_t index = 0; index < instructions.size(); index++) {
+        if (!reachable[index] || effect_of[index] == nullptr) continue;
+        const flow_instruction &instruction = instructions[index];
+        for (int operand = 0; operand < 2; operand++) {
+            if (!effect_of[index]->reads[operand]) continue;
+            const int space = space_of(instruction.operand[operand]);
+            if (space == -1 || written[space] || external[space]) continue;
+            warnings.push_back(MounterException(instruction.line, "semântico",
+                "Leitura do rótulo \"" + instruction.operand[operand] + "\", declarado como SPACE e nunca escrito"
+            ));
+        }
+    }
+
+    // Avisos em ordem de linha
+    stable_sort(warnings.begin(), warnings.end(),
+        [](const MounterException &a, const MounterException &b) { return a.get_line() < b.get_line(); }
+    );
+    return warnings;
+}
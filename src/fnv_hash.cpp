@@ -0,0 +1,16 @@
+#include "../include/fnv_hash.hpp"
+
+#define FNV_PRIME 1099511628211ULL
+
+void hash_bytes(uint64_t &hash, const char* data, size_t size) {
+    for (size_t index = 0; index < size; index++) {
+        hash ^= (unsigned char) data[index];
+        hash *= FNV_PRIME;
+    }
+}
+
+uint64_t fnv_hash(const char* data, size_t size) {
+    uint64_t hash = FNV_OFFSET;
+    hash_bytes(hash, data, size);
+    return hash;
+}
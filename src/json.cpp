@@ -0,0 +1,224 @@
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include "../include/json.hpp"
+
+using namespace std;
+
+namespace {
+    // Leitor recursivo, que avança a posição no texto
+    class json_reader {
+        const string &text;
+        size_t position;
+
+        void skip_spaces() {
+            while (position < text.length() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) position++;
+        }
+
+        [[noreturn]] void fail(const string &reason) {
+            throw invalid_argument("JSON inválido na posição " + to_string(position) + ": " + reason);
+        }
+
+        void expect(char symbol) {
+            skip_spaces();
+            if (position >= text.length() || text[position] != symbol) fail(string("esperava '") + symbol + "'");
+            position++;
+        }
+
+        // Acrescenta um ponto de código em UTF-8
+        void append_utf8(string &output, unsigned code) {
+            if (code < 0x80) output += (char) code;
+            else if (code < 0x800) {
+                output += (char) (0xC0 | (code >> 6));
+                output += (char) (0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000) {
+                output += (char) (0xE0 | (code >> 12));
+                output += (char) (0x80 | ((code >> 6) & 0x3F));
+                output += (char) (0x80 | (code & 0x3F));
+            }
+            else {
+                output += (char) (0xF0 | (code >> 18));
+                output += (char) (0x80 | ((code >> 12) & 0x3F));
+                output += (char) (0x80 | ((code >> 6) & 0x3F));
+                output += (char) (0x80 | (code & 0x3F));
+            }
+        }
+
+        unsigned read_hex() {
+            if (position + 4 > text.length()) fail("escape \\u incompleto");
+            const string digits = text.substr(position, 4);
+            char *end;
+            const unsigned code = strtoul(digits.c_str(), &end, 16);
+            if (end != digits.c_str() + 4) fail("escape \\u inválido");
+            position += 4;
+            return code;
+        }
+
+        string read_string() {
+            expect('"');
+            string output;
+            while (true) {
+                if (position >= text.length()) fail("string sem fim");
+                const char symbol = text[position++];
+                if (symbol == '"') return output;
+                if (symbol != '\\') {
+                    output += symbol;
+                    continue;
+                }
+                if (position >= text.length()) fail("escape sem fim");
+                const char escaped = text[position++];
+                switch (escaped) {
+                    case 'n': output += '\n'; break;
+                    case 't': output += '\t'; break;
+                    case 'r': output += '\r'; break;
+                    case 'b': output += '\b'; break;
+                    case 'f': output += '\f'; break;
+                    case 'u': {
+                        unsigned code = read_hex();
+                        // Par substituto do UTF-16
+                        if (code >= 0xD800 && code < 0xDC00 && text.compare(position, 2, "\\u") == 0) {
+                            position += 2;
+                            const unsigned low = read_hex();
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        append_utf8(output, code);
+                        break;
+                    }
+                    default: output += escaped;
+                }
+            }
+        }
+
+        public:
+        json_reader(const string &text) : text(text), position(0) {}
+
+        json_value read_value() {
+            skip_spaces();
+            if (position >= text.length()) fail("valor ausente");
+            json_value value;
+            const char symbol = text[position];
+            if (symbol == '{') {
+                value.kind = json_value::OBJECT_VALUE;
+                position++;
+                skip_spaces();
+                if (position < text.length() && text[position] == '}') {
+                    position++;
+                    return value;
+                }
+                while (true) {
+                    skip_spaces();
+                    const string name = read_string();
+                    expect(':');
+                    value.members[name] = read_value();
+                    skip_spaces();
+                    if (position < text.length() && text[position] == ',') position++;
+                    else break;
+                }
+                expect('}');
+            }
+            else if (symbol == '[') {
+                value.kind = json_value::ARRAY_VALUE;
+                position++;
+                skip_spaces();
+                if (position < text.length() && text[position] == ']') {
+                    position++;
+                    return value;
+                }
+                while (true) {
+                    value.items.push_back(read_value());
+                    skip_spaces();
+                    if (position < text.length() && text[position] == ',') position++;
+                    else break;
+                }
+                expect(']');
+            }
+            else if (symbol == '"') {
+                value.kind = json_value::STRING_VALUE;
+                value.text = read_string();
+            }
+            else if (text.compare(position, 4, "true") == 0 || text.compare(position, 5, "false") == 0) {
+                value.kind = json_value::BOOLEAN_VALUE;
+                value.boolean = (symbol == 't');
+                position += (value.boolean ? 4 : 5);
+            }
+            else if (text.compare(position, 4, "null") == 0) {
+                position += 4;
+            }
+            else {
+                const char *start = text.c_str() + position;
+                char *end;
+                value.kind = json_value::NUMBER_VALUE;
+                value.number = strtod(start, &end);
+                if (end == start) fail("valor inesperado");
+                position += end - start;
+            }
+            return value;
+        }
+
+        void finish() {
+            skip_spaces();
+            if (position != text.length()) fail("conteúdo após o fim do valor");
+        }
+    };
+}
+
+const json_value& json_value::operator[](const string &name) const {
+    static const json_value null_value;
+    auto member = members.find(name);
+    return member == members.end() ? null_value : member->second;
+}
+
+string json_value::dump() const {
+    switch (kind) {
+        case BOOLEAN_VALUE: return boolean ? "true" : "false";
+        case NUMBER_VALUE: {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.17g", number);
+            return buffer;
+        }
+        case STRING_VALUE: return json_quote(text);
+        case ARRAY_VALUE: {
+            string output = "[";
+            for (size_t index = 0; index < items.size(); index++) output += (index == 0 ? "" : ",") + items[index].dump();
+            return output + "]";
+        }
+        case OBJECT_VALUE: {
+            string output = "{";
+            for (auto member = members.begin(); member != members.end(); member++) {
+                output += (member == members.begin() ? "" : ",") + json_quote(member->first) + ":" + member->second.dump();
+            }
+            return output + "}";
+        }
+        default: return "null";
+    }
+}
+
+json_value parse_json(const string &text) {
+    json_reader reader(text);
+    json_value value = reader.read_value();
+    reader.finish();
+    return value;
+}
+
+string json_quote(const string &text) {
+    string output = "\"";
+    for (const char symbol : text) {
+        switch (symbol) {
+            case '"': output += "\\\""; break;
+            case '\\': output += "\\\\"; break;
+            case '\n': output += "\\n"; break;
+            case '\t': output += "\\t"; break;
+            case '\r': output += "\\r"; break;
+            default:
+                if ((unsigned char) symbol < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", symbol);
+                    output += buffer;
+                }
+                else output += symbol;
+        }
+    }
+    return output + "\"";
+}
@@ -0,0 +1,624 @@
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <unistd.h>
+#include <poll.h>
+#include "../include/language_server.hpp"
+#include "../include/operation_supplier.hpp"
+#include "../include/version.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+
+namespace {
+    // Posições do LSP contam unidades de UTF-16, e as linhas são guardadas em UTF-8
+    // Converte uma coluna em UTF-16 para a posição em bytes na linha
+    size_t byte_offset(const string &line, int character) {
+        size_t position = 0;
+        for (int units = 0; position < line.length() && units < character; ) {
+            const unsigned char lead = line[position];
+            const size_t length = (lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4);
+            units += (length == 4 ? 2 : 1);
+            position += length;
+        }
+        return min(position, line.length());
+    }
+
+    // Converte uma posição em bytes na linha para uma coluna em UTF-16
+    int utf16_column(const string &line, size_t bytes) {
+        int units = 0;
+        for (size_t position = 0; position < bytes && position < line.length(); ) {
+            const unsigned char lead = line[position];
+            const size_t length = (lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4);
+            units += (length == 4 ? 2 : 1);
+            position += length;
+        }
+        return units;
+    }
+
+    string range_json(int line, int start, int end) {
+        return "{\"start\":{\"line\":" + to_string(line) + ",\"character\":" + to_string(start)
+            + "},\"end\":{\"line\":" + to_string(line) + ",\"character\":" + to_string(end) + "}}";
+    }
+
+    // Caminho local de uma URI file://, com os escapes de porcentagem resolvidos
+    string uri_path(const string &uri) {
+        const string encoded = (uri.compare(0, 7, "file://") == 0 ? uri.substr(7) : uri);
+        string path;
+        for (size_t position = 0; position < encoded.length(); position++) {
+            if (encoded[position] == '%' && position + 2 < encoded.length()) {
+                path += (char) stoi(encoded.substr(position + 1, 2), nullptr, 16);
+                position += 2;
+            }
+            else path += encoded[position];
+        }
+        return path;
+    }
+
+    bool is_symbol_character(char symbol) {
+        return isalnum((unsigned char) symbol) || symbol == '_';
+    }
+
+    // Indica se duas separações da mesma linha têm os mesmos elementos e erros
+    bool same_scan(const document_line &before, const document_line &after) {
+        if (before.has_operation != after.has_operation || before.stray_label != after.stray_label || before.errors.size() != after.errors.size()) return false;
+        if (after.has_operation && (before.tokens.label != after.tokens.label || before.tokens.operation != after.tokens.operation ||
+            before.tokens.operand[0] != after.tokens.operand[0] || before.tokens.operand[1] != after.tokens.operand[1])) return false;
+        for (size_t index = 0; index < after.errors.size(); index++) {
+            if (before.errors[index].type != after.errors[index].type || before.errors[index].message != after.errors[index].message) return false;
+        }
+        return true;
+    }
+
+    // Intervalo em bytes da ocorrência de um rótulo como palavra inteira, antes do comentário. npos se não houver
+    size_t find_symbol(const string &line, const string &name) {
+        string upper = line.substr(0, line.find(';'));
+        transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return toupper(c); });
+        for (size_t position = upper.find(name); position != string::npos; position = upper.find(name, position + 1)) {
+            const bool starts = (position == 0 || !is_symbol_character(upper[position - 1]));
+            const bool ends = (position + name.length() == upper.length() || !is_symbol_character(upper[position + name.length()]));
+            if (starts && ends) return position;
+        }
+        return string::npos;
+    }
+
+    // Bloco e posição no bloco de uma linha do documento. Linhas além do fim ficam no último bloco
+    pair<size_t, size_t> locate(const vector<document_chunk> &chunks, size_t line) {
+        size_t chunk = 0;
+        while (chunk + 1 < chunks.size() && line >= chunks[chunk].lines.size()) {
+            line -= chunks[chunk].lines.size();
+            chunk++;
+        }
+        return {chunk, line};
+    }
+
+    // Linha do documento, ou nullptr se ela não existir
+    const document_line* find_line(const open_document &document, int line) {
+        if (line < 0 || line >= (int) document.line_count) return nullptr;
+        const pair<size_t, size_t> position = locate(document.chunks, line);
+        return &document.chunks[position.first].lines[position.second];
+    }
+
+    // Refaz o índice de símbolos e a contagem de linhas com diagnósticos de um bloco
+    void index_chunk(document_chunk &chunk) {
+        chunk.definitions.clear();
+        chunk.references.clear();
+        chunk.diagnosed = 0;
+        for (size_t index = 0; index < chunk.lines.size(); index++) {
+            const document_line &line = chunk.lines[index];
+            if (ANY(line.errors) || line.label_conflict || ANY(line.analysis_errors) || ANY(line.analysis_warnings)) chunk.diagnosed++;
+            if ANY(line.stray_label) chunk.definitions.emplace(line.stray_label, index);
+            if (!line.has_operation) continue;
+            if ANY(line.tokens.label) chunk.definitions.emplace(line.tokens.label, index);
+            for (int operand = 0; operand < 2; operand++) {
+                if (ANY(line.tokens.operand[operand]) && line.tokens.operand_literal[operand].kind == NOT_LITERAL && line.tokens.operation != "INCLUDE") {
+                    chunk.references[line.tokens.operand[operand]].push_back(index);
+                }
+            }
+        }
+        chunk.indexed = true;
+    }
+
+    // Rótulo pendente antes de uma linha: o da linha de rótulo mais próxima, se não houver operação entre elas
+    string pending_label(const vector<document_chunk> &chunks, size_t chunk, size_t line) {
+        while (true) {
+            if (line == 0) {
+                if (chunk == 0) return "";
+                chunk--;
+                line = chunks[chunk].lines.size();
+                continue;
+            }
+            const document_line &previous = chunks[chunk].lines[--line];
+            if ANY(previous.stray_label) return previous.stray_label;
+            if (previous.has_operation) return "";
+        }
+    }
+
+    // Entrada JSON de um diagnóstico na linha fornecida (a partir de 0), que vai até o fim do texto da linha, se houver
+    string diagnostic_json(int line, const document_line *text_line, const diagnostic &entry, int severity) {
+        const int end = (text_line == nullptr ? 0 : utf16_column(text_line->text, text_line->text.length()));
+        return "{\"range\":" + range_json(line, 0, end) + ",\"severity\":" + to_string(severity)
+            + ",\"source\":\"montador\",\"message\":" + json_quote(entry.type + ": " + entry.message) + "}";
+    }
+}
+
+LanguageServer::LanguageServer(bool verbose/* = false */) :
+    verbose(verbose), tables(OperationSupplier::supply_shared_tables()), preprocesser(tables), assembler(tables), shutdown_requested(false) {
+    preprocesser.set_line_cache(&line_cache);
+    assembler.set_analysis(true);
+}
+
+bool LanguageServer::read_message(string &message) {
+    char buffer[65536];
+    while (true) {
+        // Cabeçalhos terminam com uma linha vazia, e o Content-Length dá o tamanho do corpo
+        const size_t header_end = input.find("\r\n\r\n");
+        if (header_end != string::npos) {
+            size_t length = 0;
+            const size_t field = input.find("Content-Length:");
+            if (field != string::npos && field < header_end) length = stoul(input.substr(field + 15));
+            if (input.length() >= header_end + 4 + length) {
+                message = input.substr(header_end + 4, length);
+                input.erase(0, header_end + 4 + length);
+                return true;
+            }
+        }
+        const ssize_t received = read(0, buffer, sizeof(buffer));
+        if (received <= 0) return false;
+        input.append(buffer, received);
+    }
+}
+
+bool LanguageServer::input_pending(int milliseconds/* = 0 */) {
+    if (input.find("\r\n\r\n") != string::npos) return true;
+    pollfd waiting {0, POLLIN, 0};
+    return poll(&waiting, 1, milliseconds) > 0;
+}
+
+void LanguageServer::send(const string &message) {
+    const string packet = "Content-Length: " + to_string(message.length()) + "\r\n\r\n" + message;
+    for (size_t written = 0; written < packet.length(); ) {
+        const ssize_t result = write(1, packet.data() + written, packet.length() - written);
+        if (result <= 0) return;
+        written += result;
+    }
+}
+
+void LanguageServer::respond(const json_value &id, const string &result) {
+    send("{\"jsonrpc\":\"2.0\",\"id\":" + id.dump() + ",\"result\":" + result + "}");
+}
+
+void LanguageServer::respond_error(const json_value &id, int code, const string &message) {
+    send("{\"jsonrpc\":\"2.0\",\"id\":" + id.dump() + ",\"error\":{\"code\":" + to_string(code) + ",\"message\":" + json_quote(message) + "}}");
+}
+
+int LanguageServer::serve() {
+    // O protocolo ocupa a saída padrão, então impressões de outros módulos vão para a saída de erros
+    streambuf *standard_output = cout.rdbuf(cerr.rdbuf());
+    string message;
+    int status = 1;
+    while (true) {
+        // Edições seguidas são juntadas em uma única atualização
+        if (!input_pending()) {
+            bool stale = false;
+            for (auto &document : documents) {
+                if (document.second.dirty) update(document.first, document.second);
+                stale = stale || document.second.stale;
+            }
+            // A análise completa espera o editor ficar ocioso
+            if (stale && !input_pending(LSP_IDLE_MS)) {
+                for (auto &document : documents) {
+                    if (document.second.stale) analyze(document.first, document.second);
+                }
+            }
+        }
+        if (!read_message(message)) break;
+        json_value request;
+        try {
+            request = parse_json(message);
+        }
+        catch (invalid_argument &error) {
+            respond_error(json_value(), -32700, error.what());
+            continue;
+        }
+        if (!handle(request)) {
+            status = (shutdown_requested ? 0 : 1);
+            break;
+        }
+    }
+    cout.rdbuf(standard_output);
+    return status;
+}
+
+bool LanguageServer::handle(const json_value &request) {
+    const string method = request["method"].text;
+    const json_value &id = request["id"];
+    const json_value &params = request["params"];
+    const string uri = params["textDocument"]["uri"].text;
+
+    if (method == "initialize") {
+        respond(id, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+            "\"definitionProvider\":true,\"referencesProvider\":true},"
+            "\"serverInfo\":{\"name\":\"montador\",\"version\":\"" ASSEMBLER_VERSION "\"}}");
+    }
+    else if (method == "shutdown") {
+        shutdown_requested = true;
+        respond(id, "null");
+    }
+    else if (method == "exit") {
+        return false;
+    }
+    else if (method == "textDocument/didOpen") {
+        open_document &document = documents[uri];
+        document = open_document();
+        document.path = uri_path(uri);
+        edit(document, json_value(), params["textDocument"]["text"].text);
+    }
+    else if (method == "textDocument/didChange") {
+        auto document = documents.find(uri);
+        if (document != documents.end()) {
+            for (const json_value &change : params["contentChanges"].items) edit(document->second, change["range"], change["text"].text);
+        }
+    }
+    else if (method == "textDocument/didClose") {
+        auto document = documents.find(uri);
+        if (document != documents.end()) {
+            // Limpa os diagnósticos do documento e dos arquivos incluídos por ele
+            for (const string &included : document->second.included_uris) publish(included, "");
+            publish(uri, "");
+            documents.erase(document);
+        }
+    }
+    else if (method == "textDocument/definition" || method == "textDocument/references") {
+        open_document *document = current_document(uri);
+        const document_line *cursor_line = (document == nullptr ? nullptr : find_line(*document, params["position"]["line"].as_int()));
+        if (cursor_line == nullptr) {
+            respond(id, "null");
+            return true;
+        }
+        // Palavra sob o cursor
+        const string &text = cursor_line->text;
+        size_t start = byte_offset(text, params["position"]["character"].as_int());
+        size_t end = start;
+        while (start > 0 && is_symbol_character(text[start - 1])) start--;
+        while (end < text.length() && is_symbol_character(text[end])) end++;
+        string name = text.substr(start, end - start);
+        transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return toupper(c); });
+
+        // A definição é a primeira do documento, e as referências são juntadas bloco a bloco
+        int definition = -1;
+        vector<int> references;
+        int base = 0;
+        for (const document_chunk &chunk : document->chunks) {
+            auto chunk_definition = chunk.definitions.find(name);
+            if (definition == -1 && chunk_definition != chunk.definitions.end()) definition = base + chunk_definition->second;
+            auto chunk_references = chunk.references.find(name);
+            if (chunk_references != chunk.references.end()) {
+                for (const int line : chunk_references->second) references.push_back(base + line);
+            }
+            base += chunk.lines.size();
+        }
+        if (method == "textDocument/definition") {
+            if (definition == -1) respond(id, "null");
+            else respond(id, locations(uri, *document, name, {definition}));
+        }
+        else {
+            if (params["context"]["includeDeclaration"].boolean && definition != -1) references.insert(references.begin(), definition);
+            respond(id, locations(uri, *document, name, references));
+        }
+    }
+    else if (!id.is_null()) {
+        respond_error(id, -32601, "Método não suportado: " + method);
+    }
+    return true;
+}
+
+void LanguageServer::edit(open_document &document, const json_value &range, const string &text) {
+    vector<document_chunk> &chunks = document.chunks;
+    document.dirty = true;
+    size_t first = 0, last = document.line_count;
+    string prefix = "", suffix = "";
+    if (!range.is_null() && document.line_count > 0) {
+        // Posições além do fim são trazidas para o fim do documento
+        first = min<size_t>(range["start"]["line"].as_int(), document.line_count - 1);
+        const size_t end_line = min<size_t>(range["end"]["line"].as_int(), document.line_count - 1);
+        const bool start_beyond = range["start"]["line"].as_int() >= (int) document.line_count;
+        const bool end_beyond = range["end"]["line"].as_int() >= (int) document.line_count;
+        const string &first_text = find_line(document, first)->text;
+        const string &last_text = find_line(document, end_line)->text;
+        prefix = first_text.substr(0, start_beyond ? first_text.length() : byte_offset(first_text, range["start"]["character"].as_int()));
+        suffix = last_text.substr(end_beyond ? last_text.length() : byte_offset(last_text, range["end"]["character"].as_int()));
+        last = end_line + 1;
+    }
+
+    // As linhas substitutas ficam para ser separadas na próxima atualização
+    const string merged = prefix + text + suffix;
+    vector<document_line> replacement;
+    for (size_t start = 0; ; ) {
+        const size_t end = merged.find('\n', start);
+        replacement.emplace_back();
+        replacement.back().text = merged.substr(start, end == string::npos ? string::npos : end - start);
+        if (end == string::npos) break;
+        start = end + 1;
+    }
+    const pair<size_t, size_t> first_position = locate(chunks, first);
+    // Com a mesma quantidade de linhas, as linhas são alteradas no lugar e mantêm a separação anterior para comparação
+    if (replacement.size() == last - first) {
+        pair<size_t, size_t> position = first_position;
+        for (document_line &line : replacement) {
+            if (position.second == chunks[position.first].lines.size()) position = {position.first + 1, 0};
+            document_line &target = chunks[position.first].lines[position.second++];
+            target.text = move(line.text);
+            target.scanned = false;
+            chunks[position.first].scanned = false;
+        }
+        return;
+    }
+
+    // Junta as linhas dos blocos alcançados com as substitutas, e divide o trecho em blocos de novo
+    const size_t first_chunk = (ANY(chunks) ? first_position.first : 0);
+    size_t end_chunk = (ANY(chunks) ? locate(chunks, last - 1).first + 1 : 0);
+    const size_t span_start = first - first_position.second;
+    vector<document_line> span;
+    for (size_t chunk = first_chunk; chunk < end_chunk; chunk++) {
+        span.insert(span.end(), make_move_iterator(chunks[chunk].lines.begin()), make_move_iterator(chunks[chunk].lines.end()));
+    }
+    vector<document_line> joined;
+    joined.reserve(span.size() + replacement.size());
+    joined.insert(joined.end(), make_move_iterator(span.begin()), make_move_iterator(span.begin() + (first - span_start)));
+    joined.insert(joined.end(), make_move_iterator(replacement.begin()), make_move_iterator(replacement.end()));
+    joined.insert(joined.end(), make_move_iterator(span.begin() + (last - span_start)), make_move_iterator(span.end()));
+    // Um trecho pequeno é juntado ao bloco seguinte, para que remoções não fragmentem o documento
+    if (joined.size() < LSP_CHUNK_LINES / 4 && end_chunk < chunks.size()) {
+        joined.insert(joined.end(), make_move_iterator(chunks[end_chunk].lines.begin()), make_move_iterator(chunks[end_chunk].lines.end()));
+        end_chunk++;
+    }
+    vector<document_chunk> split;
+    const size_t piece = (joined.size() > 2 * LSP_CHUNK_LINES ? LSP_CHUNK_LINES : joined.size());
+    for (size_t start = 0; start < joined.size(); start += piece) {
+        split.emplace_back();
+        split.back().lines.assign(make_move_iterator(joined.begin() + start), make_move_iterator(joined.begin() + min(start + piece, joined.size())));
+    }
+    chunks.erase(chunks.begin() + first_chunk, chunks.begin() + end_chunk);
+    chunks.insert(chunks.begin() + first_chunk, make_move_iterator(split.begin()), make_move_iterator(split.end()));
+    document.line_count += replacement.size() - (last - first);
+    document.reshaped = true;
+}
+
+open_document* LanguageServer::current_document(const string &uri) {
+    auto document = documents.find(uri);
+    if (document == documents.end()) return nullptr;
+    if (document->second.dirty) update(document->first, document->second);
+    return &document->second;
+}
+
+void LanguageServer::update(const string &uri, open_document &document) {
+    const auto start = chrono::steady_clock::now();
+    vector<document_chunk> &chunks = document.chunks;
+    size_t rescanned = 0;
+    bool changed = document.reshaped;
+
+    // Apenas as linhas editadas passam pelo scanner. Suas posições, pelo bloco e pela posição no bloco, são guardadas
+    vector<pair<size_t, size_t>> edited;
+    Scanner scanner(true);
+    scanner.set_line_cache(&line_cache);
+    size_t base = 0;
+    for (size_t chunk = 0; chunk < chunks.size(); base += chunks[chunk].lines.size(), chunk++) {
+        if (chunks[chunk].scanned) continue;
+        for (size_t index = 0; index < chunks[chunk].lines.size(); index++) {
+            document_line &line = chunks[chunk].lines[index];
+            if (line.scanned) continue;
+            vector<asm_line> broken;
+            string error_log = "";
+            document_line scanned_line;
+            // Os erros da linha vão direto para ela
+            scanner.set_error_list(&scanned_line.errors);
+            scanner.scan_line(line.text, base + index + 1, scanned_line.stray_label, broken, error_log);
+            scanner.set_error_list(nullptr);
+            scanned_line.has_operation = ANY(broken);
+            if (scanned_line.has_operation) scanned_line.tokens = broken.front();
+            // Edições que não mudam nenhum elemento, como em comentários, mantêm os diagnósticos da análise completa
+            if (same_scan(line, scanned_line)) {
+                scanned_line.label_conflict = line.label_conflict;
+                scanned_line.analysis_errors = move(line.analysis_errors);
+                scanned_line.analysis_warnings = move(line.analysis_warnings);
+            }
+            else {
+                changed = true;
+                chunks[chunk].indexed = false;
+            }
+            scanned_line.text = move(line.text);
+            scanned_line.scanned = true;
+            line = move(scanned_line);
+            edited.emplace_back(chunk, index);
+            rescanned++;
+        }
+        chunks[chunk].scanned = true;
+    }
+    if (line_cache.size() > LSP_CACHE_LIMIT) line_cache.clear();
+    document.reshaped = false;
+    document.dirty = false;
+    if (!changed) {
+        if (verbose) cerr << "[lsp] " << uri << ": " << rescanned << " linhas separadas de novo, sem mudanças" << endl;
+        return;
+    }
+
+    // Refaz o pareamento de rótulos pendentes a partir de cada linha editada, até a operação seguinte, que consome o rótulo pendente
+    pair<size_t, size_t> paired {0, 0};
+    for (const pair<size_t, size_t> &position : edited) {
+        if (position < paired) continue;
+        string stray_label = pending_label(chunks, position.first, position.second);
+        for (paired = position; paired.first < chunks.size(); ) {
+            document_chunk &chunk = chunks[paired.first];
+            document_line &line = chunk.lines[paired.second];
+            bool conflict = false;
+            if ANY(line.stray_label) {
+                conflict = ANY(stray_label);
+                stray_label = line.stray_label;
+            }
+            else if (line.has_operation) {
+                conflict = ANY(stray_label) && ANY(line.tokens.label);
+                stray_label = "";
+            }
+            if (line.label_conflict != conflict) {
+                line.label_conflict = conflict;
+                chunk.indexed = false;
+            }
+            paired = (paired.second + 1 < chunk.lines.size() ? make_pair(paired.first, paired.second + 1) : make_pair(paired.first + 1, (size_t) 0));
+            if (line.has_operation) break;
+        }
+    }
+    for (document_chunk &chunk : chunks) {
+        if (!chunk.indexed) index_chunk(chunk);
+    }
+    document.stale = true;
+    // O tempo não inclui o envio, que depende do cliente
+    const double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    publish(uri, document);
+
+    if (verbose) {
+        cerr << "[lsp] " << uri << ": " << document.line_count << " linhas, " << rescanned << " separadas de novo, " << elapsed << " ms" << endl;
+    }
+}
+
+void LanguageServer::analyze(const string &uri, open_document &document) {
+    const auto start = chrono::steady_clock::now();
+    if (document.dirty) update(uri, document);
+    // Linhas em ordem, para que os diagnósticos sejam distribuídos pelo número da linha
+    vector<document_line*> lines;
+    lines.reserve(document.line_count);
+    for (document_chunk &chunk : document.chunks) {
+        for (document_line &line : chunk.lines) {
+            line.analysis_errors.clear();
+            line.analysis_warnings.clear();
+            lines.push_back(&line);
+        }
+    }
+    document.errors.clear();
+    document.warnings.clear();
+
+    // Aplica os rótulos pendentes às operações. Os conflitos já estão marcados nas linhas
+    Scanner scanner(true);
+    vector<asm_line> program;
+    program.reserve(lines.size());
+    string stray_label = "";
+    for (size_t index = 0; index < lines.size(); index++) {
+        const document_line &line = *lines[index];
+        if ANY(line.stray_label) stray_label = line.stray_label;
+        if (!line.has_operation) continue;
+        asm_line broken_line = line.tokens;
+        broken_line.number = index + 1;
+        try {
+            scanner.assign_label(broken_line, stray_label);
+        }
+        catch (ScannerException &error) {}
+        program.push_back(broken_line);
+    }
+
+    // Préprocessamento sobre as linhas já separadas, guardando as linhas mantidas para o montador
+    vector<diagnostic> logged;
+    vector<asm_line> kept;
+    try {
+        preprocesser.reset();
+        preprocesser.set_source_path(document.path);
+        for (size_t index = 0; index < lines.size(); index++) {
+            const string &text = lines[index]->text;
+            preprocesser.index_conditional(text.data(), text.data() + text.length(), index + 1);
+        }
+        preprocesser.finish_conditional_index();
+        preprocesser.set_kept_lines(&kept);
+        string output;
+        preprocesser.process_lines(program, output, logged);
+    }
+    catch (exception &error) {
+        logged.push_back(diagnostic {-1, "null", error.what()});
+    }
+    preprocesser.set_kept_lines(nullptr);
+    preprocesser.reset();
+
+    // Como no modo em lote, a montagem só acontece sobre um préprocessamento sem erros
+    vector<diagnostic> warnings;
+    if (logged.empty()) {
+        try {
+            assembler.assemble_lines(kept, logged);
+            warnings = assembler.get_warnings();
+        }
+        catch (exception &error) {
+            logged.push_back(diagnostic {-1, "null", error.what()});
+        }
+    }
+
+    // Diagnósticos ficam nas suas linhas, e os de arquivos incluídos são publicados para esses arquivos
+    map<string, string> included;
+    for (const diagnostic &error : logged) {
+        if ANY(error.file) {
+            string &list = included["file://" + error.file];
+            list += (list.empty() ? "" : ",") + diagnostic_json(max(error.line, 1) - 1, nullptr, error, 1);
+        }
+        else if (error.line >= 1 && error.line <= (int) lines.size()) lines[error.line - 1]->analysis_errors.push_back(error);
+        else document.errors.push_back(error);
+    }
+    for (const diagnostic &warning : warnings) {
+        if (warning.line >= 1 && warning.line <= (int) lines.size()) lines[warning.line - 1]->analysis_warnings.push_back(warning);
+        else document.warnings.push_back(warning);
+    }
+    for (document_chunk &chunk : document.chunks) index_chunk(chunk);
+    const double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    publish(uri, document);
+    for (const string &included_uri : document.included_uris) {
+        if (included.count(included_uri) == 0) publish(included_uri, "");
+    }
+    document.included_uris.clear();
+    for (const auto &included_errors : included) {
+        publish(included_errors.first, included_errors.second);
+        document.included_uris.insert(included_errors.first);
+    }
+    document.stale = false;
+
+    if (verbose) {
+        cerr << "[lsp] " << uri << ": análise completa de " << lines.size() << " linhas, " << logged.size() << " erros, " << elapsed << " ms" << endl;
+    }
+}
+
+void LanguageServer::publish(const string &uri, const string &list) {
+    send("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":" + json_quote(uri) + ",\"diagnostics\":[" + list + "]}}");
+}
+
+void LanguageServer::publish(const string &uri, const open_document &document) {
+    string list = "";
+    auto add = [&](int line, const document_line *text_line, const diagnostic &entry, int severity) {
+        list += (list.empty() ? "" : ",") + diagnostic_json(line, text_line, entry, severity);
+    };
+    // Blocos sem diagnósticos são pulados
+    int base = 0;
+    for (const document_chunk &chunk : document.chunks) {
+        for (size_t index = 0; chunk.diagnosed > 0 && index < chunk.lines.size(); index++) {
+            const document_line &line = chunk.lines[index];
+            const int number = base + index;
+            for (const diagnostic &error : line.errors) add(number, &line, error, 1);
+            if (line.label_conflict) add(number, &line, diagnostic {number + 1, "semântico", "Mais de um rótulo declarado para a mesma linha"}, 1);
+            for (const diagnostic &error : line.analysis_errors) add(number, &line, error, 1);
+            for (const diagnostic &warning : line.analysis_warnings) add(number, &line, warning, 2);
+        }
+        base += chunk.lines.size();
+    }
+    // Diagnósticos sem linha ocupam o início da primeira linha
+    for (const diagnostic &error : document.errors) add(max(error.line, 1) - 1, find_line(document, max(error.line, 1) - 1), error, 1);
+    for (const diagnostic &warning : document.warnings) add(max(warning.line, 1) - 1, find_line(document, max(warning.line, 1) - 1), warning, 2);
+    publish(uri, list);
+}
+
+string LanguageServer::locations(const string &uri, const open_document &document, const string &name, const vector<int> &lines) {
+    string list = "";
+    for (const int line : lines) {
+        const string &text = find_line(document, line)->text;
+        const size_t position = find_symbol(text, name);
+        const int start = (position == string::npos ? 0 : utf16_column(text, position));
+        const int end = (position == string::npos ? 0 : utf16_column(text, position + name.length()));
+        list += (list.empty() ? "" : ",") + string("{\"uri\":") + json_quote(uri) + ",\"range\":" + range_json(line, start, end) + "}";
+    }
+    return "[" + list + "]";
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include "../include/library.hpp"
+#include "../include/preprocesser.hpp"
+#include "../include/two_pass.hpp"
+#include "../include/operation_supplier.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+
+InMemoryAssembler::InMemoryAssembler(const string &instructions) {
+    OperationSupplier supplier;
+    istringstream data_source(instructions);
+    tables = supplier.supply_tables(supplier.supply_instructions(data_source));
+}
+
+preprocess_result InMemoryAssembler::preprocess(const string &source) const {
+    preprocess_result result {false, "", {}};
+    try {
+        // Cada chamada tem seu próprio préprocessador, então chamadas simultâneas não compartilham estado
+        Preprocesser preprocesser(tables);
+        result.text = preprocesser.preprocess_text(source, result.errors);
+    }
+    catch (const MounterException &error) {
+        result.errors.push_back(diagnostic {error.get_line(), error.get_type(), error.what()});
+    }
+    catch (const exception &error) {
+        result.errors.push_back(diagnostic {-1, "null", error.what()});
+    }
+
+    result.success = result.errors.empty();
+    if (!result.success) result.text.clear();
+    return result;
+}
+
+assembly_result InMemoryAssembler::assemble(const string &source, bool analysis/* = false */, bool optimization/* = false */) const {
+    assembly_result result {false, "", {}, {}, {}, ""};
+    try {
+        // O parâmtero solicita que o scanner levante erros, que vão direto para o resultado
+        Scanner scanner(true);
+        scanner.set_error_list(&result.errors);
+        istringstream source_stream(source);
+        string scan_log = "";
+        vector<asm_line> lines = scanner.scan(source_stream, scan_log);
+
+        TwoPassAlgorithm assembler(tables);
+        assembler.set_analysis(analysis);
+        assembler.set_optimization(optimization);
+        result.object = assembler.assemble_lines(lines, result.errors);
+        result.warnings = assembler.get_warnings();
+        result.optimization_report = assembler.get_optimization_report();
+    }
+    catch (const MounterException &error) {
+        result.errors.push_back(diagnostic {error.get_line(), error.get_type(), error.what()});
+    }
+    catch (const exception &error) {
+        result.errors.push_back(diagnostic {-1, "null", error.what()});
+    }
+
+    result.success = result.errors.empty();
+    if (!result.success) {
+        result.object.clear();
+        return result;
+    }
+
+    // O código vem após o cabeçalho, no caso de módulos
+    size_t code_start = 0;
+    if (result.object.compare(0, 3, "H: ") == 0) {
+        code_start = result.object.find("T: ");
+        code_start = (code_start == string::npos ? result.object.length() : code_start + 3);
+    }
+    istringstream code(result.object.substr(code_start));
+    int word;
+    while (code >> word) result.words.push_back(word);
+    return result;
+}
+
+assembly_result InMemoryAssembler::build(const string &source, bool analysis/* = false */, bool optimization/* = false */) const {
+    const preprocess_result preprocessed = preprocess(source);
+    if (!preprocessed.success) {
+        assembly_result result {false, "", {}, preprocessed.errors, {}, ""};
+        return result;
+    }
+    return assemble(preprocessed.text, analysis, optimization);
+}
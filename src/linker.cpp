@@ -0,0 +1,190 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "../include/linker.hpp"
+#include "../include/file_io.hpp"
+#include "../include/object_reader.hpp"
+#include "../include/object_archive.hpp"
+
+using namespace std;
+
+#define VECTOR_ITERATOR(iterator, a_vector) (auto iterator = a_vector.begin(); iterator != a_vector.end(); iterator++)
+#define ANY(thing) (!thing.empty())
+
+object_module Linker::read_module(string path) {
+    // Um membro de um arquivo de objetos é lido do mapeamento, sem abrir um arquivo próprio
+    string archive_path, member;
+    stringstream source;
+    if (split_archive_path(path, archive_path, member)) {
+        ObjectArchive archive(archive_path);
+        source.str(archive.text(archive.find(member)));
+    }
+    else {
+        fstream file(path);
+        if (!file.is_open()) {
+            throw invalid_argument("Não foi possível abrir o arquivo \"" + path + "\"");
+        }
+        source << file.rdbuf();
+    }
+
+    object_module module;
+    module.path = path;
+    module.size = -1;
+
+    string line;
+    int line_number = 0;
+    // Cada linha começa com uma chave que indica o seu conteúdo
+    while (getline(source, line)) {
+        line_number++;
+        if (line.empty()) continue;
+
+        const string key = line.substr(0, line.find(':'));
+        stringstream content(line.substr(min(line.length(), key.length() + 1)));
+
+        // Cabeçalho: primeiro o nome, depois o tamanho
+        if (key == "H") {
+            if (module.name.empty()) content >> module.name;
+            else content >> module.size;
+        }
+        else if (key == "R") {
+            content >> module.relocation;
+        }
+        else if (key == "D" || key == "U") {
+            string symbol;
+            int address;
+            if (!(content >> symbol >> address)) {
+                throw MounterException(line_number, "ligação",
+                    "Entrada de tabela malformada no arquivo \"" + path + "\""
+                );
+            }
+            (key == "D" ? module.definition_table : module.use_table).push_back(make_pair(symbol, address));
+        }
+        else if (key == "T") {
+            try {
+                ObjectReader::parse_words(line.data() + min(line.length(), key.length() + 1), line.data() + line.length(), module.code);
+            }
+            catch (const MounterException &error) {
+                throw MounterException(line_number, "ligação", string(error.what()) + ", no arquivo \"" + path + "\"");
+            }
+        }
+        else {
+            throw MounterException(line_number, "ligação",
+                "O arquivo \"" + path + "\" não é um módulo relocável. Monte-o com as diretivas BEGIN e END"
+            );
+        }
+    }
+
+    // Verifica a consistência do cabeçalho
+    if (module.name.empty() || module.size != (int) module.code.size() || module.relocation.length() != module.code.size()) {
+        throw MounterException(-1, "ligação",
+            "Cabeçalho do módulo no arquivo \"" + path + "\" não corresponde ao seu código"
+        );
+    }
+
+    return module;
+}
+
+void Linker::link(vector<string> paths, bool print/* = false */) {
+    global_definition_table.clear();
+    // Coleta os erros encontrados
+    string error_log = "";
+
+    // Carrega os módulos
+    vector<object_module> modules;
+    for (const string &path : paths) {
+        try {
+            modules.push_back(read_module(path));
+        }
+        catch (MounterException &error) {
+            string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
+            error_log += intro + error.get_type() + ": " + error.what() + "\n";
+        }
+    }
+    if ANY(error_log) {
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+    }
+
+    // Calcula os fatores de correção e monta a tabela global de definições
+    vector<int> correction_factors;
+    int total_size = 0;
+    for VECTOR_ITERATOR(module, modules) {
+        correction_factors.push_back(total_size);
+        for VECTOR_ITERATOR(definition, module->definition_table) {
+            const int address = definition->second + total_size;
+            if (!global_definition_table.emplace(definition->first, address).second) {
+                error_log += "No módulo \"" + module->name + "\", erro ligação: Redefinição do símbolo público \"" + definition->first + "\"\n";
+            }
+        }
+        total_size += module->size;
+    }
+
+    if (verbose) {
+        cout << "Tabela global de definições: {" << endl;
+        for VECTOR_ITERATOR(definition, global_definition_table) {
+            cout << '\t' << definition->first << ": \"" << definition->second << "\"," << endl;
+        }
+        cout << "}" << endl;
+    }
+
+    // Passagem única pelo código de cada módulo, aplicando relocação e tabela de uso
+    string output = "";
+    for (size_t index = 0; index < modules.size(); index++) {
+        object_module &module = modules[index];
+        const int factor = correction_factors[index];
+
+        if (print) {
+            cout << "Módulo \"" << module.name << "\" (" << module.path << "): endereço " << factor << ", tamanho " << module.size << endl;
+        }
+
+        // Entradas da tabela de uso fora do código do módulo não seriam aplicadas a nenhuma palavra
+        module.use_table.erase(remove_if(module.use_table.begin(), module.use_table.end(), [&](const pair<string, int> &use) {
+            if (use.second >= 0 && use.second < module.size) return false;
+            error_log += "No módulo \"" + module.name + "\", erro ligação: Uso do símbolo externo \"" + use.first + "\" no endereço " + to_string(use.second) + ", fora do módulo\n";
+            return true;
+        }), module.use_table.end());
+        // A tabela de uso é percorrida junto com o código, em ordem de endereço
+        sort(module.use_table.begin(), module.use_table.end(),
+            [](const pair<string, int> &a, const pair<string, int> &b) { return a.second < b.second; }
+        );
+        auto use_entry = module.use_table.begin();
+
+        for (int address = 0; address < module.size; address++) {
+            int word = module.code[address];
+            if (module.relocation[address] == '1') word += factor;
+
+            while (use_entry != module.use_table.end() && use_entry->second == address) {
+                auto definition = global_definition_table.find(use_entry->first);
+                if (definition == global_definition_table.end()) {
+                    error_log += "No módulo \"" + module.name + "\", erro ligação: Símbolo externo \"" + use_entry->first + "\" não é definido por nenhum módulo\n";
+                }
+                else word += definition->second;
+                use_entry++;
+            }
+            output += to_string(word) + " ";
+        }
+    }
+
+    if ANY(error_log) {
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+    }
+
+    // O executável recebe o nome do primeiro módulo
+    string path = paths.at(0);
+    // Ao lado do arquivo de objetos, no caso de um membro
+    string archive_path, member;
+    if (split_archive_path(path, archive_path, member)) {
+        const size_t slash = archive_path.rfind('/');
+        path = (slash == string::npos ? "" : archive_path.substr(0, slash + 1)) + member;
+    }
+    const string exe_path = replace_extension(path, "_ligado.obj");
+    fstream exe(exe_path, fstream::out);
+    if (!exe.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + exe_path + "\"");
+    }
+    exe << output;
+}
@@ -0,0 +1,41 @@
+#include <string>
+#include <charconv>
+#include <climits>
+#include "../include/literal.hpp"
+
+using namespace std;
+
+literal parse_literal(const string &operand) {
+    const char *cursor = operand.data();
+    const char *const end = operand.data() + operand.length();
+
+    const bool negative = (cursor != end && *cursor == '-');
+    if (negative) cursor++;
+    // Rótulos não começam com dígitos, então qualquer outro começo não é um número
+    if (cursor == end || *cursor < '0' || *cursor > '9') return literal {NOT_LITERAL, 0};
+
+    int base = 10;
+    if (end - cursor > 2 && cursor[0] == '0' && (cursor[1] == 'x' || cursor[1] == 'X')) base = 16;
+    else if (end - cursor > 2 && cursor[0] == '0' && (cursor[1] == 'b' || cursor[1] == 'B')) base = 2;
+    if (base != 10) cursor += 2;
+    // Um sinal após o prefixo seria aceito por from_chars
+    if (*cursor == '-' || *cursor == '+') return literal {MALFORMED_LITERAL, 0};
+
+    // A magnitude é convertida sem sinal, para que o menor int também seja representável
+    unsigned long long magnitude;
+    const from_chars_result result = from_chars(cursor, end, magnitude, base);
+    if (result.ec == errc::invalid_argument || result.ptr != end) return literal {MALFORMED_LITERAL, 0};
+    if (result.ec == errc::result_out_of_range) return literal {OVERFLOWING_LITERAL, 0};
+
+    const unsigned long long limit = (negative ? -(long long)INT_MIN : INT_MAX);
+    if (magnitude > limit) return literal {OVERFLOWING_LITERAL, 0};
+    const long long value = (negative ? -(long long)magnitude : (long long)magnitude);
+    return literal {VALID_LITERAL, (int)value};
+}
+
+string describe_literal_error(const string &operand, const literal &parsed) {
+    if (parsed.kind == OVERFLOWING_LITERAL) {
+        return "Literal \"" + operand + "\" está fora do intervalo de " + to_string(INT_MIN) + " a " + to_string(INT_MAX);
+    }
+    return "Literal \"" + operand + "\" é inválido";
+}
@@ -0,0 +1,40 @@
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/mapped_file.hpp"
+
+using namespace std;
+
+MappedFile::MappedFile(const string &path, bool sequential/* = false */) : mapping(nullptr), mapping_size(0) {
+    const int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor == -1) {
+        throw invalid_argument("Falha ao abrir arquivo \"" + path + "\"");
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == -1) {
+        close(descriptor);
+        throw invalid_argument("Falha ao abrir arquivo \"" + path + "\"");
+    }
+    if (status.st_size == 0) {
+        close(descriptor);
+        return;
+    }
+
+    void* region = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // O mapeamento continua válido depois de fechado o descritor
+    close(descriptor);
+    if (region == MAP_FAILED) {
+        throw invalid_argument("Falha ao mapear o arquivo \"" + path + "\": " + string(strerror(errno)));
+    }
+    if (sequential) madvise(region, status.st_size, MADV_SEQUENTIAL);
+    mapping = (const char*) region;
+    mapping_size = status.st_size;
+}
+
+MappedFile::~MappedFile() {
+    if (mapping != nullptr) munmap((void*) mapping, mapping_size);
+}
@@ -0,0 +1,242 @@
+#include <string>
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+#include "../include/object_archive.hpp"
+#include "../include/object_reader.hpp"
+#include "../include/mounter_exception.hpp"
+
+using namespace std;
+
+#define SEPARATOR(character) ((unsigned char) (character) <= ' ')
+// Alinhamento do conteúdo dos membros, que permite ler as palavras direto da região mapeada
+#define ARCHIVE_ALIGNMENT 8
+
+namespace {
+    // Completa o texto com zeros até o próximo múltiplo do alinhamento
+    void pad(string &data) {
+        data.append((ARCHIVE_ALIGNMENT - data.length() % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT, '\0');
+    }
+
+    // Indica se o texto .obj é de um módulo, que começa pelo cabeçalho "H:"
+    bool is_module(const char* text, size_t size) {
+        const char* end = text + size;
+        while (text < end && SEPARATOR(*text)) text++;
+        return end - text >= 2 && text[0] == 'H' && text[1] == ':';
+    }
+}
+
+bool split_archive_path(const string &path, string &archive_path, string &member) {
+    const string marker = string(ARCHIVE_EXTENSION) + ARCHIVE_MEMBER_SEPARATOR;
+    const size_t position = path.find(marker);
+    if (position == string::npos || position + marker.length() == path.length()) return false;
+    archive_path = path.substr(0, position + marker.length() - 1);
+    member = path.substr(position + marker.length());
+    return true;
+}
+
+void ArchiveWriter::add(const string &name, const string &object) {
+    if (name.empty() || name.find(ARCHIVE_MEMBER_SEPARATOR) != string::npos) {
+        throw invalid_argument("Nome de membro inválido para o arquivo de objetos: \"" + name + "\"");
+    }
+    if (is_module(object.data(), object.length())) {
+        members.push_back(pending_member {name, ARCHIVE_TEXT, object});
+        return;
+    }
+    // Programas já ligados são convertidos uma única vez, aqui, e não a cada carga
+    vector<int> image;
+    ObjectReader::parse_words(object.data(), object.data() + object.length(), image);
+    string content;
+    size_t position = 0;
+    while (position < image.size()) {
+        // As palavras literais vão até a próxima sequência de zeros longa o bastante, que entra no mesmo bloco
+        const size_t first = position;
+        size_t zeros = 0;
+        while (position < image.size()) {
+            size_t end = position;
+            while (end < image.size() && image[end] == 0 && end - position < UINT32_MAX) end++;
+            if (end - position >= ARCHIVE_ZERO_RUN || (end == image.size() && end > position)) {
+                zeros = end - position;
+                break;
+            }
+            position = max(end, position + 1);
+        }
+        const archive_block block {(uint32_t) (position - first), (uint32_t) zeros};
+        content.append((const char*) &block, sizeof(block));
+        content.append((const char*) (image.data() + first), (position - first) * sizeof(int));
+        position += zeros;
+    }
+    members.push_back(pending_member {name, ARCHIVE_WORDS, move(content)});
+}
+
+void ArchiveWriter::write(const string &path) {
+    // Ordena pelo nome sem mover os conteúdos
+    vector<size_t> order(members.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](size_t left, size_t right) {return members[left].name < members[right].name;});
+    for (size_t position = 1; position < order.size(); position++) {
+        if (members[order[position]].name == members[order[position - 1]].name) {
+            throw invalid_argument("Membro \"" + members[order[position]].name + "\" repetido no arquivo de objetos \"" + path + "\"");
+        }
+    }
+
+    archive_header header;
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.count = members.size();
+    header.index_offset = sizeof(archive_header);
+    header.names_offset = header.index_offset + members.size() * sizeof(archive_entry);
+    header.names_size = 0;
+    for (const pending_member &member : members) header.names_size += member.name.length();
+
+    vector<archive_entry> index;
+    index.reserve(members.size());
+    string names;
+    names.reserve(header.names_size);
+    // O conteúdo começa depois dos nomes, alinhado
+    uint64_t offset = header.names_offset + header.names_size;
+    offset += (ARCHIVE_ALIGNMENT - offset % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT;
+    for (const size_t member : order) {
+        const pending_member &pending = members[member];
+        index.push_back(archive_entry {names.length(), (uint32_t) pending.name.length(), pending.encoding, offset, pending.content.length()});
+        names += pending.name;
+        offset += pending.content.length();
+        offset += (ARCHIVE_ALIGNMENT - offset % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT;
+    }
+
+    string data;
+    data.reserve(offset);
+    data.append((const char*) &header, sizeof(header));
+    data.append((const char*) index.data(), index.size() * sizeof(archive_entry));
+    data += names;
+    pad(data);
+    for (const size_t member : order) {
+        data += members[member].content;
+        pad(data);
+    }
+
+    // O arquivo só substitui o anterior depois de completo
+    const string partial_path = path + ".parcial";
+    fstream output(partial_path, fstream::out | fstream::binary | fstream::trunc);
+    if (!output.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + partial_path + "\"");
+    }
+    output.write(data.data(), data.length());
+    output.close();
+    if (!output || rename(partial_path.c_str(), path.c_str()) != 0) {
+        remove(partial_path.c_str());
+        throw invalid_argument("Não foi possível escrever o arquivo \"" + path + "\"");
+    }
+}
+
+ObjectArchive::ObjectArchive(const string &path) : path(path), file(path), header(nullptr), index(nullptr) {
+    if (file.size() < sizeof(archive_header)) corrupted("arquivo menor que o cabeçalho");
+    const size_t mapping_size = file.size();
+    header = (const archive_header*) file.data();
+
+    if (memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) != 0) corrupted("não é um arquivo de objetos");
+    if (header->version != ARCHIVE_VERSION) corrupted("versão " + to_string(header->version) + " do formato não suportada");
+    // Os limites são verificados sem somas que possam estourar
+    if (header->index_offset > mapping_size || header->count > (mapping_size - header->index_offset) / sizeof(archive_entry) ||
+        header->index_offset % ARCHIVE_ALIGNMENT != 0) {
+        corrupted("índice fora do arquivo");
+    }
+    if (header->names_offset > mapping_size || header->names_size > mapping_size - header->names_offset) {
+        corrupted("nomes fora do arquivo");
+    }
+    index = (const archive_entry*) (file.data() + header->index_offset);
+
+    // O índice precisa estar ordenado para a busca binária, e os conteúdos dentro do arquivo
+    for (size_t member = 0; member < header->count; member++) {
+        const archive_entry &entry = index[member];
+        if (entry.name_size == 0 || entry.name_offset > header->names_size || entry.name_size > header->names_size - entry.name_offset) {
+            corrupted("nome do membro " + to_string(member) + " fora da região de nomes");
+        }
+        if (entry.offset > mapping_size || entry.size > mapping_size - entry.offset) {
+            corrupted("conteúdo do membro \"" + name(member) + "\" fora do arquivo");
+        }
+        if (entry.encoding != ARCHIVE_TEXT && (entry.encoding != ARCHIVE_WORDS || entry.size % sizeof(int) != 0)) {
+            corrupted("codificação inválida no membro \"" + name(member) + "\"");
+        }
+        if (member > 0 && !(name(member - 1) < name(member))) corrupted("índice fora de ordem em \"" + name(member) + "\"");
+    }
+}
+
+void ObjectArchive::corrupted(const string &reason) const {
+    throw invalid_argument("Arquivo de objetos \"" + path + "\" inválido: " + reason);
+}
+
+string ObjectArchive::name(size_t member) const {
+    return string(file.data() + header->names_offset + index[member].name_offset, index[member].name_size);
+}
+
+size_t ObjectArchive::find(const string &member) const {
+    // Compara direto na região de nomes, sem construir strings
+    const char* names = file.data() + header->names_offset;
+    size_t low = 0, high = header->count;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const archive_entry &entry = index[middle];
+        const int order = string::traits_type::compare(names + entry.name_offset, member.data(), min<size_t>(entry.name_size, member.length()));
+        if (order == 0 && entry.name_size == member.length()) return middle;
+        if (order < 0 || (order == 0 && entry.name_size < member.length())) low = middle + 1;
+        else high = middle;
+    }
+    throw invalid_argument("Membro \"" + member + "\" não encontrado no arquivo de objetos \"" + path + "\"");
+}
+
+string ObjectArchive::text(size_t member) const {
+    const archive_entry &entry = index[member];
+    if (entry.encoding == ARCHIVE_TEXT) return string(file.data() + entry.offset, entry.size);
+    // As palavras voltam ao formato escrito pelo montador
+    const vector<int> image = expand(member);
+    string object;
+    object.reserve(image.size() * 2);
+    for (const int value : image) object += to_string(value) + " ";
+    return object;
+}
+
+vector<int> ObjectArchive::expand(size_t member) const {
+    const archive_entry &entry = index[member];
+    const char* content = file.data() + entry.offset;
+    // A imagem é dimensionada antes da cópia, e os zeros vêm da inicialização
+    size_t total = 0;
+    for (size_t position = 0; position < entry.size; ) {
+        archive_block block;
+        if (entry.size - position < sizeof(block)) corrupted("bloco incompleto no membro \"" + name(member) + "\"");
+        memcpy(&block, content + position, sizeof(block));
+        position += sizeof(block);
+        if (block.literal_count > (entry.size - position) / sizeof(int)) corrupted("bloco fora do membro \"" + name(member) + "\"");
+        position += block.literal_count * sizeof(int);
+        total += (size_t) block.literal_count + block.zero_count;
+        if (total > INT_MAX) corrupted("membro \"" + name(member) + "\" maior que a memória endereçável");
+    }
+    vector<int> image(total, 0);
+    size_t word = 0;
+    for (size_t position = 0; position < entry.size; ) {
+        archive_block block;
+        memcpy(&block, content + position, sizeof(block));
+        position += sizeof(block);
+        memcpy(image.data() + word, content + position, block.literal_count * sizeof(int));
+        position += block.literal_count * sizeof(int);
+        word += (size_t) block.literal_count + block.zero_count;
+    }
+    return image;
+}
+
+vector<int> ObjectArchive::words(size_t member) const {
+    const archive_entry &entry = index[member];
+    const char* content = file.data() + entry.offset;
+    if (entry.encoding == ARCHIVE_WORDS) return expand(member);
+    vector<int> image;
+    if (is_module(content, entry.size)) {
+        throw MounterException(-1, "semântico",
+            "O membro \"" + name(member) + "\" do arquivo \"" + path + "\" é um módulo. Ligue-o com -l antes de carregá-lo"
+        );
+    }
+    ObjectReader::parse_words(content, content + entry.size, image);
+    return image;
+}
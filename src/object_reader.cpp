@@ -0,0 +1,230 @@
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "../include/object_reader.hpp"
+#include "../include/mapped_file.hpp"
+#include "../include/mounter_exception.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+// Espaços, quebras de linha e demais bytes de controle separam as palavras
+#define SEPARATOR(character) ((unsigned char) (character) <= ' ')
+
+namespace {
+    // Converte uma palavra, pulando os separadores antes dela. Caminho escalar, que também aponta as palavras inválidas
+    void parse_word(const char* &cursor, const char* end, vector<int> &image) {
+        while (cursor < end && SEPARATOR(*cursor)) cursor++;
+        if (cursor == end) return;
+        const char* start = cursor;
+        while (cursor < end && !SEPARATOR(*cursor)) cursor++;
+
+        int value;
+        const from_chars_result result = from_chars(start, cursor, value);
+        if (result.ec == errc::result_out_of_range) {
+            throw MounterException(-1, "léxico", "Palavra fora do intervalo de 32 bits no arquivo objeto: \"" + string(start, cursor) + "\"");
+        }
+        if (result.ec != errc() || result.ptr != cursor) {
+            throw MounterException(-1, "léxico", "Palavra inválida no arquivo objeto: \"" + string(start, cursor) + "\"");
+        }
+        image.push_back(value);
+    }
+
+#if defined(__SSE2__)
+    // Tamanho do bloco processado de uma vez: quatro registradores de 16 bytes, uma máscara de 64 bits
+    const ptrdiff_t BLOCK_SIZE = 64;
+
+    // Converte até 8 dígitos ASCII com três multiplicações, sem laço por dígito
+    inline uint32_t parse_eight_digits(const char* digits, int count) {
+        uint64_t chunk;
+        memcpy(&chunk, digits, sizeof(chunk));
+        // Os bytes depois da palavra saem pela esquerda, e entram zeros que valem como zeros à esquerda do número
+        chunk <<= 8 * (8 - count);
+        chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+        chunk = ((chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+        return (uint32_t) (((chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+    }
+
+    // Máscaras de um bloco: bytes de palavra, dígitos e sinais de menos
+    inline void classify_block(const char* block, uint64_t &words, uint64_t &digits, uint64_t &signs) {
+        words = digits = signs = 0;
+        for (int part = 0; part < 4; part++) {
+            const __m128i chunk = _mm_loadu_si128((const __m128i*) (block + 16 * part));
+            // Bytes acima do espaço, sem sinal
+            const __m128i word = _mm_cmpeq_epi8(_mm_max_epu8(chunk, _mm_set1_epi8(' ' + 1)), chunk);
+            // Dígitos: byte - '0' no máximo 9, sem sinal
+            const __m128i offset = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+            const __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(9)), offset);
+            const __m128i sign = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('-'));
+            words |= (uint64_t) (uint16_t) _mm_movemask_epi8(word) << (16 * part);
+            digits |= (uint64_t) (uint16_t) _mm_movemask_epi8(digit) << (16 * part);
+            signs |= (uint64_t) (uint16_t) _mm_movemask_epi8(sign) << (16 * part);
+        }
+    }
+
+    // Converte uma palavra com sinal ou com mais de 8 dígitos. Retorna falso se ela precisar do caminho escalar
+    bool parse_long_word(const char* digit, int count, int &value) {
+        const bool negative = (*digit == '-');
+        if (negative) {
+            digit++;
+            count--;
+        }
+        if (count == 0 || count > 10) return false;
+        uint64_t magnitude;
+        if (count <= 8) magnitude = parse_eight_digits(digit, count);
+        else {
+            uint64_t head = 0;
+            for (int index = 0; index < count - 8; index++) head = head * 10 + (digit[index] - '0');
+            magnitude = head * 100000000 + parse_eight_digits(digit + count - 8, 8);
+        }
+        if (magnitude > (negative ? 2147483648u : 2147483647u)) return false;
+        value = (negative ? (int) -(int64_t) magnitude : (int) magnitude);
+        return true;
+    }
+
+    // Converte blocos inteiros enquanto as palavras forem regulares. Para no início da primeira palavra que precise do caminho escalar
+    void parse_blocks(const char* &cursor, const char* end, vector<int> &image) {
+        // As palavras são escritas diretamente na imagem, que cresce com folga para um bloco inteiro e é ajustada ao final
+        size_t used = image.size();
+        // A conversão lê até 8 bytes a partir do início de cada palavra do bloco
+        while (end - cursor >= BLOCK_SIZE + 8) {
+            uint64_t words, digits, signs;
+            classify_block(cursor, words, digits, signs);
+            uint64_t starts = words & ~(words << 1);
+            // Último byte de cada palavra
+            const uint64_t ends = words & ~(words >> 1);
+            // Caracteres inválidos, ou sinais fora do início de uma palavra
+            if ((words & ~(digits | signs)) != 0 || (signs & ~starts) != 0) break;
+
+            // A última palavra pode continuar no próximo bloco, que recomeça nela
+            ptrdiff_t consumed = BLOCK_SIZE;
+            if (words >> 63) {
+                consumed = 63 - __builtin_clzll(starts);
+                starts &= ~(1ull << consumed);
+                if (consumed == 0) break;
+            }
+
+            if (image.size() < used + BLOCK_SIZE / 2) image.resize(max(2 * image.size(), used + BLOCK_SIZE / 2));
+            int* output = image.data() + used;
+            bool irregular = false;
+            for (; starts != 0; starts &= starts - 1) {
+                const int start = __builtin_ctzll(starts);
+                const int count = __builtin_ctzll(ends >> start) + 1;
+                // Caso comum: até 8 dígitos, sem sinal
+                if (count <= 8 && ((signs >> start) & 1) == 0) *output++ = parse_eight_digits(cursor + start, count);
+                else if (parse_long_word(cursor + start, count, *output)) output++;
+                else {
+                    consumed = start;
+                    irregular = true;
+                    break;
+                }
+            }
+            used = output - image.data();
+            cursor += consumed;
+            if (irregular) break;
+        }
+        image.resize(used);
+    }
+#endif
+}
+
+ObjectReader::ObjectReader(shared_ptr<const isa_tables> tables, bool verbose/* = false */) : verbose(verbose) {
+    const set<string> jump_names = {"JMP", "JMPN", "JMPP", "JMPZ"};
+    const set<string> final_names = {"JMP", "STOP"};
+    for (const auto &instruction : tables->instruction_table) {
+        const int opcode = instruction.second[0];
+        if (opcode < 0) continue;
+        if ((size_t) opcode >= sizes.size()) {
+            sizes.resize(opcode + 1, 0);
+            jumps.resize(opcode + 1, false);
+            falls_through.resize(opcode + 1, false);
+        }
+        sizes[opcode] = instruction.second[1];
+        jumps[opcode] = jump_names.count(instruction.first) > 0;
+        falls_through[opcode] = final_names.count(instruction.first) == 0;
+    }
+}
+
+void ObjectReader::parse_words(const char* begin, const char* end, vector<int> &image) {
+    const char* cursor = begin;
+    while (cursor < end) {
+#if defined(__SSE2__)
+        parse_blocks(cursor, end, image);
+#endif
+        // Uma palavra pelo caminho escalar, e então volta aos blocos
+        parse_word(cursor, end, image);
+    }
+}
+
+void ObjectReader::validate(const vector<int> &image) {
+    if (image.empty()) return;
+    // Percorre as instruções alcançáveis, seguindo as duas saídas dos saltos condicionais
+    vector<bool> visited(image.size(), false);
+    vector<size_t> pending {0};
+    while ANY(pending) {
+        const size_t address = pending.back();
+        pending.pop_back();
+        if (visited[address]) continue;
+        visited[address] = true;
+
+        const int opcode = image[address];
+        if (opcode < 0 || (size_t) opcode >= sizes.size() || sizes[opcode] == 0) {
+            throw MounterException(-1, "semântico",
+                "Opcode " + to_string(opcode) + " inválido no endereço " + to_string(address)
+            );
+        }
+        const size_t size = sizes[opcode];
+        if (address + size > image.size()) {
+            throw MounterException(-1, "semântico",
+                "A instrução no endereço " + to_string(address) + " ultrapassa o fim do programa"
+            );
+        }
+        if (falls_through[opcode] && address + size < image.size()) pending.push_back(address + size);
+        if (jumps[opcode]) {
+            const int target = image[address + 1];
+            if (target < 0 || (size_t) target >= image.size()) {
+                throw MounterException(-1, "semântico",
+                    "Salto para o endereço " + to_string(target) + ", fora do programa, no endereço " + to_string(address)
+                );
+            }
+            pending.push_back(target);
+        }
+    }
+}
+
+vector<int> ObjectReader::read(string path) {
+    // A leitura é sequencial
+    const MappedFile file(path, true);
+    const char* text = file.data();
+    const size_t size = file.size();
+    vector<int> image;
+    if (size == 0) return image;
+
+    const auto start = chrono::steady_clock::now();
+    // Módulos precisam ser ligados antes de carregados
+    const char* first = text;
+    while (first < text + size && SEPARATOR(*first)) first++;
+    if (text + size - first >= 2 && first[0] == 'H' && first[1] == ':') {
+        throw MounterException(-1, "semântico", "O arquivo \"" + path + "\" é um módulo. Ligue-o com -l antes de carregá-lo");
+    }
+    // Estimativa para palavras curtas, como os zeros das seções de dados e os opcodes
+    image.reserve(size / 3 + 1);
+    parse_words(text, text + size, image);
+    const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    validate(image);
+    if (verbose) {
+        cout << "[" << __FILE__ << "]> " << path << ": " << image.size() << " palavras em " << elapsed * 1000 << " ms ("
+            << (elapsed > 0 ? size / elapsed / 1e9 : 0) << " GB/s)" << endl;
+    }
+    return image;
+}
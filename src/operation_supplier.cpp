@@ -1,6 +1,10 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <mutex>
+#include <climits>
 #include "../include/operation_supplier.hpp"
+#include "../include/two_pass.hpp"
 
 using namespace std;
 
@@ -13,6 +17,10 @@ auto OperationSupplier::supply_instructions() -> map<string, int[2]> {
         throw invalid_argument("Não foi possível abrir o arquivo de instruções em \"data/instructions.txt\"");
     }
 
+    return supply_instructions(data_source);
+}
+
+auto OperationSupplier::supply_instructions(istream &data_source) -> map<string, int[2]> {
     map<string, int[2]> instruction_table;
 
     string line;
@@ -42,6 +50,35 @@ auto OperationSupplier::supply_instructions() -> map<string, int[2]> {
     return instruction_table;
 }
 
+auto OperationSupplier::supply_tables(const map<string, int[2]> &instructions) -> shared_ptr<const isa_tables> {
+    shared_ptr<isa_tables> tables = make_shared<isa_tables>();
+    tables->instruction_table = instructions;
+    tables->directive_table = supply_directives();
+    tables->pre_directive_table = supply_pre_directives();
+    tables->link_directive_table = supply_link_directives();
+    return tables;
+}
+
+auto OperationSupplier::supply_shared_tables() -> shared_ptr<const isa_tables> {
+    // Uma falha ao ler o arquivo não é guardada, e a próxima chamada tenta novamente
+    static mutex loading;
+    static shared_ptr<const isa_tables> tables;
+    lock_guard<mutex> lock(loading);
+    if (!tables) {
+        OperationSupplier supplier;
+        tables = supplier.supply_tables(supplier.supply_instructions());
+    }
+    return tables;
+}
+
+auto OperationSupplier::supply_preprocessing_tables() -> shared_ptr<const isa_tables> {
+    static const shared_ptr<const isa_tables> tables = [] {
+        OperationSupplier supplier;
+        return supplier.supply_tables(map<string, int[2]>());
+    }();
+    return tables;
+}
+
 auto OperationSupplier::supply_directives() -> map<string, void(*)(vector<asm_line>::iterator&, int&)>{
     // Popula a tabela de diretivas
     // Implementação do padrão de projeto Command
@@ -60,10 +97,27 @@ auto OperationSupplier::supply_pre_directives() -> map<string, void(*)(vector<as
     
     pre_directive_table["EQU"] = &eval_EQU;
     pre_directive_table["IF"] = &eval_IF;
+    pre_directive_table["IFBLOCK"] = &eval_IFBLOCK;
+    pre_directive_table["ELSE"] = &eval_ELSE;
+    pre_directive_table["ENDIF"] = &eval_ENDIF;
+    pre_directive_table["INCLUDE"] = &eval_INCLUDE;
     
     return pre_directive_table;
 }
 
+auto OperationSupplier::supply_link_directives() -> map<string, void(*)(vector<asm_line>::iterator&, TwoPassAlgorithm*)> {
+    // Popula a tabela de diretivas de ligação
+    // Implementação do padrão de projeto Command
+    map<string, void(*)(vector<asm_line>::iterator&, TwoPassAlgorithm*)> link_directive_table;
+    
+    link_directive_table["BEGIN"] = &eval_BEGIN;
+    link_directive_table["END"] = &eval_END;
+    link_directive_table["PUBLIC"] = &eval_PUBLIC;
+    link_directive_table["EXTERN"] = &eval_EXTERN;
+    
+    return link_directive_table;
+}
+
 // DIRETIVAS DE PREPROCESSAMENTO
 
 void OperationSupplier::eval_EQU(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
@@ -72,12 +126,12 @@ void OperationSupplier::eval_EQU(vector<asm_line>::iterator& line_iterator, Prep
     map<string, int> &synonym_table = pre_instance->get_synonym_table();
 
     // Descobre o valor da definição
-    int value;
-    try {
-        value = stoi(line.operand[0]);
+    const literal parsed = line.operand_literal[0];
+    if (parsed.kind == MALFORMED_LITERAL || parsed.kind == OVERFLOWING_LITERAL) {
+        throw MounterException(-1, "léxico", describe_literal_error(line.operand[0], parsed));
     }
-    // Se o operando for outro rótulo, stoi() lançará uma exceção
-    catch (...) {
+    // Se o operando não for um literal, é outro rótulo
+    if (parsed.kind == NOT_LITERAL) {
         // Verifica se é que havia um operando
         if (line.operand[0].empty()) {
             const MounterException error (-1, "sintático",
@@ -97,6 +151,7 @@ void OperationSupplier::eval_EQU(vector<asm_line>::iterator& line_iterator, Prep
         );
         throw error;
     }
+    const int value = parsed.value;
     if (verbose) {
         cout << "[" << __FILE__ << "]> Encontrado EQU. Definindo o rótulo \"" + line.label + "\" como " << value << "...";
     }
@@ -110,21 +165,18 @@ void OperationSupplier::eval_EQU(vector<asm_line>::iterator& line_iterator, Prep
     if (verbose) cout << "OK" << endl;
 }
 
-void OperationSupplier::eval_IF(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
-    asm_line &line = *line_iterator;
-    bool verbose = pre_instance->is_verbose();
-
+int OperationSupplier::eval_condition(const asm_line &line, Preprocesser *pre_instance, const string &directive) {
     // Descobre o valor do operando
-    int value;
-    try {
-        value = stoi(line.operand[0]);
+    const literal parsed = line.operand_literal[0];
+    if (parsed.kind == MALFORMED_LITERAL || parsed.kind == OVERFLOWING_LITERAL) {
+        throw MounterException(-1, "léxico", describe_literal_error(line.operand[0], parsed));
     }
-    // Se o operando for outro rótulo, stoi() lançará uma exceção
-    catch (...) {
+    // Se o operando não for um literal, é outro rótulo
+    if (parsed.kind == NOT_LITERAL) {
         // Verifica se é que havia um operando
         if (line.operand[0].empty()) {
             const MounterException error (-1, "sintático",
-                "A diretiva IF recebe exatamente um parâmetro"
+                "A diretiva " + directive + " recebe exatamente um parâmetro"
             );
             throw error;
         }
@@ -141,7 +193,15 @@ void OperationSupplier::eval_IF(vector<asm_line>::iterator& line_iterator, Prepr
             "Rótulo \"" + line.operand[0] + "\" não foi atribuído por um EQU antes de ser utilizado por diretiva de pré-processamento.\nAtribuições:\n" + att
         );
         throw error;
-    } 
+    }
+    return parsed.value;
+}
+
+void OperationSupplier::eval_IF(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
+    asm_line &line = *line_iterator;
+    bool verbose = pre_instance->is_verbose();
+
+    const int value = eval_condition(line, pre_instance, "IF");
     
     // Executa a regra de negócio
     if (value == 1) {
@@ -161,20 +221,123 @@ void OperationSupplier::eval_IF(vector<asm_line>::iterator& line_iterator, Prepr
     line.label = "";
 }
 
+void OperationSupplier::eval_IFBLOCK(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
+    asm_line &line = *line_iterator;
+    bool verbose = pre_instance->is_verbose();
+
+    const int value = eval_condition(line, pre_instance, "IFBLOCK");
+    const conditional_block *block = pre_instance->find_block(line.number);
+    if (block == nullptr) {
+        throw MounterException(line.number, "sintático",
+            "IFBLOCK sem ENDIF correspondente"
+        );
+    }
+
+    // O trecho não tomado é pulado sem ser escaneado
+    if (value == 1) {
+        if (verbose) cout << "[" << __FILE__ << "]> Encontrado IFBLOCK avaliado verdadeiro. Mantendo o bloco" << endl;
+    }
+    else {
+        const int skipped_to = block->else_line != -1 ? block->else_line : block->endif_line;
+        if (verbose) cout << "[" << __FILE__ << "]> Encontrado IFBLOCK avaliado falso. Pulando até a linha " << skipped_to << endl;
+        pre_instance->resume_at(skipped_to + 1);
+    }
+
+    if NOT_EMPTY(line.label) {
+        throw MounterException(line.number, "sintático",
+            "Rótulos são proibidos para a diretiva IFBLOCK"
+        );
+    }
+}
+
+void OperationSupplier::eval_ELSE(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
+    asm_line &line = *line_iterator;
+
+    if (NOT_EMPTY(line.label) || NOT_EMPTY(line.operand[0])) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva ELSE não recebe rótulos nem parâmetros"
+        );
+    }
+    const int endif_line = pre_instance->find_else_end(line.number);
+    if (endif_line == -1) {
+        throw MounterException(line.number, "sintático",
+            "ELSE sem IFBLOCK e ENDIF correspondentes"
+        );
+    }
+    // Só se chega ao ELSE pelo trecho do IFBLOCK verdadeiro, então o trecho do ELSE é pulado
+    if (pre_instance->is_verbose()) cout << "[" << __FILE__ << "]> Encontrado ELSE. Pulando até a linha " << endif_line << endl;
+    pre_instance->resume_at(endif_line + 1);
+}
+
+void OperationSupplier::eval_ENDIF(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
+    asm_line &line = *line_iterator;
+
+    if (NOT_EMPTY(line.label) || NOT_EMPTY(line.operand[0])) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva ENDIF não recebe rótulos nem parâmetros"
+        );
+    }
+    if (!pre_instance->is_block_end(line.number)) {
+        throw MounterException(line.number, "sintático",
+            "ENDIF sem IFBLOCK correspondente"
+        );
+    }
+}
+
+void OperationSupplier::eval_INCLUDE(vector<asm_line>::iterator& line_iterator, Preprocesser *pre_instance) {
+    asm_line &line = *line_iterator;
+
+    if NOT_EMPTY(line.label) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva INCLUDE não recebe rótulos"
+        );
+    }
+    if (pre_instance->is_verbose()) {
+        cout << "[" << __FILE__ << "]> Encontrado INCLUDE. Incluindo " << line.operand[0] << endl;
+    }
+    pre_instance->include(line.operand[0]);
+}
+
 // DIRETIVAS NORMAIS
 
 void OperationSupplier::eval_SPACE(vector<asm_line>::iterator& line_iterator, int& line_number) {
     asm_line &expression = *line_iterator;
 
     expression.opcode = 0;
+    expression.span = 1;
     line_number += 1;
 
+    // Os parâmetros não chegam ao código objeto
+    string operand = expression.operand[0];
+    const bool extra_operand = NOT_EMPTY(expression.operand[1]);
+    expression.operand[0] = "";
+    expression.operand[1] = "";
+
     // Certifica o bom uso dos parâmetros
-    if (NOT_EMPTY(expression.operand[0])) {
+    if (extra_operand) {
         throw MounterException(expression.number, "sintático",
-            "A diretiva SPACE não recebe parâmetros"
+            "A diretiva SPACE recebe no máximo um parâmetro"
         );
     }
+    if (operand.empty()) return;
+
+    // O tamanho do bloco avança o contador de endereços de uma só vez
+    const literal parsed = expression.operand_literal[0];
+    if (parsed.kind == NOT_LITERAL) {
+        throw MounterException(expression.number, "léxico",
+            "A diretiva SPACE recebe um número como parâmetro. Valor recebido: " + operand
+        );
+    }
+    if (parsed.kind != VALID_LITERAL) {
+        throw MounterException(expression.number, "léxico", describe_literal_error(operand, parsed));
+    }
+    if (parsed.value < 1 || parsed.value - 1 > INT_MAX - line_number) {
+        throw MounterException(expression.number, "semântico",
+            "Tamanho inválido para a diretiva SPACE: " + operand
+        );
+    }
+    expression.span = parsed.value;
+    line_number += parsed.value - 1;
 }
 
 void OperationSupplier::eval_CONST(vector<asm_line>::iterator& line_iterator, int& line_number) {
@@ -195,14 +358,119 @@ void OperationSupplier::eval_CONST(vector<asm_line>::iterator& line_iterator, in
     expression.operand[0] = "";
 
     // Insere a constante no espaço
-    int constant;
-    try {
-        constant = stoi(operand);
-    }
-    catch (invalid_argument error) {
+    const literal parsed = expression.operand_literal[0];
+    if (parsed.kind == NOT_LITERAL) {
         throw MounterException(expression.number, "léxico",
-            "A diretiva CONST recebe um número como parâmetro. Valor recebido: " + expression.operand[0]
+            "A diretiva CONST recebe um número como parâmetro. Valor recebido: " + operand
+        );
+    }
+    if (parsed.kind != VALID_LITERAL) {
+        throw MounterException(expression.number, "léxico", describe_literal_error(operand, parsed));
+    }
+    expression.opcode = parsed.value;
+}
+
+
+// DIRETIVAS DE LIGAÇÃO
+
+void OperationSupplier::eval_BEGIN(vector<asm_line>::iterator& line_iterator, TwoPassAlgorithm *assembler) {
+    asm_line &line = *line_iterator;
+    module_info &module = assembler->get_module();
+
+    // O rótulo da diretiva é o nome do módulo
+    if (line.label.empty()) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva BEGIN requer um rótulo com o nome do módulo"
+        );
+    }
+    if NOT_EMPTY(line.operand[0]) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva BEGIN não recebe parâmetros"
+        );
+    }
+    if NOT_EMPTY(module.name) {
+        throw MounterException(line.number, "semântico",
+            "Mais de uma diretiva BEGIN no mesmo arquivo. Módulo já iniciado: \"" + module.name + "\""
+        );
+    }
+    if (assembler->is_verbose()) {
+        cout << "[" << __FILE__ << "]> Encontrado BEGIN. Montando o módulo \"" << line.label << "\"" << endl;
+    }
+
+    module.name = line.label;
+    // O nome do módulo não vai para a tabela de símbolos
+    line.label = "";
+}
+
+void OperationSupplier::eval_END(vector<asm_line>::iterator& line_iterator, TwoPassAlgorithm *assembler) {
+    asm_line &line = *line_iterator;
+    module_info &module = assembler->get_module();
+
+    if (module.name.empty()) {
+        throw MounterException(line.number, "semântico",
+            "Diretiva END sem BEGIN correspondente"
+        );
+    }
+    if (NOT_EMPTY(line.label) || NOT_EMPTY(line.operand[0])) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva END não recebe rótulos nem parâmetros"
+        );
+    }
+    module.ended = true;
+}
+
+void OperationSupplier::eval_PUBLIC(vector<asm_line>::iterator& line_iterator, TwoPassAlgorithm *assembler) {
+    asm_line &line = *line_iterator;
+    module_info &module = assembler->get_module();
+
+    if (line.operand[0].empty() || NOT_EMPTY(line.operand[1])) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva PUBLIC recebe exatamente um parâmetro"
+        );
+    }
+    if NOT_EMPTY(line.label) {
+        throw MounterException(line.number, "sintático",
+            "Rótulos são proibidos para a diretiva PUBLIC"
+        );
+    }
+    if (module.name.empty()) {
+        throw MounterException(line.number, "semântico",
+            "A diretiva PUBLIC só pode ser usada dentro de um módulo, após BEGIN"
+        );
+    }
+    // A definição do rótulo é verificada ao final da primeira passagem
+    module.public_symbols[line.operand[0]] = line.number;
+}
+
+void OperationSupplier::eval_EXTERN(vector<asm_line>::iterator& line_iterator, TwoPassAlgorithm *assembler) {
+    asm_line &line = *line_iterator;
+    module_info &module = assembler->get_module();
+    map<string, int> &symbol_table = assembler->get_symbol_table();
+
+    if (line.label.empty()) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva EXTERN requer um rótulo com o nome do símbolo externo"
+        );
+    }
+    if NOT_EMPTY(line.operand[0]) {
+        throw MounterException(line.number, "sintático",
+            "A diretiva EXTERN não recebe parâmetros"
+        );
+    }
+    if (module.name.empty()) {
+        throw MounterException(line.number, "semântico",
+            "A diretiva EXTERN só pode ser usada dentro de um módulo, após BEGIN"
+        );
+    }
+    const string label = line.label;
+    line.label = "";
+    // Verifica por rótulos repetidos
+    if (symbol_table.find(label) != symbol_table.end()) {
+        throw MounterException(line.number, "semântico",
+            "Redefinição do rótulo \"" + label + "\""
         );
     }
-    expression.opcode = constant;
+    // O endereço é resolvido pelo ligador
+    symbol_table[label] = 0;
+    module.extern_symbols.insert(label);
 }
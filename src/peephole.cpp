@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <unordered_set>
+#include "../include/peephole.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+
+int peephole_window::resolve(const string &operand) const {
+    if (!ANY(operand) || extern_symbols.count(operand) > 0) return -1;
+    auto symbol_entry = symbol_table.find(operand);
+    if (symbol_entry == symbol_table.end() || symbol_entry->second > addresses.size()) return -1;
+    return symbol_entry->second;
+}
+
+int peephole_window::line_from(int target) const {
+    if (target < 0 || target > addresses.size()) return -1;
+    int index = addresses.line_at(target);
+    if (index == -1) return -1;
+    while (index < (int) lines.size() && removed[index]) index++;
+    return index < (int) lines.size() ? index : -1;
+}
+
+namespace {
+    bool is_jump(const string &operation) {
+        return operation == "JMP" || operation == "JMPN" || operation == "JMPP" || operation == "JMPZ";
+    }
+
+    // STORE X seguido de LOAD X: o acumulador já contém X
+    bool store_then_load(peephole_window &window) {
+        if (window.next == -1) return false;
+        const asm_line &current = window.lines[window.current];
+        const asm_line &next = window.lines[window.next];
+        if (current.operation != "STORE" || next.operation != "LOAD" || current.operand[0] != next.operand[0]) return false;
+        // Um salto para o LOAD precisa dele
+        if (window.is_target[window.next]) return false;
+
+        window.removed[window.next] = true;
+        return true;
+    }
+
+    // LOAD seguido de LOAD: o primeiro valor é sobrescrito antes de ser usado
+    bool load_overwritten(peephole_window &window) {
+        if (window.next == -1) return false;
+        if (window.lines[window.current].operation != "LOAD" || window.lines[window.next].operation != "LOAD") return false;
+
+        // Um rótulo no primeiro LOAD passa a apontar para o segundo, com o mesmo efeito
+        window.removed[window.current] = true;
+        return true;
+    }
+
+    // Salto para a instrução seguinte
+    bool jump_to_next(peephole_window &window) {
+        if (window.next == -1) return false;
+        const asm_line &current = window.lines[window.current];
+        if (!is_jump(current.operation)) return false;
+        if (window.line_from(window.resolve(current.operand[0])) != window.next) return false;
+
+        window.removed[window.current] = true;
+        return true;
+    }
+
+    // Salto para um JMP: salta direto para o destino final da cadeia
+    bool jump_chain(peephole_window &window) {
+        asm_line &current = window.lines[window.current];
+        if (!is_jump(current.operation)) return false;
+
+        string destination = current.operand[0];
+        unordered_set<int> visited {window.current};
+        int target = window.line_from(window.resolve(destination));
+        while (target != -1 && window.lines[target].operation == "JMP") {
+            // Cadeias circulares são laços infinitos, e ficam como estão
+            if (!visited.insert(target).second) return false;
+            destination = window.lines[target].operand[0];
+            target = window.line_from(window.resolve(destination));
+        }
+        if (target == -1 || destination == current.operand[0]) return false;
+
+        current.operand[0] = destination;
+        return true;
+    }
+
+    // Tabela de regras, aplicadas em ordem
+    const peephole_rule rules[] = {
+        {"Cadeia de saltos encurtada", &jump_chain},
+        {"Salto para a instrução seguinte removido", &jump_to_next},
+        {"LOAD após STORE do mesmo rótulo removido", &store_then_load},
+        {"LOAD sobrescrito antes do uso removido", &load_overwritten},
+    };
+}
+
+PeepholeOptimizer::PeepholeOptimizer(const map<string, int[2]> &instruction_table) : addresses(instruction_table) {}
+
+int PeepholeOptimizer::optimize(vector<asm_line> &lines, map<string, int> &symbol_table, const set<string> &extern_symbols) {
+    addresses.measure(lines);
+    const int original_size = addresses.size();
+    // Cada rodada pode habilitar novas aplicações, como um salto que passa a apontar para a instrução seguinte
+    while (optimize_round(lines, symbol_table, extern_symbols));
+    addresses.measure(lines);
+    return original_size - addresses.size();
+}
+
+bool PeepholeOptimizer::optimize_round(vector<asm_line> &lines, map<string, int> &symbol_table, const set<string> &extern_symbols) {
+    const int count = lines.size();
+
+    addresses.measure(lines);
+    const vector<int> &address = addresses.addresses();
+    // Linhas apontadas por rótulos, incluindo as de tamanho zero que dividem o endereço com a seguinte
+    vector<bool> is_target(count, false);
+    for (auto symbol_entry = symbol_table.begin(); symbol_entry != symbol_table.end(); symbol_entry++) {
+        if (extern_symbols.count(symbol_entry->first) > 0) continue;
+        auto range = equal_range(address.begin(), address.end(), symbol_entry->second);
+        for (auto position = range.first; position != range.second; position++) is_target[position - address.begin()] = true;
+    }
+
+    vector<bool> removed(count, false);
+    peephole_window window {lines, 0, -1, addresses, is_target, symbol_table, extern_symbols, removed};
+    bool changed = false;
+
+    for (int index = 0; index < count; index++) {
+        window.current = index;
+        // Reaplica as regras na mesma posição enquanto houver alterações
+        bool applied = true;
+        while (applied && !removed[index]) {
+            applied = false;
+            window.next = index + 1;
+            while (window.next < count && removed[window.next]) window.next++;
+            if (window.next == count) window.next = -1;
+
+            for (const peephole_rule &rule : rules) {
+                if (rule.apply(window)) {
+                    applications[rule.description]++;
+                    changed = applied = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    addresses.remove(lines, removed, symbol_table, extern_symbols);
+    return changed;
+}
+
+string PeepholeOptimizer::report() {
+    string description = "";
+    for (auto application = applications.begin(); application != applications.end(); application++) {
+        description += "\t" + application->first + ": " + to_string(application->second) + "\n";
+    }
+    return description;
+}
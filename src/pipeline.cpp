@@ -0,0 +1,263 @@
+#include <iostream>
+#include <thread>
+#include <exception>
+#include "../include/pipeline.hpp"
+#include "../include/file_io.hpp"
+#include "../include/preprocesser.hpp"
+#include "../include/two_pass.hpp"
+#include "../include/tracer.hpp"
+#include "../include/binary_pre.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+
+void Pipeline::read_stage(fstream &source, SPSCQueue<raw_batch> &output, exception_ptr &failure) {
+    Tracer::name_thread("leitura");
+    TraceScope trace("read");
+    try {
+        raw_batch batch {1, {}};
+        batch.lines.reserve(batch_size);
+        string line;
+        int line_number = 1;
+
+        while (getline(source, line)) {
+            batch.lines.push_back(move(line));
+            line_number++;
+            if (batch.lines.size() == batch_size) {
+                output.push(move(batch));
+                batch = raw_batch {line_number, {}};
+                batch.lines.reserve(batch_size);
+            }
+        }
+        if ANY(batch.lines) output.push(move(batch));
+    }
+    catch (...) {
+        // Relançada pela thread principal depois do join
+        failure = current_exception();
+    }
+    output.close();
+}
+
+void Pipeline::scan_stage(bool report_all_errors, SPSCQueue<raw_batch> &input, SPSCQueue<line_batch> &output, exception_ptr &failure) {
+    Tracer::name_thread("escaneamento");
+    TraceScope trace("scan");
+    try {
+        Scanner scanner(report_all_errors);
+        // O rótulo pendente atravessa os lotes
+        string stray_label;
+        string error_log = "";
+        raw_batch raw;
+
+        while (input.pop(raw)) {
+            line_batch batch;
+            batch.lines.reserve(raw.lines.size());
+            // Os erros vão para o lote, e são agrupados pela thread principal
+            scanner.set_error_list(&batch.errors);
+            TraceScope batch_trace("scan: lote", raw.first_line);
+            for (size_t index = 0; index < raw.lines.size(); index++) {
+                scanner.scan_line(raw.lines[index], raw.first_line + (int) index, stray_label, batch.lines, error_log);
+            }
+            scanner.set_error_list(nullptr);
+            output.push(move(batch));
+        }
+    }
+    catch (...) {
+        // Relançada pela thread principal depois do join. A leitura ainda pode estar esperando espaço na fila
+        failure = current_exception();
+        raw_batch discarded;
+        while (input.pop(discarded)) {}
+    }
+    output.close();
+}
+
+void Pipeline::report(string name, const queue_stats &stats) {
+    const double average = stats.items == 0 ? 0 : (double) stats.occupancy_sum / stats.items;
+    cout << "\t" << name << ": " << stats.items << " lotes, ocupação média " << average << " de " << stats.capacity
+        << ", produtor esperou " << stats.producer_waits << " vezes, consumidor esperou " << stats.consumer_waits << " vezes" << endl;
+}
+
+void Pipeline::preprocess(string path, bool print/* = false */) {
+    // Levanta erro se receber o tipo errado de arquivo
+    if (!has_extension(path, ".asm")) {
+        throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .asm para o modo pré-processamento");
+    }
+    fstream source(path);
+    if (!source.is_open()) {
+        throw MounterException(-1, "null", "Falha ao abrir arquivo \"" + path + "\"");
+    }
+    // Define o nome do arquivo sem a extensão
+    const string pre_path = replace_extension(path, ".pre");
+    // Arquivo a ser construído, escrito à medida que os lotes chegam
+    fstream pre(pre_path, fstream::out);
+    if (!pre.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + pre_path + "\"");
+    }
+
+    SPSCQueue<raw_batch> raw_queue(queue_capacity);
+    SPSCQueue<line_batch> line_queue(queue_capacity);
+    SPSCQueue<text_batch> text_queue(queue_capacity);
+    // Exceções inesperadas de cada estágio, relançadas ao final
+    exception_ptr read_failure, scan_failure, failure;
+
+    Scanner printer;
+    Preprocesser preprocesser(verbose);
+    preprocesser.set_source_path(path);
+    // Indexa os blocos condicionais antes de iniciar os estágios
+    {
+        TraceScope trace("index");
+        string line;
+        for (int line_number = 1; getline(source, line); line_number++) {
+            preprocesser.index_conditional(line.data(), line.data() + line.length(), line_number);
+        }
+        preprocesser.finish_conditional_index();
+        source.clear();
+        source.seekg(0);
+    }
+    if (print) cout << "Estrutura do programa: {" << endl;
+
+    thread reader(&Pipeline::read_stage, this, ref(source), ref(raw_queue), ref(read_failure));
+    // O parâmtero solicita que o scanner não levante erros
+    thread tokenizer(&Pipeline::scan_stage, this, false, ref(raw_queue), ref(line_queue), ref(scan_failure));
+    thread processor([&]() {
+        Tracer::name_thread("préprocessamento");
+        TraceScope trace("preprocess");
+        line_batch batch;
+        while (line_queue.pop(batch)) {
+            text_batch result {"", move(batch.errors)};
+            // Após uma falha, apenas drena a fila para não bloquear os estágios anteriores
+            if (!failure) {
+                try {
+                    if (print) printer.print_lines(batch.lines);
+                    preprocesser.process_lines(batch.lines, result.text, result.errors);
+                }
+                catch (...) {
+                    failure = current_exception();
+                }
+            }
+            text_queue.push(move(result));
+        }
+        text_queue.close();
+    });
+
+    // Coleta as linhas resultantes, e agrupa os erros dentro do limite de memória
+    Diagnostics errors(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    text_batch result;
+    TraceScope trace("write");
+    while (text_queue.pop(result)) {
+        pre << result.text;
+        for (const diagnostic &error : result.errors) errors.add(error);
+    }
+
+    reader.join();
+    tokenizer.join();
+    processor.join();
+    pre.close();
+    if (print) cout << "}" << endl;
+
+    if (verbose) {
+        cout << "Ocupação das filas do pipeline:" << endl;
+        report("leitura -> escaneamento", raw_queue.get_stats());
+        report("escaneamento -> préprocessamento", line_queue.get_stats());
+        report("préprocessamento -> escrita", text_queue.get_stats());
+    }
+
+    if (verbose) {
+        cout << "Definições da tabela de sinônimos:\n";
+        for (auto synonym_entry_it = preprocesser.get_synonym_table().begin(); synonym_entry_it != preprocesser.get_synonym_table().end(); synonym_entry_it++) {
+            cout << "\t" << synonym_entry_it->first << ": " << synonym_entry_it->second << endl;
+        }
+    }
+
+    if (read_failure || scan_failure || failure || !errors.empty()) {
+        // Deleta o arquivo incompleto
+        remove(pre_path.c_str());
+        // A falha do estágio mais próximo da entrada é a causa das seguintes
+        if (read_failure) rethrow_exception(read_failure);
+        if (scan_failure) rethrow_exception(scan_failure);
+        if (failure) rethrow_exception(failure);
+
+        string error_log = "";
+        errors.append_to(error_log);
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+    }
+}
+
+void Pipeline::assemble(string path, bool print/* = false */) {
+    // Levanta erro se receber o tipo errado de arquivo
+    if (!has_extension(path, ".pre")) {
+        throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .pre para o modo montagem");
+    }
+    // Não há leitura nem escaneamento a paralelizar
+    if (BinaryPre::is_binary(path)) {
+        throw invalid_argument("O arquivo \"" + path + "\" é um .pre binário, já separado em linhas. Monte-o sem --pipeline");
+    }
+    fstream source(path);
+    if (!source.is_open()) {
+        throw MounterException(-1, "null", "Falha ao abrir arquivo \"" + path + "\"");
+    }
+    // Define o nome do arquivo sem a extensão
+    const string obj_path = replace_extension(path, ".obj");
+
+    SPSCQueue<raw_batch> raw_queue(queue_capacity);
+    SPSCQueue<line_batch> line_queue(queue_capacity);
+    // Exceções inesperadas dos estágios, relançadas depois do join
+    exception_ptr read_failure, scan_failure;
+
+    thread reader(&Pipeline::read_stage, this, ref(source), ref(raw_queue), ref(read_failure));
+    // O parâmtero solicita que o scanner levante erros
+    thread tokenizer(&Pipeline::scan_stage, this, true, ref(raw_queue), ref(line_queue), ref(scan_failure));
+
+    // O montador consome os lotes à medida que chegam. Os erros do escaneamento são agrupados, como na montagem sem pipeline
+    vector<asm_line> lines;
+    Diagnostics scan_errors(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    line_batch batch;
+    if (print) cout << "Estrutura do programa: {" << endl;
+    while (line_queue.pop(batch)) {
+        if (print) Scanner().print_lines(batch.lines);
+        lines.insert(lines.end(), make_move_iterator(batch.lines.begin()), make_move_iterator(batch.lines.end()));
+        for (const diagnostic &error : batch.errors) scan_errors.add(error);
+    }
+    if (print) cout << "}" << endl;
+
+    reader.join();
+    tokenizer.join();
+    if (read_failure) rethrow_exception(read_failure);
+    if (scan_failure) rethrow_exception(scan_failure);
+
+    if (verbose) {
+        cout << "Ocupação das filas do pipeline:" << endl;
+        report("leitura -> escaneamento", raw_queue.get_stats());
+        report("escaneamento -> montagem", line_queue.get_stats());
+    }
+
+    string error_log = "";
+    scan_errors.append_to(error_log);
+    TwoPassAlgorithm assembler(verbose);
+    assembler.set_analysis(analysis);
+    assembler.set_optimization(optimization);
+    assembler.set_stripping(stripping);
+    assembler.set_symbol_map(symbol_map);
+    assembler.set_diagnostic_budget(diagnostic_budget);
+    const string output = assembler.assemble_lines(lines, error_log);
+    cerr << assembler.get_warning_log();
+    cout << assembler.get_optimization_report();
+
+    if ANY(error_log) {
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+    }
+
+    // Constroi o arquivo
+    TraceScope trace("write");
+    fstream obj(obj_path, fstream::out);
+    if (!obj.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + obj_path + "\"");
+    }
+    obj << output;
+    obj.close();
+    assembler.write_symbol_map(obj_path);
+}
@@ -5,22 +5,61 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <mutex>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include "../include/scanner.hpp"
 #include "../include/preprocesser.hpp"
+#include "../include/file_io.hpp"
 #include "../include/mounter_exception.hpp"
 #include "../include/operation_supplier.hpp"
+#include "../include/tracer.hpp"
+#include "../include/error_log.hpp"
+#include "../include/alloc_stats.hpp"
+#include "../include/binary_pre.hpp"
 
 #define NOT_EMPTY(thing) (!thing.empty())
+#define ANY(thing) (!thing.empty())
 
 using namespace std;
 
-Preprocesser::Preprocesser(bool verbose/* = false */) : verbose(verbose)  {
-    // Popula a tabela de diretivas de préprocessamento
+namespace {
+    // Data de modificação de um arquivo em nanossegundos, -1 se ele não existir
+    long long modification_time(const string &path) {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) return -1;
+        return status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+    }
+
+    // Lê um arquivo inteiro
+    string read_file(const string &path) {
+        fstream source(path, fstream::in | fstream::binary);
+        if (!source.is_open()) {
+            MounterException error (-1, "null", 
+                "Falha ao abrir arquivo \"" + path + "\""
+            );
+            throw error;
+        }
+        stringstream content;
+        content << source.rdbuf();
+        return content.str();
+    }
+
+    // Remove as aspas opcionais em volta do caminho de um INCLUDE
+    string unquote(const string &operand) {
+        if (operand.length() >= 2 && operand.front() == '"' && operand.back() == '"') return operand.substr(1, operand.length() - 2);
+        return operand;
+    }
+}
+
+Preprocesser::Preprocesser(bool verbose/* = false */) : Preprocesser(OperationSupplier::supply_preprocessing_tables(), verbose) {}
+
+Preprocesser::Preprocesser(shared_ptr<const isa_tables> tables, bool verbose/* = false */) :
+    verbose(verbose), tables(tables), pre_directive_table(tables->pre_directive_table), skip_pending(false), resume_line(0), checking(false), max_errors(0), diagnostic_budget(DIAGNOSTIC_BUDGET), line_cache(nullptr), cycle_found(false), kept_lines(nullptr), binary_output(false)  {
+    // A tabela de diretivas de préprocessamento é populada pelo OperationSupplier
     // Implementação do padrão de projeto Command
     // pre_directive_table["EQU"] = &eval_EQU;
     // pre_directive_table["IF"] = &eval_IF;
-    OperationSupplier supplier;
-    pre_directive_table = supplier.supply_pre_directives();
 }
 
 // void* Preprocesser::resolve_synonym(string synonym) {
@@ -40,46 +79,106 @@ Preprocesser::Preprocesser(bool verbose/* = false */) : verbose(verbose)  {
 //     return synonym_entry->second;
 // }
 
-void Preprocesser::preprocess (string path, bool print/* = false */) {
-    // O parâmtero solicita que o scanner não levante erros
-    Scanner scanner(false);
-    // Coleta os erros lançados
-    string error_log = "";
-    // Gera a estrutura do programa
-    vector<asm_line> lines = scanner.scan(path, error_log, print);
+string Preprocesser::read_source(string path) {
+    // Lê o arquivo inteiro, ou a entrada padrão. As linhas só são escaneadas se estiverem em um trecho tomado
+    const string content = read_input(path);
 
     // Levanta erro se receber o tipo errado de arquivo
-    const size_t dot = path.find('.');
-    if (path.substr(dot) != ".asm"s) {
+    if (!is_standard_stream(path) && !has_extension(path, ".asm")) {
         throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .asm para o modo pré-processamento");
     }
-    // Define o nome do arquivo sem a extensão
-    const string pre_path = path.substr(0, dot) + ".pre";
-    // Arquivo a ser construído
-    fstream pre(pre_path, fstream::out);
+    return content;
+}
+
+void Preprocesser::set_source_path(const string &path) {
+    include_stack.clear();
+    if (path.empty()) return;
+    char *canonical = realpath(path.c_str(), nullptr);
+    include_stack.push_back(canonical == nullptr ? path : string(canonical));
+    free(canonical);
+}
+
+void Preprocesser::check(string path, bool print/* = false */) {
+    const string text = read_source(path);
+    set_source_path(path);
 
-    if (!pre.is_open()) {
-        throw invalid_argument("Não foi possível criar o arquivo \"" + pre_path + "\"");
+    // Agrupa os erros lançados
+    Diagnostics errors(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    vector<diagnostic> batch_errors;
+    // A saída não é construída
+    checking = true;
+    preprocess_text(text, batch_errors, print, &errors);
+    checking = false;
+
+    if (!errors.empty()) {
+        string error_log = "";
+        errors.append_to(error_log);
+        string interruption = "";
+        // A interrupção conta os erros recebidos, e não as entradas do log, que resume os repetidos
+        if (max_errors > 0 && errors.size() >= max_errors) {
+            truncate_log(error_log, max_errors);
+            interruption = "\nVerificação interrompida após " + to_string(max_errors) + (max_errors == 1 ? " erro" : " erros");
+        }
+        MounterException error (-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1) + interruption
+        );
+        throw error;
     }
+}
+
+void Preprocesser::preprocess (string path, bool print/* = false */) {
+    const string text = read_source(path);
+    set_source_path(path);
 
+    // Define o nome do arquivo sem a extensão
+    const string pre_path = replace_extension(path, ".pre");
+
+    // Coleta os erros lançados
+    string error_log = "";
     // Coleta as linhas resultantes
-    string output_lines = "";
+    const string output_lines = preprocess_text(text, error_log, print);
 
-    // Passa por cada linha
-    for (auto line_iterator = lines.begin(); line_iterator != lines.end(); line_iterator == lines.end() ? line_iterator : line_iterator++) {
-        try {
-            // cout << "Processando linha " << line_iterator->number << endl;
-            const string new_line = process_line(line_iterator);
-            output_lines += (new_line.empty() ? "" : new_line + "\n");
+    // Finaliza o arquivo ou imprime os erros
+    if (error_log.empty()) {
+        TraceScope trace("write");
+        // O arquivo só é criado depois do préprocessamento, então uma falha não deixa um arquivo vazio
+        if (!binary_output) {
+            write_output(pre_path, output_lines);
+            return;
         }
-        catch (MounterException error) {
-            cout << "Erro na linha " << line_iterator->number << " (" << error.what() << ")" << endl;
-            // Coleta informações sobre o erro
-            const int line = (error.get_line() == -1 ? line_iterator->number : error.get_line());
-
-            error_log += "Na linha " + to_string(line) + ", erro " + error.get_type() + ": " + error.what() + "\n";
+        // As linhas são separadas aqui, uma única vez. Com erros de montagem, o texto é mantido para que o montador os relate
+        Scanner scanner(true);
+        string scan_log = "";
+        istringstream pre_stream(output_lines);
+        const vector<asm_line> lines = scanner.scan(pre_stream, scan_log);
+        if ANY(scan_log) {
+            cerr << "Aviso: " << pre_path << " tem erros de escaneamento e foi escrito como texto" << endl;
+            write_output(pre_path, output_lines);
         }
+        else write_output(pre_path, encode_binary_pre(lines));
     }
+    else {
+        MounterException error (-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+        throw error;
+    }
+}
+
+string Preprocesser::preprocess_text(const string &text, string &error_log, bool print/* = false */) {
+    // Erros repetidos são resumidos, e a memória para eles é limitada
+    Diagnostics grouped(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    vector<diagnostic> errors;
+    const string output_lines = preprocess_text(text, errors, print, &grouped);
+    grouped.append_to(error_log);
+    return output_lines;
+}
+
+string Preprocesser::preprocess_text(const string &text, vector<diagnostic> &errors, bool print/* = false */, Diagnostics *grouped/* = nullptr */) {
+    reset();
+    dependencies.clear();
+    // Coleta as linhas resultantes
+    const string output_lines = preprocess_body(text, errors, print, grouped);
 
     if (verbose) {
         cout << "Definições da tabela de sinônimos:\n";
@@ -88,26 +187,318 @@ void Preprocesser::preprocess (string path, bool print/* = false */) {
         }
     }
     
-    // Finaliza o arquivo ou imprime os erros
-    if (error_log.empty()) {
-        pre << output_lines;
-        pre.close();
+    reset();
+    return output_lines;
+}
+
+string Preprocesser::preprocess_body(const string &text, vector<diagnostic> &errors, bool print, Diagnostics *grouped/* = nullptr */) {
+    // Coleta as linhas resultantes
+    string output_lines = "";
+
+    // Início de cada linha no texto, e indexação dos blocos condicionais
+    vector<size_t> line_starts;
+    {
+        TraceScope trace("index");
+        size_t start = 0;
+        // A última posição registrada marca o fim da última linha
+        while (start < text.length()) {
+            size_t end = text.find('\n', start);
+            if (end == string::npos) end = text.length();
+            line_starts.push_back(start);
+            index_conditional(text.data() + start, text.data() + end, line_starts.size());
+            start = end + 1;
+        }
+        line_starts.push_back(start);
+        finish_conditional_index();
     }
-    else {
-        pre.close();
-        // Deleta o arquivo vazio
-        remove(pre_path.c_str());
 
-        MounterException error (-1, "null",
-            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
-        );
-        throw error;
+    {
+        TraceScope trace("preprocess");
+        // O parâmtero solicita que o scanner não levante erros
+        Scanner scanner(false);
+        scanner.set_line_cache(line_cache);
+        // Os erros do scanner vão direto para a lista, então o seu log fica vazio
+        scanner.set_error_list(&errors);
+        string scan_log = "";
+        // Armazena um rótulo que vier em linhas anteriores à sua operação
+        string stray_label;
+        // Linhas escaneadas e ainda não processadas
+        vector<asm_line> lines;
+        if (print) cout << "Estrutura do programa: {" << endl;
+
+        const int line_count = line_starts.size() - 1;
+        for (int line_number = 1; line_number <= line_count; line_number++) {
+            // Trechos não tomados são pulados sem escaneamento
+            if (line_number < resume_line) {
+                line_number = resume_line - 1;
+                continue;
+            }
+            const size_t start = line_starts[line_number - 1];
+            string line = text.substr(start, line_starts[line_number] - 1 - start);
+            scanner.scan_line(line, line_number, stray_label, lines, scan_log);
+
+            // Diretivas condicionais decidem quais linhas serão escaneadas, então são processadas imediatamente
+            const bool conditional = ANY(lines) && (lines.back().operation == "IFBLOCK" || lines.back().operation == "ELSE");
+            if (conditional || lines.size() >= TRACE_BATCH_SIZE || line_number == line_count) {
+                if (print) scanner.print_lines(lines);
+                process_lines(lines, output_lines, errors);
+                lines.clear();
+                if (grouped != nullptr) {
+                    for (const diagnostic &error : errors) grouped->add(error);
+                    errors.clear();
+                }
+            }
+            // Verificações com limite de erros param assim que ele é atingido
+            if (max_errors > 0 && (grouped != nullptr ? grouped->size() : errors.size()) >= max_errors) break;
+        }
+        if (print) cout << "}" << endl;
     }
-    
+    return output_lines;
+}
+
+void Preprocesser::reset() {
     synonym_table.clear();
+    skip_pending = false;
+    conditional_blocks.clear();
+    else_lines.clear();
+    endif_lines.clear();
+    open_blocks.clear();
+    resume_line = 0;
+    included.clear();
+    cycle_found = false;
+    included_text.clear();
+    included_errors.clear();
+}
+
+string Preprocesser::include_operand(const char* begin, const char* end) {
+    // Separa até três palavras, parando no comentário
+    string words[3];
+    int word_count = 0;
+    const char* cursor = begin;
+    while (word_count < 3 && cursor < end) {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+        if (cursor == end || *cursor == ';') break;
+        const char* word_start = cursor;
+        while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != ';') cursor++;
+        words[word_count++].assign(word_start, cursor);
+    }
+    // Um rótulo pode preceder a diretiva
+    const int keyword = (word_count > 0 && words[0].back() == ':') ? 1 : 0;
+    if (word_count < keyword + 2 || words[keyword].length() != 7) return "";
+    string directive = words[keyword];
+    transform(directive.begin(), directive.end(), directive.begin(), 
+        [](unsigned char c) { return toupper(c); }
+    );
+    return directive == "INCLUDE" ? unquote(words[keyword + 1]) : "";
+}
+
+string Preprocesser::resolve_include(const string &including_path, const string &name) {
+    // Caminhos absolutos, e os incluídos por textos em memória, não dependem de diretório
+    if (including_path.empty() || name.front() == '/') return name;
+    const size_t slash = including_path.rfind('/');
+    return (slash == string::npos ? "" : including_path.substr(0, slash + 1)) + name;
+}
+
+void Preprocesser::include(string operand) {
+    const string name = unquote(operand);
+    if (name.empty()) {
+        throw MounterException(-1, "sintático", "A diretiva INCLUDE recebe exatamente um parâmetro");
+    }
+    // Textos em memória não têm diretório, e o préprocessamento deles não acessa o sistema de arquivos nem o cache de inclusões
+    if (include_stack.empty()) {
+        throw MounterException(-1, "semântico", "A diretiva INCLUDE requer um arquivo fonte, e não é aceita em textos em memória");
+    }
+    const string path = resolve_include(include_stack.back(), name);
+    char *resolved = realpath(path.c_str(), nullptr);
+    if (resolved == nullptr) {
+        throw MounterException(-1, "semântico", "Arquivo incluído \"" + name + "\" não encontrado");
+    }
+    const string canonical(resolved);
+    free(resolved);
+
+    // Um arquivo que já está sendo préprocessado não pode ser incluído de novo
+    if (find(include_stack.begin(), include_stack.end(), canonical) != include_stack.end()) {
+        cycle_found = true;
+        string chain = "";
+        for (const string &file : include_stack) chain += file + " -> ";
+        throw MounterException(-1, "semântico", "Inclusão cíclica: " + chain + canonical);
+    }
+    // Um arquivo incluído mais de uma vez contribui apenas na primeira
+    if (!included.insert(canonical).second) return;
+
+    const shared_ptr<const included_file> file = load_include(canonical);
+    dependencies.insert(dependencies.end(), file->dependencies.begin(), file->dependencies.end());
+    included_text = file->text;
+    included_errors = file->errors;
+
+    // Sinônimos já definidos só podem ser repetidos com o mesmo valor
+    string conflict = "";
+    for (const auto &synonym : file->synonym_table) {
+        auto synonym_entry = synonym_table.insert(synonym);
+        if (!synonym_entry.second && synonym_entry.first->second != synonym.second && conflict.empty()) conflict = synonym.first;
+    }
+    if ANY(conflict) {
+        throw MounterException(-1, "semântico", "Redefinição do rótulo \"" + conflict + "\" pelo arquivo incluído \"" + name + "\"");
+    }
+}
+
+shared_ptr<const included_file> Preprocesser::load_include(const string &path) {
+    // Cache de arquivos incluídos, compartilhado por todos os préprocessadores do processo
+    static mutex cache_lock;
+    static map<string, shared_ptr<const included_file>> cache;
+    {
+        lock_guard<mutex> lock(cache_lock);
+        auto cache_entry = cache.find(path);
+        if (cache_entry != cache.end()) {
+            bool fresh = true;
+            for (const auto &dependency : cache_entry->second->dependencies) {
+                if (modification_time(dependency.first) != dependency.second) fresh = false;
+            }
+            if (fresh) {
+                if (verbose) cout << "[" << __FILE__ << "]> Reaproveitando a inclusão de \"" << path << "\"" << endl;
+                return cache_entry->second;
+            }
+        }
+    }
+
+    // A data é lida antes do conteúdo, então uma alteração durante a leitura invalida o resultado
+    const long long modified = modification_time(path);
+    const string text = read_file(path);
+    if (verbose) cout << "[" << __FILE__ << "]> Préprocessando o arquivo incluído \"" << path << "\"" << endl;
+
+    Preprocesser nested(tables, verbose);
+    nested.include_stack = include_stack;
+    nested.include_stack.push_back(path);
+    nested.line_cache = line_cache;
+    shared_ptr<included_file> file = make_shared<included_file>();
+    file->text = nested.preprocess_body(text, file->errors, false);
+    file->synonym_table = nested.synonym_table;
+    // Os erros que ainda não apontam um arquivo são do próprio arquivo incluído
+    for (diagnostic &error : file->errors) {
+        if (error.line != -1 && error.file.empty()) error.file = path;
+    }
+    file->dependencies.push_back(make_pair(path, modified));
+    file->dependencies.insert(file->dependencies.end(), nested.dependencies.begin(), nested.dependencies.end());
+
+    // O resultado de uma inclusão cíclica depende de quem incluiu o arquivo, então não é guardado
+    if (nested.cycle_found) cycle_found = true;
+    else {
+        lock_guard<mutex> lock(cache_lock);
+        cache[path] = file;
+    }
+    return file;
+}
+
+void Preprocesser::index_conditional(const char* begin, const char* end, int line_number) {
+    // Separa até duas palavras, parando no comentário
+    string words[2];
+    int word_count = 0;
+    const char* cursor = begin;
+    while (word_count < 2 && cursor < end) {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+        if (cursor == end || *cursor == ';') break;
+        const char* word_start = cursor;
+        while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != ';') cursor++;
+        words[word_count++].assign(word_start, cursor);
+        // Um rótulo é seguido da palavra que interessa
+        if (word_count == 1 && words[0].back() != ':') break;
+    }
+    if (word_count == 0) return;
+
+    string keyword = words[word_count - 1];
+    if (keyword.length() > 7) return;
+    transform(keyword.begin(), keyword.end(), keyword.begin(), 
+        [](unsigned char c) { return toupper(c); }
+    );
+
+    // O IF de uma linha não participa dos blocos, então um IF dentro de um bloco não o fecha nem o desloca
+    if (keyword == "IFBLOCK") {
+        open_blocks.push_back(line_number);
+        conditional_blocks[line_number] = conditional_block {-1, -1};
+    }
+    else if (keyword == "ELSE") {
+        // Um segundo ELSE no mesmo bloco fica sem correspondência, e é apontado ao ser processado
+        if (ANY(open_blocks) && conditional_blocks[open_blocks.back()].else_line == -1) {
+            conditional_blocks[open_blocks.back()].else_line = line_number;
+        }
+    }
+    else if (keyword == "ENDIF" && ANY(open_blocks)) {
+        conditional_block &block = conditional_blocks[open_blocks.back()];
+        block.endif_line = line_number;
+        if (block.else_line != -1) else_lines[block.else_line] = line_number;
+        endif_lines[line_number] = open_blocks.back();
+        open_blocks.pop_back();
+    }
+}
+
+void Preprocesser::finish_conditional_index() {
+    // IFBLOCKs que ficaram abertos são apontados ao serem processados
+    for (const int if_line : open_blocks) conditional_blocks.erase(if_line);
+    open_blocks.clear();
+}
+
+const conditional_block* Preprocesser::find_block(int line) const {
+    auto block_entry = conditional_blocks.find(line);
+    return block_entry == conditional_blocks.end() ? nullptr : &block_entry->second;
+}
+
+int Preprocesser::find_else_end(int line) const {
+    auto else_entry = else_lines.find(line);
+    return else_entry == else_lines.end() ? -1 : else_entry->second;
+}
+
+void Preprocesser::process_lines(vector<asm_line> &lines, string &output_lines, string &error_log) {
+    vector<diagnostic> errors;
+    process_lines(lines, output_lines, errors);
+    append_log(error_log, errors);
+}
+
+void Preprocesser::process_lines(vector<asm_line> &lines, string &output_lines, vector<diagnostic> &errors) {
+    auto line_iterator = lines.begin();
+    // Registra o tempo de cada lote de linhas
+    TraceBatches batches("preprocess: lote");
+    // Um IF no fim do lote anterior pula a primeira linha deste
+    if (skip_pending && line_iterator != lines.end()) {
+        skip_pending = false;
+        line_iterator++;
+    }
+
+    // Passa por cada linha
+    for (; line_iterator != lines.end(); line_iterator == lines.end() ? line_iterator : line_iterator++) {
+        // Linhas de um trecho condicional não tomado
+        if (line_iterator->number < resume_line) continue;
+        batches.step(line_iterator->number);
+        try {
+            // cout << "Processando linha " << line_iterator->number << endl;
+            const string new_line = process_line(line_iterator);
+            if (kept_lines != nullptr) {
+                if (!new_line.empty()) kept_lines->push_back(*line_iterator);
+            }
+            else if (!checking) output_lines += (new_line.empty() ? "" : new_line + "\n");
+            // A diretiva saltou para além do lote
+            if (line_iterator == lines.end()) skip_pending = true;
+        }
+        catch (MounterException error) {
+            if (verbose) cout << "Erro na linha " << line_iterator->number << " (" << error.what() << ")" << endl;
+            // Coleta informações sobre o erro
+            const int line = (error.get_line() == -1 ? line_iterator->number : error.get_line());
+
+            errors.push_back(diagnostic {line, error.get_type(), error.what()});
+        }
+        // Um INCLUDE traz as linhas e os erros do arquivo incluído
+        if ANY(included_text) {
+            if (!checking && kept_lines == nullptr) output_lines += included_text;
+            included_text.clear();
+        }
+        if ANY(included_errors) {
+            errors.insert(errors.end(), included_errors.begin(), included_errors.end());
+            included_errors.clear();
+        }
+    }
 }
 
 string Preprocesser::process_line(vector<asm_line>::iterator &line_iterator) {
+    ALLOC_SITE("préprocessamento de linhas");
     asm_line &line = *line_iterator;
 
     // cout << "Tabela de sinônimos:\n";
@@ -115,17 +506,14 @@ string Preprocesser::process_line(vector<asm_line>::iterator &line_iterator) {
     //     cout << it->first << ": " << to_string(it->second) << endl;
     // }
 
-    // Substitui ocorrências de sinônimos pelos seus valores
-    if NOT_EMPTY(line.operand[0]) {
-        auto synonym_entry = synonym_table.find(line.operand[0]);
-        if (synonym_entry != synonym_table.end()) {
-            line.operand[0] = to_string(synonym_entry->second);
-        }
-    }
-    if NOT_EMPTY(line.operand[1]) {
-        auto synonym_entry = synonym_table.find(line.operand[1]);
-        if (synonym_entry != synonym_table.end()) {
-            line.operand[1] = to_string(synonym_entry->second);
+    // Substitui ocorrências de sinônimos pelos seus valores, que já são literais
+    for (int index = 0; index < 2; index++) {
+        if NOT_EMPTY(line.operand[index]) {
+            auto synonym_entry = synonym_table.find(line.operand[index]);
+            if (synonym_entry != synonym_table.end()) {
+                line.operand[index] = to_string(synonym_entry->second);
+                line.operand_literal[index] = literal {VALID_LITERAL, synonym_entry->second};
+            }
         }
     }
 
@@ -141,7 +529,7 @@ string Preprocesser::process_line(vector<asm_line>::iterator &line_iterator) {
     }
     
     // Imprime a linha no arquivo final
-    string label = NOT_EMPTY(line.label) ? line.label + "\n    " : "    ";
+    string label = NOT_EMPTY(line.label) ? line.label + ":\n    " : "    ";
     const string operation = line.operation;
     const string operands = line.operand[0] != "" ? (" " + line.operand[0] + (line.operand[1] != "" ? ", " + line.operand[1] : "")) : "";
     const string assembled_line = label + operation + operands;
@@ -6,7 +6,11 @@
 #include <iostream>
 #include <fstream>
 #include "../include/scanner.hpp"
+#include "../include/file_io.hpp"
 #include "../include/mounter_exception.hpp"
+#include "../include/tracer.hpp"
+#include "../include/error_log.hpp"
+#include "../include/alloc_stats.hpp"
 
 using namespace std;
 
@@ -17,6 +21,12 @@ using namespace std;
 #define IS_LABEL(token) (token.length()>1) && (token.find(':') != string::npos)
 
 vector<asm_line> Scanner::scan (string source_path, string &error_log, bool print/*  = false */) {
+    // A entrada padrão é lida de uma vez, em blocos grandes
+    if (is_standard_stream(source_path)) {
+        istringstream source(read_input(source_path));
+        return scan(source, error_log, print);
+    }
+
     // Lê o arquivo e gera a sua stream
     fstream source(source_path);
 
@@ -27,6 +37,17 @@ vector<asm_line> Scanner::scan (string source_path, string &error_log, bool prin
         throw error;
     }
 
+    vector<asm_line> program_lines = scan(source, error_log, print);
+
+    // Fecha o arquivo
+    source.close();
+
+    return program_lines;
+}
+
+vector<asm_line> Scanner::scan (istream &source, string &error_log, bool print/*  = false */) {
+    TraceScope trace("scan");
+
     // Início do loop principal
     // Vai receber cada uma das linhas brutas
     string line;
@@ -34,130 +55,151 @@ vector<asm_line> Scanner::scan (string source_path, string &error_log, bool prin
     string stray_label;
     // Armazena a estrutura do programa
     vector<asm_line> program_lines;
+    // Registra o tempo de cada lote de linhas
+    TraceBatches batches("scan: lote");
     
     for (
         int line_number = 1;
         getline(source, line);
         line_number++
     ) {
-        try {
-            // Remove o /r da linha
-            // line.pop_back();
-            // cout << "Line: <" << line << ">" << endl;
-            if (line.empty()) continue;
-            
-            // Separa a linha em elementos
-            asm_line broken_line = break_line(line, line_number);
-
-            // Se for uma linha com operação, já registramos
-            if HAS_OPERATION(broken_line) {
-                // Verificamos se há um rótulo declarado anteriormente para essa operação
-                assign_label(broken_line, stray_label);
-                // Registra essa linha de código
-                program_lines.push_back(broken_line);
-            }
-            
-            // Se a linha só tiver rótulo, aplicamos ele na linha seguinte
-            else if ANY(broken_line.label) {
-                // Se já tiver uma armazenada, é erro
-                if ANY(stray_label) {
-                    stray_label = broken_line.label;
-                    asm_line dummy_line;
-                    dummy_line.operation = "";
-                    throw ScannerException(broken_line.number, "semântico", NON_OMITABLE, dummy_line,
-                        string("Mais de um rótulo declarado para a mesma linha")
-                    );
-                }
+        batches.step(line_number);
+        scan_line(line, line_number, stray_label, program_lines, error_log);
+        if (max_errors > 0) {
+            const size_t errors = diagnostics != nullptr ? diagnostics->size() : error_list != nullptr ? error_list->size() : count_log_entries(error_log);
+            if (errors >= max_errors) break;
+        }
+    }
+
+    if (print) {
+        cout << "Estrutura do programa: {" << endl;
+        print_lines(program_lines);
+        cout << "}" << endl;
+    }
+
+    return program_lines;
+}
+
+void Scanner::scan_line(string line, int line_number, string &stray_label, vector<asm_line> &program_lines, string &error_log) {
+    ALLOC_SITE("linhas do programa (asm_line)");
+    try {
+        // Remove o /r da linha
+        // line.pop_back();
+        // cout << "Line: <" << line << ">" << endl;
+        if (line.empty()) return;
+        
+        // Separa a linha em elementos
+        asm_line broken_line = (line_cache == nullptr ? break_line(line, line_number) : cached_break_line(line, line_number));
+
+        // Se for uma linha com operação, já registramos
+        if HAS_OPERATION(broken_line) {
+            // Verificamos se há um rótulo declarado anteriormente para essa operação
+            assign_label(broken_line, stray_label);
+            // Registra essa linha de código
+            program_lines.push_back(broken_line);
+        }
+        
+        // Se a linha só tiver rótulo, aplicamos ele na linha seguinte
+        else if ANY(broken_line.label) {
+            // Se já tiver uma armazenada, é erro
+            if ANY(stray_label) {
                 stray_label = broken_line.label;
+                asm_line dummy_line;
+                dummy_line.operation = "";
+                throw ScannerException(broken_line.number, "semântico", NON_OMITABLE, dummy_line,
+                    string("Mais de um rótulo declarado para a mesma linha")
+                );
             }
+            stray_label = broken_line.label;
         }
-        catch (ScannerException &error) {
-            // Se o erro não for omitível ou o scanner for configurado para reportar todos os erros, adiciona ao log
-            if (error.not_omitable() || report_all_errors == true) {
-                string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
-                error_log += intro + error.get_type() + ": " + error.what() + "\n";
+    }
+    catch (ScannerException &error) {
+        // Se o erro não for omitível ou o scanner for configurado para reportar todos os erros, adiciona ao log
+        if (error.not_omitable() || report_all_errors == true) {
+            report(error.get_line(), error.get_type(), error.what(), error_log);
+        }
+        // Constroi o que puder, para que chegue até o fim
+        asm_line provisory_line = error.get_provisory_line();
+        if ANY(provisory_line.operation) {
+            // Recebe o mesmo tratamento de rótulo
+            try {
+                assign_label(provisory_line, stray_label);
             }
-            // Constroi o que puder, para que chegue até o fim
-            asm_line provisory_line = error.get_provisory_line();
-            if ANY(provisory_line.operation) {
-                // Recebe o mesmo tratamento de rótulo
-                try {
-                    assign_label(provisory_line, stray_label);
-                }
-                catch (ScannerException &error) {
-                    string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
-                    error_log += intro + error.get_type() + ": " + error.what() + "\n";
-                }
-                // Registra essa linha de código
-                program_lines.push_back(provisory_line);
+            catch (ScannerException &error) {
+                report(error.get_line(), error.get_type(), error.what(), error_log);
             }
-            // Se a linha só tiver rótulo, aplicamos ele na linha seguinte
-            else if ANY(provisory_line.label) {
-                // Se já tiver uma armazenada, é erro
-                if ANY(stray_label) {
-                    stray_label = provisory_line.label;
-                    string intro = (provisory_line.number == -1 ? "Erro " : "Na linha " + to_string(provisory_line.number) + ", erro ");
-                    error_log += intro + "semântico: Mais de um rótulo declarado para a mesma linha\n";
-                }
+            // Registra essa linha de código
+            program_lines.push_back(provisory_line);
+        }
+        // Se a linha só tiver rótulo, aplicamos ele na linha seguinte
+        else if ANY(provisory_line.label) {
+            // Se já tiver uma armazenada, é erro
+            if ANY(stray_label) {
                 stray_label = provisory_line.label;
+                report(provisory_line.number, "semântico", "Mais de um rótulo declarado para a mesma linha", error_log);
             }
+            stray_label = provisory_line.label;
         }
-        // Batch de exceções da mesma linha
-        catch (vector<ScannerException> &batch) {
-            // Já coloca a linha provisória no programa
-            asm_line provisory_line = batch.at(0).get_provisory_line();
-            if ANY(provisory_line.operation) {
-                // Recebe o mesmo tratamento de rótulo
-                try {
-                    assign_label(provisory_line, stray_label);
-                }
-                catch (ScannerException &error) {
-                    string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
-                    error_log += intro + error.get_type() + ": " + error.what() + "\n";
-                }
-                // Registra essa linha de código
-                program_lines.push_back(provisory_line);
+    }
+    // Batch de exceções da mesma linha
+    catch (vector<ScannerException> &batch) {
+        // Já coloca a linha provisória no programa
+        asm_line provisory_line = batch.at(0).get_provisory_line();
+        if ANY(provisory_line.operation) {
+            // Recebe o mesmo tratamento de rótulo
+            try {
+                assign_label(provisory_line, stray_label);
             }
-            // Se a linha só tiver rótulos, aplicamos eles na linha seguinte
-            else if ANY(provisory_line.label) {
-                // Se já tiver uma armazenada, é erro
-                if ANY(stray_label) {
-                    stray_label = provisory_line.label;
-                    string intro = (provisory_line.number == -1 ? "Erro " : "Na linha " + to_string(provisory_line.number) + ", erro ");
-                    error_log += intro + "semântico: Mais de um rótulo declarado para a mesma linha\n";
-                }
+            catch (ScannerException &error) {
+                report(error.get_line(), error.get_type(), error.what(), error_log);
+            }
+            // Registra essa linha de código
+            program_lines.push_back(provisory_line);
+        }
+        // Se a linha só tiver rótulos, aplicamos eles na linha seguinte
+        else if ANY(provisory_line.label) {
+            // Se já tiver uma armazenada, é erro
+            if ANY(stray_label) {
                 stray_label = provisory_line.label;
+                report(provisory_line.number, "semântico", "Mais de um rótulo declarado para a mesma linha", error_log);
             }
+            stray_label = provisory_line.label;
+        }
 
-            // Adiciona cada erro ao log
-            for (const ScannerException error : batch) {
-                // Se o erro não for omitível ou o scanner for configurado para reportar todos os erros, adiciona ao log
-                if (error.not_omitable() || report_all_errors == true) {
-                    string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
-                    error_log += intro + error.get_type() + ": " + error.what() + "\n";
-                }
+        // Adiciona cada erro ao log
+        for (const ScannerException error : batch) {
+            // Se o erro não for omitível ou o scanner for configurado para reportar todos os erros, adiciona ao log
+            if (error.not_omitable() || report_all_errors == true) {
+                report(error.get_line(), error.get_type(), error.what(), error_log);
             }
         }
     }
+}
 
-    // Fecha o arquivo
-    source.close();
-
-    if (print) {
-        cout << "Estrutura do programa: {" << endl;
-        for (const asm_line line : program_lines) {
-            cout << "\tLinha " << line.number << ": {";
-            string output = "";
-            if ANY(line.label) output += "label: \"" + line.label + "\", ";
-            if HAS_OPERATION(line) output += "operation: \"" + line.operation + "\", ";
-            if ANY(line.operand[0]) output += "operand1: \"" + line.operand[0] + "\", ";
-            if ANY(line.operand[1]) output += "operand2: \"" + line.operand[1] + "\", ";
-            cout << output.substr(0, output.length() - 2) << "}" << endl;
-        }
-        cout << "}" << endl;
+void Scanner::report(int line, const string &type, const string &message, string &error_log) {
+    ALLOC_SITE("diagnósticos");
+    if (diagnostics != nullptr) {
+        diagnostics->add(line, type, message);
+        return;
     }
+    if (error_list != nullptr) {
+        error_list->push_back(diagnostic {line, type, message});
+        return;
+    }
+    string intro = (line == -1 ? "Erro " : "Na linha " + to_string(line) + ", erro ");
+    error_log += intro + type + ": " + message + "\n";
+}
 
-    return program_lines;
+void Scanner::print_lines(const vector<asm_line> &program_lines) {
+    for (const asm_line line : program_lines) {
+        cout << "\tLinha " << line.number << ": {";
+        string output = "";
+        if ANY(line.label) output += "label: \"" + line.label + "\", ";
+        if HAS_OPERATION(line) output += "operation: \"" + line.operation + "\", ";
+        if ANY(line.operand[0]) output += "operand1: \"" + line.operand[0] + "\", ";
+        if ANY(line.operand[1]) output += "operand2: \"" + line.operand[1] + "\", ";
+        cout << output.substr(0, output.length() - 2) << "}" << endl;
+    }
 }
 
 void Scanner::assign_label(asm_line &line, string &stray_label) {
@@ -175,6 +217,42 @@ void Scanner::assign_label(asm_line &line, string &stray_label) {
     }
 }
 
+asm_line Scanner::cached_break_line(const string &line, int line_number) {
+    auto cache_entry = line_cache->find(line);
+    if (cache_entry == line_cache->end()) {
+        scanned_line result {line_number, asm_line(), {}, false};
+        try {
+            result.line = break_line(line, line_number);
+        }
+        catch (ScannerException &error) {
+            result.errors.push_back(error);
+            result.single_error = true;
+        }
+        catch (vector<ScannerException> &batch) {
+            result.errors.swap(batch);
+        }
+        cache_entry = line_cache->emplace(line, result).first;
+    }
+    const scanned_line &cached = cache_entry->second;
+
+    // O resultado guardado é renumerado para a linha atual
+    if (cached.errors.empty()) {
+        asm_line broken_line = cached.line;
+        broken_line.number = line_number;
+        return broken_line;
+    }
+    vector<ScannerException> batch;
+    for (const ScannerException &error : cached.errors) {
+        asm_line provisory_line = error.get_provisory_line();
+        if (provisory_line.number == cached.number) provisory_line.number = line_number;
+        batch.push_back(ScannerException(error.get_line() == cached.number ? line_number : error.get_line(),
+            error.get_type(), !error.not_omitable(), provisory_line, error.what()
+        ));
+    }
+    if (cached.single_error) throw batch.front();
+    throw batch;
+}
+
 asm_line Scanner::break_line(string line, int line_number) {
     // cout << "Linha não formatada: \"" << line << "\"" << endl;
 
@@ -241,6 +319,14 @@ asm_line Scanner::break_line(string line, int line_number) {
             break;
         }
 
+        // O caminho de um INCLUDE mantém a caixa original
+        if (operation_ok && !operand1_ok && line_tokens.operation == "INCLUDE") {
+            line_tokens.operand[0] = token;
+            operand1_ok = true;
+            operand2_ok = true;
+            continue;
+        }
+
         // Tudo em caixa alta
         transform(token.begin(), token.end(), token.begin(), 
             [](unsigned char c) { return toupper(c); }
@@ -381,6 +467,10 @@ asm_line Scanner::break_line(string line, int line_number) {
         exceptions.push_back(error);
     };
 
+    // Os literais são classificados uma única vez, aqui
+    line_tokens.operand_literal[0] = parse_literal(line_tokens.operand[0]);
+    line_tokens.operand_literal[1] = parse_literal(line_tokens.operand[1]);
+
     if (exceptions.empty()) {
         return line_tokens;
     }
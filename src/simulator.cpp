@@ -0,0 +1,224 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include "../include/simulator.hpp"
+#include "../include/file_io.hpp"
+#include "../include/object_reader.hpp"
+#include "../include/object_archive.hpp"
+#include "../include/mounter_exception.hpp"
+
+using namespace std;
+
+// Erro de execução, que interrompe a simulação
+#define RUNTIME_ERROR(address, message) MounterException(-1, "execução", "Endereço " + to_string(address) + ": " + message)
+
+namespace {
+    // O acumulador tem 32 bits e estoura circularmente. As contas são feitas sem sinal, onde o estouro é definido
+    int wrapped(uint32_t value) {
+        return (int) value;
+    }
+}
+
+Simulator::Simulator(shared_ptr<const isa_tables> tables, bool verbose/* = false */) : verbose(verbose), tables(tables), profiling(false), step_limit(0) {
+    // Associa cada opcode à sua semântica pelo nome da instrução
+    const map<string, instruction_semantics> names = {
+        {"ADD", ADD}, {"SUB", SUB}, {"MULT", MULT}, {"DIV", DIV}, {"JMP", JMP}, {"JMPN", JMPN}, {"JMPP", JMPP},
+        {"JMPZ", JMPZ}, {"COPY", COPY}, {"LOAD", LOAD}, {"STORE", STORE}, {"INPUT", INPUT}, {"OUTPUT", OUTPUT}, {"STOP", STOP}
+    };
+    for (const auto &instruction : tables->instruction_table) {
+        auto name = names.find(instruction.first);
+        const int opcode = instruction.second[0];
+        if (name == names.end() || opcode < 0) continue;
+        if ((size_t) opcode >= semantics.size()) {
+            semantics.resize(opcode + 1, INVALID_INSTRUCTION);
+            sizes.resize(opcode + 1, 0);
+        }
+        semantics[opcode] = name->second;
+        sizes[opcode] = instruction.second[1];
+    }
+}
+
+vector<int> Simulator::load(string path) {
+    string archive_path, member;
+    const bool archived = split_archive_path(path, archive_path, member);
+    // Levanta erro se receber o tipo errado de arquivo
+    if (!has_extension(archived ? member : path, ".obj")) {
+        throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .obj para o modo simulação");
+    }
+    ObjectReader reader(tables, verbose);
+    if (!archived) return reader.read(path);
+
+    // O arquivo de objetos é mapeado uma única vez, e cada membro é encontrado pelo índice
+    shared_ptr<ObjectArchive> &archive = archives[archive_path];
+    if (!archive) archive = make_shared<ObjectArchive>(archive_path);
+    vector<int> image = archive->words(archive->find(member));
+    reader.validate(image);
+    return image;
+}
+
+void Simulator::run(const vector<int> &image, istream &input, ostream &output) {
+    // A cópia reaproveita a capacidade da execução anterior
+    memory.assign(image.begin(), image.end());
+    const size_t size = memory.size();
+    profile = execution_profile {
+        vector<uint64_t>(profiling ? size : 0), vector<uint64_t>(profiling ? size : 0), vector<uint64_t>(profiling ? size : 0),
+        vector<uint64_t>(profiling ? size : 0), vector<uint64_t>(profiling ? size : 0), 0
+    };
+    // Sem o perfil, o laço de execução não carrega nenhum contador
+    if (profiling) execute<true>(input, output);
+    else execute<false>(input, output);
+}
+
+template <bool PROFILE>
+void Simulator::execute(istream &input, ostream &output) {
+    const int size = memory.size();
+    int accumulator = 0;
+    int pc = 0;
+    uint64_t steps = 0;
+
+    // Acessos à memória verificam os limites e, com o perfil, contam leituras e escritas
+    auto load = [&](int address) -> int {
+        if (address < 0 || address >= size) throw RUNTIME_ERROR(pc, "acesso à memória fora do programa (" + to_string(address) + ")");
+        if (PROFILE) profile.loads[address]++;
+        return memory[address];
+    };
+    auto store = [&](int address, int value) {
+        if (address < 0 || address >= size) throw RUNTIME_ERROR(pc, "acesso à memória fora do programa (" + to_string(address) + ")");
+        if (PROFILE) profile.stores[address]++;
+        memory[address] = value;
+    };
+    auto branch = [&](bool condition, int target) {
+        if (PROFILE) (condition ? profile.taken : profile.not_taken)[pc]++;
+        return condition ? target : pc + 2;
+    };
+
+    // Uma execução interrompida, como no limite de instruções, também registra os passos no perfil
+    try {
+        while (true) {
+            if (pc < 0 || pc >= size) throw RUNTIME_ERROR(pc, "execução fora do programa");
+            const int opcode = memory[pc];
+            if (opcode < 0 || opcode >= (int) semantics.size() || semantics[opcode] == INVALID_INSTRUCTION) {
+                throw RUNTIME_ERROR(pc, "opcode inválido (" + to_string(opcode) + ")");
+            }
+            if (pc + sizes[opcode] > size) throw RUNTIME_ERROR(pc, "instrução incompleta no fim do programa");
+            if (step_limit > 0 && steps == step_limit) throw RUNTIME_ERROR(pc, "limite de " + to_string(step_limit) + " instruções executadas atingido");
+            if (PROFILE) profile.executions[pc]++;
+            steps++;
+
+            const int operand = sizes[opcode] > 1 ? memory[pc + 1] : 0;
+            int next = pc + sizes[opcode];
+            switch (semantics[opcode]) {
+                case ADD: accumulator = wrapped((uint32_t) accumulator + (uint32_t) load(operand)); break;
+                case SUB: accumulator = wrapped((uint32_t) accumulator - (uint32_t) load(operand)); break;
+                case MULT: accumulator = wrapped((uint32_t) accumulator * (uint32_t) load(operand)); break;
+                case DIV: {
+                    const int divisor = load(operand);
+                    if (divisor == 0) throw RUNTIME_ERROR(pc, "divisão por zero");
+                    // O menor inteiro dividido por -1 estoura, então a divisão por -1 é a negação
+                    if (divisor == -1) accumulator = wrapped(0u - (uint32_t) accumulator);
+                    else accumulator /= divisor;
+                    break;
+                }
+                case JMP: next = operand; break;
+                case JMPN: next = branch(accumulator < 0, operand); break;
+                case JMPP: next = branch(accumulator > 0, operand); break;
+                case JMPZ: next = branch(accumulator == 0, operand); break;
+                case COPY: store(memory[pc + 2], load(operand)); break;
+                case LOAD: accumulator = load(operand); break;
+                case STORE: store(operand, accumulator); break;
+                case INPUT: {
+                    int value;
+                    if (!(input >> value)) throw RUNTIME_ERROR(pc, "entrada inválida ou ausente para INPUT");
+                    store(operand, value);
+                    break;
+                }
+                // Sem descarregar a stream a cada saída, o que pesaria em execuções longas
+                case OUTPUT: output << load(operand) << '\n'; break;
+                case STOP: profile.steps = steps; return;
+                default: break;
+            }
+            pc = next;
+        }
+    }
+    catch (...) {
+        profile.steps = steps;
+        throw;
+    }
+}
+
+address_map Simulator::load_symbol_map(string path) {
+    address_map symbols;
+    fstream source(path, fstream::in);
+    if (!source.is_open()) return symbols;
+    string kind, name;
+    int address, line;
+    while (source >> kind) {
+        if (kind == "S:" && source >> name >> address) symbols.labels[address] = name;
+        else if (kind == "L:" && source >> address >> line) symbols.lines[address] = line;
+        else throw invalid_argument("Mapa de símbolos inválido: \"" + path + "\"");
+    }
+    if (verbose) cout << "[" << __FILE__ << "]> Mapa de símbolos com " << symbols.labels.size() << " rótulos e " << symbols.lines.size() << " linhas" << endl;
+    return symbols;
+}
+
+string Simulator::describe(int address, const address_map &symbols) {
+    string description = to_string(address);
+    // Rótulo mais próximo até o endereço
+    auto label = symbols.labels.upper_bound(address);
+    if (label != symbols.labels.begin()) {
+        label--;
+        description += " (" + label->second + (label->first == address ? "" : "+" + to_string(address - label->first)) + ")";
+    }
+    auto line = symbols.lines.find(address);
+    if (line != symbols.lines.end()) description += " linha " + to_string(line->second);
+    return description;
+}
+
+string Simulator::profile_report(const address_map &symbols) {
+    ostringstream report;
+    report << "Perfil de execução: " << profile.steps << " instruções executadas" << endl;
+    if (profile.executions.empty()) return report.str();
+
+    // Ordena os endereços de um contador, do mais ao menos frequente, ignorando os zerados
+    auto hottest = [](const vector<uint64_t> &first, const vector<uint64_t> &second) {
+        vector<int> addresses;
+        for (size_t address = 0; address < first.size(); address++) {
+            if (first[address] + second[address] > 0) addresses.push_back(address);
+        }
+        stable_sort(addresses.begin(), addresses.end(), [&](int a, int b) {
+            return first[a] + second[a] > first[b] + second[b];
+        });
+        return addresses;
+    };
+    const vector<uint64_t> none(profile.executions.size(), 0);
+
+    report << "Instruções mais executadas:" << endl;
+    const vector<int> instructions = hottest(profile.executions, none);
+    for (size_t index = 0; index < instructions.size() && index < PROFILE_REPORT_SIZE; index++) {
+        const int address = instructions[index];
+        report << "\t" << describe(address, symbols) << ": " << profile.executions[address] << " vezes ("
+            << fixed << setprecision(1) << 100.0 * profile.executions[address] / profile.steps << "%)" << endl;
+    }
+
+    const vector<int> branches = hottest(profile.taken, profile.not_taken);
+    if (!branches.empty()) {
+        report << "Saltos condicionais (tomados / não tomados):" << endl;
+        for (const int address : branches) {
+            report << "\t" << describe(address, symbols) << ": " << profile.taken[address] << " / " << profile.not_taken[address] << endl;
+        }
+    }
+
+    const vector<int> data = hottest(profile.loads, profile.stores);
+    if (!data.empty()) {
+        report << "Dados mais acessados (leituras / escritas):" << endl;
+        for (size_t index = 0; index < data.size() && index < PROFILE_REPORT_SIZE; index++) {
+            const int address = data[index];
+            report << "\t" << describe(address, symbols) << ": " << profile.loads[address] << " / " << profile.stores[address] << endl;
+        }
+    }
+    return report.str();
+}
@@ -0,0 +1,99 @@
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../include/spill_file.hpp"
+
+using namespace std;
+
+SpillFile::SpillFile() : mapping(nullptr), size(0), position(0) {
+    const char* directory = getenv("TMPDIR");
+    string path_template = string(directory == nullptr ? "/tmp" : directory) + "/montador-XXXXXX";
+    descriptor = mkstemp(&path_template[0]);
+    if (descriptor == -1) {
+        throw invalid_argument("Não foi possível criar um arquivo temporário em \"" + path_template + "\"");
+    }
+    // O arquivo some assim que o descritor for fechado
+    unlink(path_template.c_str());
+    buffer.reserve(SPILL_BUFFER_SIZE);
+}
+
+SpillFile::~SpillFile() {
+    if (mapping != nullptr) munmap((void*) mapping, size);
+    close(descriptor);
+}
+
+void SpillFile::flush() {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        const ssize_t result = write(descriptor, buffer.data() + written, buffer.size() - written);
+        if (result == -1) {
+            throw invalid_argument("Falha ao escrever no arquivo temporário: " + string(strerror(errno)));
+        }
+        written += result;
+    }
+    size += buffer.size();
+    buffer.clear();
+}
+
+void SpillFile::append(const asm_line &line) {
+    const int32_t header[3] = {line.number, line.opcode, line.span};
+    buffer.append((const char*) header, sizeof(header));
+    for (const string *field : {&line.operation, &line.operand[0], &line.operand[1]}) {
+        // O comprimento tem 32 bits, como o de qualquer rótulo ou operando que caiba na memória
+        const uint32_t length = field->length();
+        buffer.append((const char*) &length, sizeof(length));
+        buffer.append(*field);
+    }
+    if (buffer.size() >= SPILL_BUFFER_SIZE) flush();
+}
+
+void SpillFile::finish() {
+    flush();
+    if (size == 0) return;
+
+    void* region = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (region == MAP_FAILED) {
+        throw invalid_argument("Falha ao mapear o arquivo temporário: " + string(strerror(errno)));
+    }
+    // A leitura é sequencial
+    madvise(region, size, MADV_SEQUENTIAL);
+    mapping = (const char*) region;
+}
+
+void SpillFile::corrupted() const {
+    throw invalid_argument("Arquivo temporário da montagem fora de memória corrompido: registro além do fim do arquivo");
+}
+
+void SpillFile::read_string(string &field) {
+    uint32_t length;
+    if (size - position < sizeof(length)) corrupted();
+    memcpy(&length, mapping + position, sizeof(length));
+    position += sizeof(length);
+    if (size - position < length) corrupted();
+    field.assign(mapping + position, length);
+    position += length;
+}
+
+bool SpillFile::next(asm_line &line) {
+    if (position >= size) return false;
+
+    int32_t header[3];
+    if (size - position < sizeof(header)) corrupted();
+    memcpy(header, mapping + position, sizeof(header));
+    position += sizeof(header);
+    line.number = header[0];
+    line.opcode = header[1];
+    line.span = header[2];
+    line.label.clear();
+    read_string(line.operation);
+    read_string(line.operand[0]);
+    read_string(line.operand[1]);
+    // A classificação dos literais não é gravada, pois é refeita rapidamente a partir do texto
+    line.operand_literal[0] = parse_literal(line.operand[0]);
+    line.operand_literal[1] = parse_literal(line.operand[1]);
+    return true;
+}
@@ -0,0 +1,104 @@
+#include "../include/stripper.hpp"
+
+using namespace std;
+
+#define ANY(thing) (!thing.empty())
+// Quantidade de rótulos removidos listados no relatório
+#define REPORTED_LABELS 10
+
+namespace {
+    // Instruções depois das quais a execução não continua na seguinte
+    bool ends_flow(const string &operation) {
+        return operation == "JMP" || operation == "STOP";
+    }
+}
+
+DeadSymbolStripper::DeadSymbolStripper(const map<string, int[2]> &instruction_table) : addresses(instruction_table), removed_code(0), removed_data(0), removed_bytes(0) {}
+
+int DeadSymbolStripper::strip(vector<asm_line> &lines, map<string, int> &symbol_table, const map<string, int> &public_symbols, const set<string> &extern_symbols) {
+    const int count = lines.size();
+
+    addresses.measure(lines);
+    const int total = addresses.size();
+    // Linha apontada por um operando, -1 se não for um rótulo local
+    auto line_of = [&](const string &label) {
+        if (!ANY(label) || extern_symbols.count(label) > 0) return -1;
+        auto symbol_entry = symbol_table.find(label);
+        if (symbol_entry == symbol_table.end() || symbol_entry->second < 0 || symbol_entry->second >= total) return -1;
+        return addresses.line_at(symbol_entry->second);
+    };
+    // A primeira passagem tira os rótulos das linhas, então eles vêm da tabela de símbolos
+    vector<bool> labeled(count, false);
+    for (const auto &symbol_entry : symbol_table) {
+        const int index = line_of(symbol_entry.first);
+        if (index != -1) labeled[index] = true;
+    }
+
+    // Busca a partir do endereço 0 e dos símbolos públicos, que outros módulos podem usar
+    vector<bool> reached(count, false);
+    vector<int> pending;
+    auto reach = [&](int index) {
+        if (index < 0 || index >= count || reached[index]) return;
+        reached[index] = true;
+        pending.push_back(index);
+    };
+    reach(0);
+    for (const auto &public_symbol : public_symbols) reach(line_of(public_symbol.first));
+    while ANY(pending) {
+        const int index = pending.back();
+        pending.pop_back();
+        const asm_line &line = lines[index];
+
+        // Um dado leva consigo as palavras seguintes sem rótulo
+        if (!addresses.is_instruction(line.operation)) {
+            if (index + 1 < count && !addresses.is_instruction(lines[index + 1].operation) && !labeled[index + 1]) reach(index + 1);
+            continue;
+        }
+        // Destinos de saltos e dados lidos ou escritos. Um rótulo de código usado como dado também mantém o código
+        for (int operand = 0; operand < 2; operand++) reach(line_of(line.operand[operand]));
+        if (!ends_flow(line.operation)) reach(index + 1);
+    }
+
+    // Contabiliza o que sai, com os valores que as linhas teriam no objeto
+    for (int index = 0; index < count; index++) {
+        if (reached[index]) continue;
+        const asm_line &line = lines[index];
+        const int size = addresses.size_of(line);
+        if (addresses.is_instruction(line.operation)) removed_code += size;
+        else removed_data += size;
+        if (line.span > 1) removed_bytes += 2 * (size_t) line.span;
+        else removed_bytes += to_string(line.opcode).length() + 1;
+        for (int operand = 0; operand < 2; operand++) {
+            auto symbol_entry = symbol_table.find(line.operand[operand]);
+            if (ANY(line.operand[operand]) && symbol_entry != symbol_table.end()) removed_bytes += to_string(symbol_entry->second).length() + 1;
+        }
+    }
+
+    // Rótulos de linhas removidas deixam a tabela, e não aparecem no mapa de símbolos
+    vector<bool> removed(count);
+    for (int index = 0; index < count; index++) removed[index] = !reached[index];
+    for (auto symbol_entry = symbol_table.begin(); symbol_entry != symbol_table.end(); ) {
+        const int index = line_of(symbol_entry->first);
+        if (index != -1 && removed[index]) {
+            removed_labels.push_back(symbol_entry->first);
+            symbol_entry = symbol_table.erase(symbol_entry);
+        }
+        else symbol_entry++;
+    }
+
+    return total - addresses.remove(lines, removed, symbol_table, extern_symbols);
+}
+
+string DeadSymbolStripper::report() {
+    string description = "Remoção de símbolos mortos: " + to_string(removed_code + removed_data) + " palavras removidas ("
+        + to_string(removed_code) + " de código, " + to_string(removed_data) + " de dados), " + to_string(removed_bytes) + " bytes a menos no objeto\n";
+    if ANY(removed_labels) {
+        description += "\tRótulos removidos: ";
+        for (size_t index = 0; index < removed_labels.size() && index < REPORTED_LABELS; index++) {
+            description += (index > 0 ? ", " : "") + removed_labels[index];
+        }
+        if (removed_labels.size() > REPORTED_LABELS) description += " e mais " + to_string(removed_labels.size() - REPORTED_LABELS);
+        description += "\n";
+    }
+    return description;
+}
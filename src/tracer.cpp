@@ -0,0 +1,89 @@
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include "../include/tracer.hpp"
+
+using namespace std;
+
+atomic<bool> Tracer::enabled(false);
+
+namespace {
+    // Instante de referência dos eventos
+    chrono::steady_clock::time_point epoch;
+    // Buffers de todas as threads que já registraram eventos. Só é acessado no registro de uma nova thread e na exportação
+    mutex registry_mutex;
+    vector<unique_ptr<trace_buffer>> registry;
+    // Buffer da thread atual
+    thread_local trace_buffer* thread_buffer = nullptr;
+}
+
+void Tracer::enable() {
+    epoch = chrono::steady_clock::now();
+    enabled.store(true, memory_order_release);
+}
+
+trace_buffer& Tracer::local_buffer() {
+    if (thread_buffer == nullptr) {
+        unique_ptr<trace_buffer> buffer(new trace_buffer());
+        buffer->thread_name = nullptr;
+        buffer->events.resize(TRACE_BUFFER_CAPACITY);
+        buffer->written.store(0, memory_order_relaxed);
+
+        lock_guard<mutex> lock(registry_mutex);
+        buffer->thread_id = (int) registry.size() + 1;
+        thread_buffer = buffer.get();
+        registry.push_back(move(buffer));
+    }
+    return *thread_buffer;
+}
+
+void Tracer::record(const char* name, char phase, int line/* = -1 */) {
+    trace_buffer &buffer = local_buffer();
+    const long long timestamp = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+    const size_t position = buffer.written.load(memory_order_relaxed);
+
+    // Quando cheio, o buffer sobrescreve os eventos mais antigos
+    buffer.events[position % buffer.events.size()] = trace_event {name, phase, timestamp, line};
+    buffer.written.store(position + 1, memory_order_release);
+}
+
+void Tracer::name_thread(const char* name) {
+    if (is_enabled()) local_buffer().thread_name = name;
+}
+
+void Tracer::dump(string path) {
+    if (!is_enabled()) return;
+
+    fstream output(path, fstream::out);
+    if (!output.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo de rastreamento \"" + path + "\"");
+    }
+
+    lock_guard<mutex> lock(registry_mutex);
+    output << "{\"traceEvents\":[";
+    bool first = true;
+    for (const unique_ptr<trace_buffer> &buffer : registry) {
+        // Nome da thread
+        if (buffer->thread_name != nullptr) {
+            output << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"args\":{\"name\":\"" << buffer->thread_name << "\"}}";
+            first = false;
+        }
+
+        const size_t written = buffer->written.load(memory_order_acquire);
+        const size_t capacity = buffer->events.size();
+        // Se o buffer deu a volta, começa pelo evento mais antigo que restou
+        const size_t start = written > capacity ? written - capacity : 0;
+        for (size_t index = start; index < written; index++) {
+            const trace_event &event = buffer->events[index % capacity];
+            output << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << event.timestamp / 1000 << "." << (event.timestamp % 1000) / 100
+                << ",\"pid\":1,\"tid\":" << buffer->thread_id;
+            if (event.line != -1) output << ",\"args\":{\"linha\":" << event.line << "}";
+            output << "}";
+            first = false;
+        }
+    }
+    output << "\n]}\n";
+}
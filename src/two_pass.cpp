@@ -1,7 +1,16 @@
-#include <regex>
+#include <string.h>
 #include <iostream>
+#include <fstream>
 #include "../include/two_pass.hpp"
+#include "../include/file_io.hpp"
 #include "../include/operation_supplier.hpp"
+#include "../include/tracer.hpp"
+#include "../include/peephole.hpp"
+#include "../include/stripper.hpp"
+#include "../include/error_log.hpp"
+#include "../include/diagnostics.hpp"
+#include "../include/alloc_stats.hpp"
+#include "../include/binary_pre.hpp"
 
 using namespace std;
 
@@ -12,10 +21,20 @@ using namespace std;
 #define SECTION_DATA "DATA"
 #define INCORRECT_SECTION "Operação em seção incorreta"
 
-TwoPassAlgorithm::TwoPassAlgorithm(bool verbose/* = false */) : verbose(verbose) {
-    OperationSupplier supplier;
-    instruction_table = supplier.supply_instructions();
-    directive_table = supplier.supply_directives();
+TwoPassAlgorithm::TwoPassAlgorithm(bool verbose/* = false */) : TwoPassAlgorithm(OperationSupplier::supply_shared_tables(), verbose) {}
+
+TwoPassAlgorithm::TwoPassAlgorithm(shared_ptr<const isa_tables> tables, bool verbose/* = false */) :
+    verbose(verbose),
+    tables(tables),
+    instruction_table(tables->instruction_table),
+    directive_table(tables->directive_table),
+    link_directive_table(tables->link_directive_table),
+    analysis(false),
+    optimization(false),
+    stripping(false),
+    max_errors(0),
+    diagnostic_budget(DIAGNOSTIC_BUDGET),
+    symbol_map_enabled(false) {
 
     // for VECTOR_ITERATOR(it, instruction_table) {
     //     cout << it->first << ": " << to_string(it->second[0]) << ", " << to_string(it->second[1]) << endl;
@@ -26,84 +45,355 @@ TwoPassAlgorithm::TwoPassAlgorithm(bool verbose/* = false */) : verbose(verbose)
 }
 
 void TwoPassAlgorithm::assemble(std::string path, bool print/* = false */) {
+    const string output = assemble_object(path, print);
+    // Constroi o arquivo
+    TraceScope trace("write");
+    // O arquivo só é criado depois da montagem, então uma falha não deixa um objeto vazio
+    const string obj_path = replace_extension(path, ".obj");
+    write_output(obj_path, output);
+    write_symbol_map(obj_path);
+}
+
+string TwoPassAlgorithm::assemble_object(string path, bool print/* = false */) {
     // O parâmtero solicita que o scanner levante erros
     Scanner scanner(true);
+    // Agrupa os erros repetidos do escaneamento
+    Diagnostics scan_errors(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    scanner.set_diagnostics(&scan_errors);
     // Coleta os erros lançados
     string error_log = "";
     // Gera a estrutura do programa
-    vector<asm_line> lines = scanner.scan(path, error_log, print);
+    vector<asm_line> lines = read_program(scanner, path, error_log, print);
+    scan_errors.append_to(error_log);
 
     // Levanta erro se receber o tipo errado de arquivo
-    const size_t dot = path.find('.');
-    if (path.substr(dot) != ".pre"s) {
+    if (!is_standard_stream(path) && !has_extension(path, ".pre")) {
         throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .pre para o modo montagem");
     }
+
+    // Monta o programa
+    const string output = assemble_lines(lines, error_log);
+    cerr << warning_log;
+    cout << optimization_report;
+
+    if ANY(error_log) {
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+    }
+    return output;
+}
+
+vector<asm_line> TwoPassAlgorithm::read_program(Scanner &scanner, const string &path, string &error_log, bool print) {
+    if (!BinaryPre::is_binary(path)) return scanner.scan(path, error_log, print);
+
+    // O .pre binário já está separado em linhas, sem erros de escaneamento
+    TraceScope trace("load");
+    vector<asm_line> lines = BinaryPre(path).lines();
+    if (print) {
+        cout << "Estrutura do programa: {" << endl;
+        scanner.print_lines(lines);
+        cout << "}" << endl;
+    }
+    return lines;
+}
+
+void TwoPassAlgorithm::assemble_out_of_core(string path, bool print/* = false */) {
+    // Levanta erro se receber o tipo errado de arquivo
+    if (!has_extension(path, ".pre")) {
+        throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .pre para o modo montagem");
+    }
+    // O .pre binário é lido em lotes direto da região mapeada
+    unique_ptr<BinaryPre> binary;
+    fstream source;
+    if (BinaryPre::is_binary(path)) binary.reset(new BinaryPre(path));
+    else source.open(path);
+    if (!binary && !source.is_open()) {
+        throw MounterException(-1, "null", "Falha ao abrir arquivo \"" + path + "\"");
+    }
     // Define o nome do arquivo sem a extensão
-    const string obj_path = path.substr(0, dot) + ".obj";
+    const string obj_path = replace_extension(path, ".obj");
+    // O código é escrito em um arquivo parcial, que só se torna o objeto se não houver erros
+    const string partial_path = obj_path + ".parcial";
+
+    // O parâmtero solicita que o scanner levante erros
+    Scanner scanner(true);
+    // Agrupa os erros repetidos do escaneamento
+    Diagnostics scan_errors(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    scanner.set_diagnostics(&scan_errors);
+    // Coleta os erros lançados
+    string error_log = "";
+    // Guarda as linhas entre as passagens
+    SpillFile spill;
 
-    // Arquivo a ser construído
-    fstream obj(obj_path, fstream::out);
-    if (!obj.is_open()) {
+    // Escaneamento e primeira passagem, um lote de cada vez
+    reset();
+    begin_first_pass();
+    {
+        TraceScope trace("first_pass");
+        if (print) cout << "Estrutura do programa: {" << endl;
+        vector<asm_line> chunk;
+        chunk.reserve(OUT_OF_CORE_CHUNK);
+        string line;
+        string stray_label;
+        for (size_t first = 0; binary && first < binary->size(); first += OUT_OF_CORE_CHUNK) {
+            binary->read(first, OUT_OF_CORE_CHUNK, chunk);
+            if (print) scanner.print_lines(chunk);
+            spill_lines(chunk, spill, false);
+        }
+        for (int line_number = 1; !binary && getline(source, line); line_number++) {
+            scanner.scan_line(line, line_number, stray_label, chunk, error_log);
+            if (chunk.size() >= OUT_OF_CORE_CHUNK) {
+                if (print) scanner.print_lines(chunk);
+                spill_lines(chunk, spill, false);
+            }
+        }
+        if (print) {
+            scanner.print_lines(chunk);
+            cout << "}" << endl;
+        }
+        spill_lines(chunk, spill, true);
+    }
+    scan_errors.append_to(error_log);
+    source.close();
+    try {
+        end_first_pass();
+    }
+    catch (const Diagnostics &errors) {
+        errors.append_to(error_log);
+    }
+    spill.finish();
+    cerr << warning_log;
+
+    // Segunda passagem, lendo do arquivo temporário e escrevendo o código aos poucos
+    fstream partial(partial_path, fstream::out);
+    if (!partial.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + partial_path + "\"");
+    }
+    {
+        TraceScope trace("second_pass");
+        TraceBatches batches("second_pass: lote");
+        string output = "";
+        Diagnostics exceptions(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+        int address = 0;
+        asm_line expression;
+        while (spill.next(expression)) {
+            batches.step(expression.number);
+            second_pass_line(expression, output, exceptions, address);
+            if (output.length() >= SPILL_BUFFER_SIZE) {
+                partial << output;
+                output.clear();
+            }
+        }
+        partial << output;
+        exceptions.append_to(error_log);
+    }
+    partial.close();
+
+    if ANY(error_log) {
+        // Destroi o arquivo parcial
+        remove(partial_path.c_str());
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
+        );
+    }
+
+    TraceScope trace("write");
+    if ANY(module.name) {
+        // O cabeçalho do módulo só é conhecido ao fim da segunda passagem, então precede uma cópia do código
+        fstream obj(obj_path, fstream::out);
+        fstream code(partial_path, fstream::in);
+        if (!obj.is_open() || !code.is_open()) {
+            throw invalid_argument("Não foi possível criar o arquivo \"" + obj_path + "\"");
+        }
+        obj << module_header() << "T: " << code.rdbuf();
+        code.close();
+        remove(partial_path.c_str());
+    }
+    else if (rename(partial_path.c_str(), obj_path.c_str()) != 0) {
         throw invalid_argument("Não foi possível criar o arquivo \"" + obj_path + "\"");
     }
-    obj.close();
+}
+
+void TwoPassAlgorithm::check(string path, bool print/* = false */) {
+    // Levanta erro se receber o tipo errado de arquivo
+    if (!is_standard_stream(path) && !has_extension(path, ".pre")) {
+        throw invalid_argument("Tipo de arquivo inválido. Por favor, forneça um arquivo .pre para o modo montagem");
+    }
+
+    // O parâmtero solicita que o scanner levante erros
+    Scanner scanner(true);
+    scanner.set_max_errors(max_errors);
+    // Agrupa os erros repetidos do escaneamento
+    Diagnostics scan_errors(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    scanner.set_diagnostics(&scan_errors);
+    // Coleta os erros lançados
+    string error_log = "";
+    // Gera a estrutura do programa
+    vector<asm_line> lines = read_program(scanner, path, error_log, print);
+    scan_errors.append_to(error_log);
+
+    // Se o limite foi atingido no escaneamento, as passagens nem executam
+    if (max_errors == 0 || count_log_entries(error_log) < max_errors) {
+        validate_lines(lines, error_log);
+        cerr << warning_log;
+    }
+
+    if ANY(error_log) {
+        string interruption = "";
+        if (max_errors > 0 && count_log_entries(error_log) >= max_errors) {
+            truncate_log(error_log, max_errors);
+            interruption = "\nVerificação interrompida após " + to_string(max_errors) + (max_errors == 1 ? " erro" : " erros");
+        }
+        throw MounterException(-1, "null",
+            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1) + interruption
+        );
+    }
+}
+
+void TwoPassAlgorithm::validate_lines(vector<asm_line> &lines, string &error_log) {
+    // Descarta o estado de montagens anteriores
+    reset();
 
     // Primeira passagem
     try {
         first_pass(lines);
     }
-    catch (const vector<MounterException> &errors) {
-        // Para cada erro
-        for (const MounterException error : errors) {
-            string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
-            error_log += intro + error.get_type() + ": " + error.what() + "\n";
+    catch (const Diagnostics &errors) {
+        errors.append_to(error_log);
+    }
+
+    // Validação dos operandos, como na segunda passagem
+    TraceScope trace("validate");
+    Diagnostics exceptions(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    const size_t previous_errors = count_log_entries(error_log);
+    for VECTOR_ITERATOR(expression_iterator, lines) {
+        if (max_errors > 0 && previous_errors + exceptions.size() >= max_errors) break;
+        for (int index = 0; index < 2; index++) {
+            if ANY(expression_iterator->operand[index]) find_operand(*expression_iterator, index, exceptions);
         }
     }
+    exceptions.append_to(error_log);
+}
+
+void TwoPassAlgorithm::spill_lines(vector<asm_line> &chunk, SpillFile &spill, bool last) {
+    // A SECTION passa seu rótulo para a linha seguinte, então precisa dela no mesmo lote
+    bool held = !last && ANY(chunk) && chunk.back().operation == "SECTION";
+    asm_line section;
+    if (held) {
+        section = chunk.back();
+        chunk.pop_back();
+    }
+
+    first_pass_lines(chunk);
+    for (const asm_line &line : chunk) spill.append(line);
+    chunk.clear();
+
+    if (held) chunk.push_back(section);
+}
+
+string TwoPassAlgorithm::assemble_lines(vector<asm_line> &lines, string &error_log) {
+    vector<diagnostic> errors;
+    const string output = assemble_lines(lines, errors);
+    append_log(error_log, errors);
+    return output;
+}
+
+string TwoPassAlgorithm::assemble_lines(vector<asm_line> &lines, vector<diagnostic> &errors) {
+    // Descarta o estado de montagens anteriores
+    reset();
+
+    // Primeira passagem
+    try {
+        first_pass(lines);
+    }
+    catch (const Diagnostics &exceptions) {
+        exceptions.append_to(errors);
+    }
+
+    // Otimização, apenas sobre programas válidos. Erros anteriores na lista, como os do escaneamento, também invalidam o programa
+    if (optimization && errors.empty()) {
+        TraceScope trace("optimize");
+        PeepholeOptimizer optimizer(instruction_table);
+        const int saved = optimizer.optimize(lines, symbol_table, module.extern_symbols);
+        optimization_report = "Otimização peephole: " + to_string(saved) + " palavras economizadas\n" + optimizer.report();
+    }
+
+    // Remoção de símbolos mortos, sobre o programa já otimizado
+    if (stripping && errors.empty()) {
+        TraceScope trace("strip");
+        DeadSymbolStripper stripper(instruction_table);
+        stripper.strip(lines, symbol_table, module.public_symbols, module.extern_symbols);
+        optimization_report += stripper.report();
+    }
 
     // Segunda passagem
     string output;
     try {
         output = second_pass(lines);
     }
-    catch (vector<MounterException> &errors) {
-        // Para cada erro
-        for (const MounterException error : errors) {
-            string intro = (error.get_line() == -1 ? "Erro " : "Na linha " + to_string(error.get_line()) + ", erro ");
-            error_log += intro + error.get_type() + ": " + error.what() + "\n";
-        }
+    catch (const Diagnostics &exceptions) {
+        exceptions.append_to(errors);
     }
 
-    if ANY(error_log) {
-        // Destroi o arquivo vazio
-        remove(obj_path.c_str());
-        throw MounterException(-1, "null",
-            string(__FILE__) + ":" + to_string(__LINE__) + "> ERRO:\n" + error_log.substr(0, error_log.length()-1)
-        );
-    }
-    else {
-        // Constroi o arquivo
-        fstream obj(obj_path);
-        if (!obj.is_open()) {
-            throw invalid_argument("Não foi possível abrir o arquivo recém-criado \"" + obj_path + "\"");
-        }
-        obj << output;
+    // Módulos levam o cabeçalho com as informações para o ligador
+    if (ANY(module.name) && errors.empty()) {
+        output = module_header() + "T: " + output;
     }
+    return output;
 }
 
 void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
+    TraceScope trace("first_pass");
+    begin_first_pass();
+    first_pass_lines(lines);
+    end_first_pass();
+}
+
+void TwoPassAlgorithm::reset() {
+    symbol_table.clear();
+    module.name.clear();
+    module.ended = false;
+    module.public_symbols.clear();
+    module.extern_symbols.clear();
+    module.use_table.clear();
+    module.relocation.clear();
+    analyzer.clear();
+    warnings.clear();
+    warning_log.clear();
+    optimization_report.clear();
+    line_addresses.clear();
+}
+
+void TwoPassAlgorithm::begin_first_pass() {
+    analyzer.clear();
+    warnings.clear();
+    warning_log.clear();
+    pass.exceptions = Diagnostics(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    pass.current_section = "null";
+    pass.section_text_present = false;
+    pass.current_line_number = 0;
+}
+
+void TwoPassAlgorithm::first_pass_lines(vector<asm_line> &lines) {
+    // Registra o tempo de cada lote de linhas
+    TraceBatches batches("first_pass: lote");
     // Acho que os rótulos estão recebendo as linhas deslocadas por 1, estão erradas!
-    // Vai armazenar exceções possíveis para lançar um batch ao final da execução
-    vector<MounterException> exceptions;
+    // Vai armazenar exceções possíveis para lançar um batch ao final da primeira passagem
+    Diagnostics &exceptions = pass.exceptions;
 
     // Registra a seção atual
-    string current_section = "null";
+    string &current_section = pass.current_section;
     // Registra se houve alguma seção texto
-    bool section_text_present = false;
+    bool &section_text_present = pass.section_text_present;
     // Ponteiro para a posição do endereço do programa
-    int current_line_number = 0;
+    int &current_line_number = pass.current_line_number;
     // Para cada linha
     for VECTOR_ITERATOR(line_iterator, lines) {
+        // Verificações com limite de erros param assim que ele é atingido
+        if (max_errors > 0 && exceptions.size() >= max_errors) break;
         asm_line &expression = *line_iterator;
+        batches.step(expression.number);
 
         // print_line(expression);
 
@@ -113,7 +403,7 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
 
             // Garante que não seja a última linha
             if (line_iterator + 1 == lines.end()) {
-                exceptions.push_back(MounterException(expression.number, "semântico"s,
+                exceptions.add(MounterException(expression.number, "semântico"s,
                     "Seção no final do documento"s
                 ));
                 break;
@@ -121,20 +411,22 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
             
             // Move seus rótulos para a linha seguinte
             asm_line &next_line = *(line_iterator + 1);
-            if ANY(next_line.label) {
-                exceptions.push_back(MounterException(expression.number, "semântico"s,
-                    "Seção tem rótulo que não pode ser passado para a linha seguinte"s
-                ));
+            if ANY(expression.label) {
+                if ANY(next_line.label) {
+                    exceptions.add(MounterException(expression.number, "semântico"s,
+                        "Seção tem rótulo que não pode ser passado para a linha seguinte"s
+                    ));
+                }
+                next_line.label = expression.label;
+                expression.label = "";
             }
-            next_line.label = expression.label;
-            expression.label = "";
             
             // Valida a seção
             if (new_section == SECTION_TEXT) {
                 section_text_present = true;
             }
             else if (new_section != SECTION_DATA) {
-                exceptions.push_back(MounterException(expression.number, "léxico",
+                exceptions.add(MounterException(expression.number, "léxico",
                     "Seção \"" + new_section + "\" é inválida. As seções válidas são: " + SECTION_TEXT + ", " SECTION_DATA + ""
                 ));
                 lines.erase(line_iterator--);
@@ -148,6 +440,21 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
             continue;
         }
         
+        // Verifica a operação nas diretivas de ligação, que tratam o próprio rótulo
+        auto link_directive_entry = link_directive_table.find(expression.operation);
+        if (link_directive_entry != link_directive_table.end()) {
+            // Executa a diretiva e colhe possíveis exceções
+            try {
+                (*link_directive_entry->second) (line_iterator, this);
+            }
+            catch (const MounterException &error) {
+                exceptions.add(error);
+            }
+            // A diretiva não chega ao código objeto
+            lines.erase(line_iterator--);
+            continue;
+        }
+
         // Se houver rótulo
         if ANY(expression.label) registerLabel(expression, current_line_number, exceptions);
 
@@ -156,7 +463,7 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
         if (instruction_entry != instruction_table.end()) {
             // Certifica de que está na seção correta
             if (current_section != SECTION_TEXT) {
-                exceptions.push_back(MounterException(expression.number, "semântico",
+                exceptions.add(MounterException(expression.number, "semântico",
                     INCORRECT_SECTION
                 ));
             }
@@ -165,12 +472,13 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
             int parameters = (expression.operand[0].empty() ? 0 : 1) + (expression.operand[1].empty() ? 0 : 1);
             int expected_parameteres = instruction_entry->second[1] - 1; // Tamanho da expressão - tamanho da operação
             if (parameters != expected_parameteres) {
-                exceptions.push_back(MounterException(expression.number, "sintático",
+                exceptions.add(MounterException(expression.number, "sintático",
                     "Número de parâmetros incorreto para a operação " + expression.operation
                     + ". Esperado: " + to_string(expected_parameteres) + ", verificado: " + to_string(parameters)
                 ));
             }
 
+            if (analysis) analyzer.add_instruction(expression, current_line_number);
             // Registra o opcde da operação
             expression.opcode = instruction_entry->second[0];
             // Desloca o ponteiro de linha
@@ -184,52 +492,78 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
         if (directive_entry != directive_table.end()) {
             // Certifica de que está na seção correta
             if (current_section != SECTION_DATA) {
-                exceptions.push_back(MounterException(expression.number, "semântico",
+                exceptions.add(MounterException(expression.number, "semântico",
                     INCORRECT_SECTION
                 ));
             }
+            const int data_address = current_line_number;
             // Executa a diretiva e colhe possíveis exceções
             try {
                 (*directive_entry->second) (line_iterator, current_line_number);
             }
             catch (const MounterException &error) {
-                exceptions.push_back(error);
+                exceptions.add(error);
             }
+            if (analysis) analyzer.add_data(expression, data_address);
             // cout << "-> Identificado como diretiva" << endl;
             continue;
         }
 
         // Se a operação não é instrução nem diretiva, ela é inválida
-        exceptions.push_back(MounterException(expression.number, "léxico",
+        exceptions.add(MounterException(expression.number, "léxico",
             "Operação \"" + expression.operation + "\" não identificada"
         ));
         // cout << "-> Identificado como inválido" << endl;
     }
+}
+
+void TwoPassAlgorithm::end_first_pass() {
+    Diagnostics &exceptions = pass.exceptions;
+
+    // Análise de fluxo, agora que a tabela de símbolos está completa
+    if (analysis) {
+        TraceScope trace("analysis");
+        for (const MounterException &warning : analyzer.analyze(symbol_table, pass.current_line_number, module.public_symbols, module.extern_symbols)) {
+            warnings.push_back(diagnostic {warning.get_line(), warning.get_type(), warning.what()});
+        }
+        append_log(warning_log, warnings, "aviso");
+    }
+
+    // Certifica de que o módulo esteja bem formado
+    if ANY(module.name) {
+        if (!module.ended) {
+            exceptions.add(MounterException(-1, "semântico",
+                "Módulo \"" + module.name + "\" não possui diretiva END"
+            ));
+        }
+        for VECTOR_ITERATOR(public_entry, module.public_symbols) {
+            if (!LABEL_ALREADY_DEFINED(public_entry->first) || module.extern_symbols.count(public_entry->first) > 0) {
+                exceptions.add(MounterException(public_entry->second, "semântico",
+                    "Rótulo público \"" + public_entry->first + "\" não é definido no módulo"
+                ));
+            }
+        }
+    }
 
     // Certifica de que haja seção texto
-    if (!section_text_present) {
-        exceptions.push_back(MounterException(-1, "semântico",
+    if (!pass.section_text_present) {
+        // Remove as exeções que apontam operações em seção incorreta
+        exceptions.extract("semântico", INCORRECT_SECTION);
+        exceptions.add(MounterException(-1, "semântico",
             "Seção "s + SECTION_TEXT + " não encontrada"s
         ));
-        // Remove as exeções que apontam operações em seção incorreta
-        for VECTOR_ITERATOR(error_iterator, exceptions) {
-            if (strcmp(error_iterator->what(), INCORRECT_SECTION) == 0) exceptions.erase(error_iterator--);
-        }
     }
     // Reúne os erros de seção incorreta em um só
     else if ANY(exceptions) {
-        const string new_message = "As operações das linhas [";
-        string error_lines = "";
-        // vector<MounterException> filtered_exceptions;
-        for VECTOR_ITERATOR(error_iterator, exceptions) {
-            if (strcmp(error_iterator->what(), INCORRECT_SECTION) == 0) {
-                error_lines += to_string(error_iterator->get_line()) + ", ";
-                exceptions.erase(error_iterator--);
-            }
-        }
-        if ANY(error_lines) {
-            exceptions.push_back(MounterException(-1, "semântico",
-                new_message + error_lines.substr(0, error_lines.length()-2) + "] estão em seção incorreta"
+        const diagnostic_group misplaced = exceptions.extract("semântico", INCORRECT_SECTION);
+        if (misplaced.count > 0) {
+            string error_lines = "";
+            for (const int line : misplaced.lines) error_lines += to_string(line) + ", ";
+            error_lines = error_lines.substr(0, error_lines.length()-2);
+            // Apenas as primeiras linhas são listadas
+            if (misplaced.count > misplaced.lines.size()) error_lines += " e mais " + to_string(misplaced.count - misplaced.lines.size());
+            exceptions.add(MounterException(-1, "semântico",
+                "As operações das linhas [" + error_lines + "] estão em seção incorreta"
             ));
         }
     }
@@ -254,7 +588,8 @@ void TwoPassAlgorithm::first_pass(vector<asm_line> &lines) {
     }
 }
 
-void TwoPassAlgorithm::registerLabel(asm_line &expression, int current_line_number, vector<MounterException> &exceptions) {
+void TwoPassAlgorithm::registerLabel(asm_line &expression, int current_line_number, Diagnostics &exceptions) {
+    ALLOC_SITE("tabela de símbolos");
     // cout << "Tamanho do tabela de símbolos antes: " << symbol_table.size() << endl;
     // cout << "Registrando os seguintes rótulos com o valor " << to_string(current_line_number) << ":";
     // for (const string label : expression.labels) {
@@ -263,19 +598,22 @@ void TwoPassAlgorithm::registerLabel(asm_line &expression, int current_line_numb
     // cout << endl;
     
     string label = expression.label;
-    // Verifica a validez do rótulo
-    if (
-        regex_search(label, regex("[^A-Z0-9_-]")) ||
-        regex_match(label.substr(0,1), regex("[^A-Z_-]"))
-    ) {
-        exceptions.push_back(MounterException(expression.number, "léxico",
+    // Verifica a validez do rótulo: apenas A-Z, 0-9, _ e -, sem começar com dígito
+    bool valid_label = !(label[0] >= '0' && label[0] <= '9');
+    for (const char character : label) {
+        if (!((character >= 'A' && character <= 'Z') || (character >= '0' && character <= '9') || character == '_' || character == '-')) {
+            valid_label = false;
+        }
+    }
+    if (!valid_label) {
+        exceptions.add(MounterException(expression.number, "léxico",
             string("Rótulo \"" + label + "\" é inválido")
         ));
     }
     // Adicionamos à tabela de símbolos, ainda que seja inválido
     // Primeiro verificamos se já tem uma entrada deste rótulo na TS
     if LABEL_ALREADY_DEFINED(label) {
-        exceptions.push_back(MounterException(expression.number, "semântico",
+        exceptions.add(MounterException(expression.number, "semântico",
             string("Redefinição do rótulo \"" + label + "\". Definição anterior na linha " + to_string(symbol_table[label]))
         ));
         // Fica com a última definição, então prosseguimos
@@ -291,67 +629,130 @@ void TwoPassAlgorithm::registerLabel(asm_line &expression, int current_line_numb
 }
 
 string TwoPassAlgorithm::second_pass(vector<asm_line> &expressions) {
+    TraceScope trace("second_pass");
+    // Registra o tempo de cada lote de linhas
+    TraceBatches batches("second_pass: lote");
     string output = "";
     // Coleta todas as exceções
-    vector<MounterException> exceptions;
+    Diagnostics exceptions(DIAGNOSTIC_OCCURRENCES, diagnostic_budget);
+    // Endereço da próxima palavra do código, para as tabelas do ligador
+    int address = 0;
     // Para cada linha
     for VECTOR_ITERATOR(expression_iterator, expressions) {
-        const asm_line expression = *expression_iterator;
-
-        output += to_string(expression.opcode) + " ";
-
-        // Se tiver operando 1
-        string label = expression.operand[0];
-        if (ANY(label)) {
-            auto symbol_entry = symbol_table.find(label);
-            if (symbol_entry == symbol_table.end()) {
-                // Verifica se é um número
-                try {
-                    stoi(label);
-                    // É um número
-                    exceptions.push_back(MounterException(expression.number, "sintático",
-                        "Operação \"" + expression.operation + "\" não aceita operandos imediatos, somente rótulos"
-                    ));
-                }
-                catch (...) {
-                    // Erro indica que não é numero
-                    exceptions.push_back(MounterException(expression.number, "semântico",
-                        "Rótulo \"" + label + "\" indefinido"
-                    ));
-                }
-            }
-            // Adiciona o operando ao codigo
-            else output += to_string(symbol_entry->second) + " ";
-        }
-        // Se tiver operando 2
-        label = expression.operand[1];
-        if (ANY(label)) {
-            auto symbol_entry = symbol_table.find(label);
-            if (symbol_entry == symbol_table.end()) {
-                // Verifica se é um número
-                try {
-                    stoi(label);
-                    // É um número
-                    exceptions.push_back(MounterException(expression.number, "sintático",
-                        "Operação \"" + expression.operation + "\" não aceita operandos imediatos, somente rótulos"
-                    ));
-                }
-                catch (...) {
-                    // Erro indica que não é numero
-                    exceptions.push_back(MounterException(expression.number, "semântico",
-                        "Rótulo \"" + label + "\" indefinido"
-                    ));
-                }
-            }
-            // Adiciona o operando ao codigo
-            else output += to_string(symbol_entry->second) + " ";
-        }
+        batches.step(expression_iterator->number);
+        second_pass_line(*expression_iterator, output, exceptions, address);
     }
     
     if ANY(exceptions) throw exceptions;
     return output;
 }
 
+void TwoPassAlgorithm::second_pass_line(const asm_line &expression, string &output, Diagnostics &exceptions, int &address) {
+    ALLOC_SITE("código gerado (to_string)");
+    if (symbol_map_enabled) line_addresses.push_back(make_pair(address, expression.number));
+    // Blocos de SPACE são preenchidos de uma vez, sem uma string por palavra
+    if (expression.span > 1) {
+        const size_t start = output.length();
+        output.resize(start + 2 * (size_t) expression.span);
+        for (size_t position = start; position < output.length(); position += 2) {
+            output[position] = '0';
+            output[position + 1] = ' ';
+        }
+        // Zeros são absolutos
+        if ANY(module.name) module.relocation.append(expression.span, '0');
+        address += expression.span;
+        return;
+    }
+    output += to_string(expression.opcode) + " ";
+    // Opcodes e valores de diretivas são absolutos
+    if ANY(module.name) module.relocation += '0';
+    address++;
+
+    // Para cada operando
+    for (int index = 0; index < 2; index++) {
+        const string &label = expression.operand[index];
+        if (!ANY(label)) continue;
+
+        // Adiciona o operando ao codigo
+        const int *value = find_operand(expression, index, exceptions);
+        if (value != nullptr) {
+            output += to_string(*value) + " ";
+            if ANY(module.name) relocate_operand(label, address);
+        }
+        address++;
+    }
+}
+
+const int* TwoPassAlgorithm::find_operand(const asm_line &expression, int index, Diagnostics &exceptions) {
+    const string &label = expression.operand[index];
+    auto symbol_entry = symbol_table.find(label);
+    if (symbol_entry != symbol_table.end()) return &symbol_entry->second;
+
+    // Verifica se é um número, pela classificação feita no escaneamento
+    const literal parsed = expression.operand_literal[index];
+    if (parsed.kind == VALID_LITERAL) {
+        exceptions.add(MounterException(expression.number, "sintático",
+            "Operação \"" + expression.operation + "\" não aceita operandos imediatos, somente rótulos"
+        ));
+    }
+    else if (parsed.kind != NOT_LITERAL) {
+        exceptions.add(MounterException(expression.number, "léxico", describe_literal_error(label, parsed)));
+    }
+    else {
+        exceptions.add(MounterException(expression.number, "semântico",
+            "Rótulo \"" + label + "\" indefinido"
+        ));
+    }
+    return nullptr;
+}
+
+void TwoPassAlgorithm::relocate_operand(const string &label, int address) {
+    // Externos vão para a tabela de uso, os demais são relativos
+    if (module.extern_symbols.count(label) > 0) {
+        module.use_table.push_back(make_pair(label, address));
+        module.relocation += '0';
+    }
+    else module.relocation += '1';
+}
+
+string TwoPassAlgorithm::symbol_map() {
+    string map_text = "";
+    for VECTOR_ITERATOR(symbol_entry, symbol_table) {
+        // Símbolos externos não têm endereço neste programa
+        if (module.extern_symbols.count(symbol_entry->first) > 0) continue;
+        map_text += "S: " + symbol_entry->first + " " + to_string(symbol_entry->second) + "\n";
+    }
+    for (const pair<int, int> &line_address : line_addresses) {
+        map_text += "L: " + to_string(line_address.first) + " " + to_string(line_address.second) + "\n";
+    }
+    return map_text;
+}
+
+void TwoPassAlgorithm::write_symbol_map(const string &obj_path) {
+    if (!symbol_map_enabled) return;
+    const string map_path = replace_extension(obj_path, ".map");
+    fstream map_file(map_path, fstream::out);
+    if (!map_file.is_open()) {
+        throw invalid_argument("Não foi possível criar o arquivo \"" + map_path + "\"");
+    }
+    map_file << symbol_map();
+}
+
+string TwoPassAlgorithm::module_header() {
+    string header = "H: " + module.name + "\n";
+    header += "H: " + to_string(module.relocation.length()) + "\n";
+    header += "R: " + module.relocation + "\n";
+    // Tabela de definições
+    for VECTOR_ITERATOR(public_entry, module.public_symbols) {
+        header += "D: " + public_entry->first + " " + to_string(symbol_table[public_entry->first]) + "\n";
+    }
+    // Tabela de uso
+    for VECTOR_ITERATOR(use_entry, module.use_table) {
+        header += "U: " + use_entry->first + " " + to_string(use_entry->second) + "\n";
+    }
+    return header;
+}
+
 void TwoPassAlgorithm::print_line(asm_line expression) {
     cout << "Linha " << expression.number << ": {";
     string output = "";
@@ -360,5 +761,6 @@ void TwoPassAlgorithm::print_line(asm_line expression) {
     if ANY(expression.operation) output += "operation: \"" + expression.operation + "\", ";
     if ANY(expression.operand[0]) output += "operand1: \"" + expression.operand[0] + "\", ";
     if ANY(expression.operand[1]) output += "operand2: \"" + expression.operand[1] + "\", ";
+    if (expression.span > 1) output += "span: " + to_string(expression.span) + ", ";
     cout << output.substr(0, output.length() - 2) << "}" << endl;
 }
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <set>
+#include <algorithm>
+#include <stdexcept>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include "../include/watcher.hpp"
+#include "../include/file_io.hpp"
+#include "../include/operation_supplier.hpp"
+#include "../include/binary_pre.hpp"
+
+using namespace std;
+
+#define INSTRUCTIONS_DIRECTORY "data"
+#define INSTRUCTIONS_FILE "instructions.txt"
+
+Watcher::Watcher(string mode, bool verbose/* = false */) : verbose(verbose), mode(mode), analysis(false), optimization(false), stripping(false) {
+    // O préprocessador não depende do arquivo de instruções
+    if (mode == "-p") preprocesser.reset(new Preprocesser(verbose));
+    else load_tables();
+    if (preprocesser) preprocesser->set_line_cache(&line_cache);
+}
+
+void Watcher::load_tables() {
+    try {
+        OperationSupplier supplier;
+        tables = supplier.supply_tables(supplier.supply_instructions());
+    }
+    catch (exception &error) {
+        // Sem tabelas anteriores não há como montar
+        if (!tables) throw;
+        cerr << "[watch] Arquivo de instruções inválido, mantendo as instruções anteriores:\n" << error.what() << endl;
+        return;
+    }
+    assembler.reset(new TwoPassAlgorithm(tables, verbose));
+    // As linhas já montadas precisam ser montadas de novo com as novas instruções
+    contents.clear();
+}
+
+void Watcher::build(const string &path) {
+    fstream source(path, fstream::in | fstream::binary);
+    if (!source.is_open()) {
+        cerr << "[watch] " << path << ": Falha ao abrir arquivo" << endl;
+        return;
+    }
+    stringstream content;
+    content << source.rdbuf();
+    source.close();
+    const string text = content.str();
+
+    // Salvamentos sem alterações não são recompilados
+    auto content_entry = contents.find(path);
+    if (content_entry != contents.end() && content_entry->second == text) return;
+    contents[path] = text;
+
+    const auto start = chrono::steady_clock::now();
+    string error_log = "";
+    string output;
+    string output_path;
+    if (mode == "-p") {
+        if (!has_extension(path, ".asm")) {
+            cerr << "[watch] " << path << ": Tipo de arquivo inválido. Por favor, forneça um arquivo .asm para o modo pré-processamento" << endl;
+            return;
+        }
+        output_path = replace_extension(path, ".pre");
+        preprocesser->set_source_path(path);
+        output = preprocesser->preprocess_text(text, error_log);
+        for (auto &dependent : dependents) dependent.second.erase(path);
+        for (const auto &dependency : preprocesser->get_dependencies()) dependents[dependency.first].insert(path);
+    }
+    else {
+        if (!has_extension(path, ".pre")) {
+            cerr << "[watch] " << path << ": Tipo de arquivo inválido. Por favor, forneça um arquivo .pre para o modo montagem" << endl;
+            return;
+        }
+        output_path = replace_extension(path, ".obj");
+        vector<asm_line> lines;
+        // O .pre binário já vem separado em linhas
+        if (BinaryPre::is_binary(text.data(), text.length())) {
+            try {
+                lines = BinaryPre(path).lines();
+            }
+            catch (exception &error) {
+                cerr << "[watch] " << path << ": " << error.what() << endl;
+                return;
+            }
+        }
+        else {
+            // O parâmtero solicita que o scanner levante erros
+            Scanner scanner(true);
+            scanner.set_line_cache(&line_cache);
+            istringstream source_stream(text);
+            lines = scanner.scan(source_stream, error_log);
+        }
+        assembler->set_analysis(analysis);
+        assembler->set_optimization(optimization);
+        assembler->set_stripping(stripping);
+        output = assembler->assemble_lines(lines, error_log);
+        cerr << assembler->get_warning_log();
+        cout << assembler->get_optimization_report();
+    }
+
+    if (error_log.empty()) {
+        fstream output_file(output_path, fstream::out);
+        if (!output_file.is_open()) {
+            cerr << "[watch] " << path << ": Não foi possível criar o arquivo \"" << output_path << "\"" << endl;
+            return;
+        }
+        output_file << output;
+        output_file.close();
+    }
+    const double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (error_log.empty()) cout << "[watch] " << path << " -> " << output_path << " (" << elapsed << " ms)" << endl;
+    else cerr << "[watch] " << path << " (" << elapsed << " ms) ERRO:\n" << error_log << flush;
+
+    // Edições longas acumulam linhas que não existem mais
+    if (line_cache.size() > WATCH_CACHE_LIMIT) line_cache.clear();
+}
+
+void Watcher::watch(const vector<string> &paths) {
+    const int notifier = inotify_init1(IN_CLOEXEC);
+    if (notifier == -1) {
+        throw invalid_argument("Não foi possível iniciar a observação de arquivos (inotify)");
+    }
+
+    // Os diretórios são observados, e não os arquivos, pois editores costumam salvar substituindo o arquivo
+    map<int, string> directories;
+    // Arquivos observados, por diretório e nome. Um mesmo arquivo pode ser observado por mais de um caminho
+    map<pair<string, string>, set<string>> watched;
+    auto add_watch = [&](const string &path) {
+        const size_t slash = path.rfind('/');
+        const string relative_directory = (slash == string::npos ? "." : path.substr(0, slash));
+        const string name = (slash == string::npos ? path : path.substr(slash + 1));
+        // O inotify devolve o mesmo descritor para um diretório já observado, então o diretório é identificado pelo caminho canônico
+        char *canonical = realpath(relative_directory.c_str(), nullptr);
+        const string directory = (canonical == nullptr ? relative_directory : string(canonical));
+        free(canonical);
+        const int descriptor = inotify_add_watch(notifier, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (descriptor == -1) {
+            close(notifier);
+            throw invalid_argument("Não foi possível observar o diretório \"" + directory + "\"");
+        }
+        directories[descriptor] = directory;
+        watched[make_pair(directory, name)].insert(path);
+    };
+    for (const string &path : paths) add_watch(path);
+    const string instructions_path = INSTRUCTIONS_DIRECTORY "/" INSTRUCTIONS_FILE;
+    if (mode != "-p") add_watch(instructions_path);
+
+    // Arquivos incluídos já observados
+    set<string> included_watches;
+    auto watch_includes = [&]() {
+        for (const auto &dependent : dependents) {
+            if (included_watches.insert(dependent.first).second) add_watch(dependent.first);
+        }
+    };
+
+    for (const string &path : paths) build(path);
+    watch_includes();
+    cout << "[watch] Observando " << paths.size() << (paths.size() == 1 ? " arquivo" : " arquivos") << ". Ctrl+C para sair." << endl;
+
+    alignas(inotify_event) char buffer[16384];
+    while (true) {
+        // Junta os eventos de um mesmo salvamento, que costuma gerar vários
+        set<string> changed;
+        int timeout = -1;
+        pollfd waiting {notifier, POLLIN, 0};
+        while (poll(&waiting, 1, timeout) > 0) {
+            const ssize_t length = read(notifier, buffer, sizeof(buffer));
+            if (length <= 0) break;
+            for (ssize_t offset = 0; offset < length; ) {
+                const inotify_event *event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0) continue;
+                auto watched_entry = watched.find(make_pair(directories[event->wd], string(event->name)));
+                if (watched_entry != watched.end()) changed.insert(watched_entry->second.begin(), watched_entry->second.end());
+            }
+            timeout = WATCH_SETTLE_TIME;
+        }
+
+        if (changed.count(instructions_path) > 0) {
+            load_tables();
+            changed.erase(instructions_path);
+            // Todos os arquivos dependem das instruções
+            changed.insert(paths.begin(), paths.end());
+        }
+        // Uma alteração em um arquivo incluído recompila os arquivos que o incluem, mesmo que eles não tenham mudado
+        set<string> rebuilt;
+        for (const string &path : changed) {
+            auto dependent_entry = dependents.find(path);
+            if (dependent_entry != dependents.end()) {
+                for (const string &source : dependent_entry->second) {
+                    contents.erase(source);
+                    rebuilt.insert(source);
+                }
+            }
+            if (find(paths.begin(), paths.end(), path) != paths.end()) rebuilt.insert(path);
+        }
+        for (const string &path : rebuilt) build(path);
+        watch_includes();
+    }
+}
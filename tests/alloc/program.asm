@@ -0,0 +1,234 @@
+; Programa de referência para o limite de alocações por linha: rotinas repetidas com EQU, condicionais, laços e dados
+PASSO: EQU 1
+PASSOS: EQU 4
+LIMITE: EQU 8
+DEPURA: EQU 0
+SECTION TEXT
+INICIO: INPUT N0
+ROTINA0: LOAD N0
+ADD UM
+IF DEPURA
+OUTPUT N0
+LACO0: SUB UM
+JMPP LACO0
+COPY N0, M0
+STORE M1
+ROTINA1: LOAD N1
+ADD UM
+IF DEPURA
+OUTPUT N1
+LACO1: SUB UM
+JMPP LACO1
+COPY N1, M1
+STORE M2
+ROTINA2: LOAD N2
+ADD UM
+IF DEPURA
+OUTPUT N2
+LACO2: SUB UM
+JMPP LACO2
+COPY N2, M2
+STORE M3
+ROTINA3: LOAD N3
+ADD UM
+IF DEPURA
+OUTPUT N3
+LACO3: SUB UM
+JMPP LACO3
+COPY N3, M3
+STORE M0
+ROTINA4: LOAD N0
+ADD UM
+IF DEPURA
+OUTPUT N0
+LACO4: SUB UM
+JMPP LACO4
+COPY N0, M0
+STORE M1
+ROTINA5: LOAD N1
+ADD UM
+IF DEPURA
+OUTPUT N1
+LACO5: SUB UM
+JMPP LACO5
+COPY N1, M1
+STORE M2
+IFBLOCK DEPURA
+OUTPUT M1
+ELSE
+MULT DOIS
+ENDIF
+ROTINA6: LOAD N2
+ADD UM
+IF DEPURA
+OUTPUT N2
+LACO6: SUB UM
+JMPP LACO6
+COPY N2, M2
+STORE M3
+ROTINA7: LOAD N3
+ADD UM
+IF DEPURA
+OUTPUT N3
+LACO7: SUB UM
+JMPP LACO7
+COPY N3, M3
+STORE M0
+ROTINA8: LOAD N0
+ADD UM
+IF DEPURA
+OUTPUT N0
+LACO8: SUB UM
+JMPP LACO8
+COPY N0, M0
+STORE M1
+ROTINA9: LOAD N1
+ADD UM
+IF DEPURA
+OUTPUT N1
+LACO9: SUB UM
+JMPP LACO9
+COPY N1, M1
+STORE M2
+ROTINA10: LOAD N2
+ADD UM
+IF DEPURA
+OUTPUT N2
+LACO10: SUB UM
+JMPP LACO10
+COPY N2, M2
+STORE M3
+ROTINA11: LOAD N3
+ADD UM
+IF DEPURA
+OUTPUT N3
+LACO11: SUB UM
+JMPP LACO11
+COPY N3, M3
+STORE M0
+IFBLOCK DEPURA
+OUTPUT M3
+ELSE
+MULT DOIS
+ENDIF
+ROTINA12: LOAD N0
+ADD UM
+IF DEPURA
+OUTPUT N0
+LACO12: SUB UM
+JMPP LACO12
+COPY N0, M0
+STORE M1
+ROTINA13: LOAD N1
+ADD UM
+IF DEPURA
+OUTPUT N1
+LACO13: SUB UM
+JMPP LACO13
+COPY N1, M1
+STORE M2
+ROTINA14: LOAD N2
+ADD UM
+IF DEPURA
+OUTPUT N2
+LACO14: SUB UM
+JMPP LACO14
+COPY N2, M2
+STORE M3
+ROTINA15: LOAD N3
+ADD UM
+IF DEPURA
+OUTPUT N3
+LACO15: SUB UM
+JMPP LACO15
+COPY N3, M3
+STORE M0
+ROTINA16: LOAD N0
+ADD UM
+IF DEPURA
+OUTPUT N0
+LACO16: SUB UM
+JMPP LACO16
+COPY N0, M0
+STORE M1
+ROTINA17: LOAD N1
+ADD UM
+IF DEPURA
+OUTPUT N1
+LACO17: SUB UM
+JMPP LACO17
+COPY N1, M1
+STORE M2
+IFBLOCK DEPURA
+OUTPUT M1
+ELSE
+MULT DOIS
+ENDIF
+ROTINA18: LOAD N2
+ADD UM
+IF DEPURA
+OUTPUT N2
+LACO18: SUB UM
+JMPP LACO18
+COPY N2, M2
+STORE M3
+ROTINA19: LOAD N3
+ADD UM
+IF DEPURA
+OUTPUT N3
+LACO19: SUB UM
+JMPP LACO19
+COPY N3, M3
+STORE M0
+ROTINA20: LOAD N0
+ADD UM
+IF DEPURA
+OUTPUT N0
+LACO20: SUB UM
+JMPP LACO20
+COPY N0, M0
+STORE M1
+ROTINA21: LOAD N1
+ADD UM
+IF DEPURA
+OUTPUT N1
+LACO21: SUB UM
+JMPP LACO21
+COPY N1, M1
+STORE M2
+ROTINA22: LOAD N2
+ADD UM
+IF DEPURA
+OUTPUT N2
+LACO22: SUB UM
+JMPP LACO22
+COPY N2, M2
+STORE M3
+ROTINA23: LOAD N3
+ADD UM
+IF DEPURA
+OUTPUT N3
+LACO23: SUB UM
+JMPP LACO23
+COPY N3, M3
+STORE M0
+IFBLOCK DEPURA
+OUTPUT M3
+ELSE
+MULT DOIS
+ENDIF
+OUTPUT M0
+STOP
+SECTION DATA
+N0: SPACE
+N1: SPACE
+N2: SPACE
+N3: SPACE
+M0: SPACE
+M1: SPACE
+M2: SPACE
+M3: SPACE
+UM: CONST 1
+DOIS: CONST 2
+MAXIMO: CONST LIMITE
+VEZES: SPACE PASSOS
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Gera um .obj ligado para medir o leitor. Uso: tests/bench/make_object.sh <arquivo> <palavras>
+# O programa é um STOP seguido de dados: zeros como em seções SPACE, opcodes e endereços pequenos, constantes de até 5 dígitos e algumas negativas
+# A semente é fixa, então a mesma quantidade de palavras gera sempre o mesmo arquivo
+
+if [ $# -ne 2 ]; then
+    echo "Uso: $0 <arquivo> <palavras>" >&2
+    exit 2
+fi
+awk -v words="$2" 'BEGIN {
+    srand(1)
+    printf "14"
+    for (word = 1; word < words; word++) {
+        kind = int(rand() * 16)
+        if (kind < 4) value = 0
+        else if (kind < 8) value = int(rand() * 20)
+        else if (kind < 15) value = int(rand() * 100000)
+        else value = -int(rand() * 100000)
+        printf " %d", value
+    }
+    printf "\n"
+}' > "$1"
@@ -0,0 +1,84 @@
+// Medida de vazão do ObjectReader, executada por tests/bench/run.sh a partir da raiz do repositório
+// Uso: object_reader <arquivo .obj> <repetições>
+// Mede a conversão em memória (parse_words) e a leitura completa do arquivo (read: mapeamento, conversão e validação),
+// e compara as duas com a leitura palavra a palavra por iostream, que é também a referência de vazão
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include "../../include/object_reader.hpp"
+#include "../../include/operation_supplier.hpp"
+
+using namespace std;
+
+namespace {
+    // Melhor tempo, em segundos, entre as repetições
+    double best_time(int rounds, const function<void()> &run) {
+        double best = 0;
+        for (int round = 0; round < rounds; round++) {
+            const auto start = chrono::steady_clock::now();
+            run();
+            const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (round == 0 || elapsed < best) best = elapsed;
+        }
+        return best;
+    }
+
+    void report(const string &name, size_t bytes, size_t words, double seconds) {
+        cout << left << setw(12) << name << right << fixed << setprecision(3) << setw(9) << seconds * 1000 << " ms "
+            << setprecision(2) << setw(7) << bytes / seconds / 1e9 << " GB/s " << setw(7) << seconds * 1e9 / words << " ns/palavra" << endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        cerr << "Uso: " << argv[0] << " <arquivo .obj> <repetições>" << endl;
+        return 2;
+    }
+    const string path = argv[1];
+    const int rounds = stoi(argv[2]);
+    try {
+        ifstream source(path, ios::binary);
+        if (!source) throw invalid_argument("Falha ao abrir arquivo \"" + path + "\"");
+        const string text((istreambuf_iterator<char>(source)), istreambuf_iterator<char>());
+
+        vector<int> reference;
+        const double stream_time = best_time(rounds, [&]() {
+            reference.clear();
+            istringstream words(text);
+            int word;
+            while (words >> word) reference.push_back(word);
+        });
+
+        vector<int> parsed;
+        parsed.reserve(text.length() / 3 + 1);
+        const double parse_time = best_time(rounds, [&]() {
+            parsed.clear();
+            ObjectReader::parse_words(text.data(), text.data() + text.length(), parsed);
+        });
+
+        ObjectReader reader(OperationSupplier::supply_shared_tables());
+        vector<int> image;
+        const double read_time = best_time(rounds, [&]() {
+            image = reader.read(path);
+        });
+
+        if (parsed != reference || image != reference) {
+            cerr << "ERRO: a imagem lida difere da leitura por iostream" << endl;
+            return 1;
+        }
+        cout << path << ": " << text.length() << " bytes, " << reference.size() << " palavras, melhor de " << rounds << " repetições" << endl;
+        report("iostream", text.length(), reference.size(), stream_time);
+        report("parse_words", text.length(), reference.size(), parse_time);
+        report("read", text.length(), reference.size(), read_time);
+    }
+    catch (exception &error) {
+        cerr << __FILE__ << ":" << __LINE__ << "> ERRO:\n" << error.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/sh
+# Medida de vazão do leitor de .obj. Uso, a partir da raiz do repositório: tests/bench/run.sh [palavras] [repetições]
+# Compila tests/bench/object_reader.cpp com as fontes do montador, gera a entrada com tests/bench/make_object.sh e imprime a vazão
+# O compilador vem de CXX, g++ por padrão. Termina com código 1 se a leitura divergir da leitura por iostream
+
+words=${1:-5000000}
+rounds=${2:-5}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+${CXX:-g++} -std=c++17 -O2 -pthread -o "$work/object_reader" tests/bench/object_reader.cpp src/*.cpp || exit 1
+sh tests/bench/make_object.sh "$work/bench.obj" "$words" || exit 1
+"$work/object_reader" "$work/bench.obj" "$rounds"
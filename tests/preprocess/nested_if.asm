@@ -0,0 +1,28 @@
+; IF de uma linha dentro de blocos: ele afeta apenas a linha seguinte, e o ENDIF fecha o IFBLOCK
+T: EQU 1
+F: EQU 0
+SECTION TEXT
+IFBLOCK T
+IF F
+OUTPUT X
+OUTPUT Y
+ENDIF
+IFBLOCK F
+OUTPUT Z
+IF T
+OUTPUT W
+ELSE
+IFBLOCK T
+OUTPUT V
+ENDIF
+ENDIF
+IF T
+OUTPUT U
+STOP
+SECTION DATA
+X: CONST 1
+Y: CONST 2
+Z: CONST 3
+W: CONST 4
+V: CONST 5
+U: CONST 6
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Testes de regressão do montador. Uso, a partir da raiz do repositório: tests/run.sh <executável do montador>
+# Cada tests/preprocess/NOME.asm é préprocessado, com e sem --pipeline, e comparado com tests/preprocess/NOME.expected.pre
+# tests/alloc/program.asm é préprocessado e montado com --alloc-budget; o caso falha se o montador terminar com código diferente de 0
+# Termina com código 1 se algum caso falhar
+
+assembler=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+if [ ! -x "$assembler" ]; then
+    echo "Uso: $0 <executável do montador>" >&2
+    exit 2
+fi
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+fail() {
+    echo "FALHOU: $1" >&2
+    failures=$((failures + 1))
+}
+
+for source in tests/preprocess/*.asm; do
+    name=$(basename "$source" .asm)
+    for option in "" --pipeline; do
+        rm -f "$work/$name.asm" "$work/$name.pre"
+        cp "$source" "$work/$name.asm"
+        "$assembler" -p "$work/$name.asm" $option > "$work/saida.txt" 2>&1
+        if [ ! -f "$work/$name.pre" ]; then
+            fail "$source $option: .pre não gerado"
+            cat "$work/saida.txt" >&2
+        elif ! diff -u "tests/preprocess/$name.expected.pre" "$work/$name.pre" >&2; then
+            fail "$source $option: .pre diferente do esperado"
+        fi
+    done
+done
+
+# Limites de alocações por linha do fonte, com folga de cerca de 25% sobre o medido (-p: 1604, -o: 1286)
+cp tests/alloc/program.asm "$work/program.asm"
+for step in "-p program.asm 2000" "-o program.pre 1600"; do
+    set -- $step
+    if ! "$assembler" "$1" "$work/$2" --alloc-budget "$3" > "$work/saida.txt" 2>&1; then
+        fail "tests/alloc/program.asm $1 --alloc-budget $3"
+        cat "$work/saida.txt" >&2
+    fi
+done
+
+if [ "$failures" -gt 0 ]; then
+    echo "$failures casos falharam" >&2
+    exit 1
+fi
+echo "OK"